@@ -11,6 +11,19 @@
 #define ANSI_COLOR_RED "\x1b[31m"
 #define ANSI_COLOR_RESET "\x1b[0m"  
 
+/* Represents where the compilation reads the lines of the am file from */
+struct am_line_source {
+    FILE *am_file; /* The am file, the lines are read and lexed from it when there is no other source */
+    struct line_ring *lexed_lines; /* The lexed lines of the pipeline, or NULL */
+    struct lexed_line *current_line; /* The slot of the line of the pipeline that was read last, NULL at first */
+    struct lexed_file *lexed_file; /* The lines that were lexed in parallel, or NULL */
+    size_t next_line_of_file; /* The index of the next line of the lexed file */
+    char line_buffer[MAX_LENGTH_OF_LINE + 1]; /* The buffer the line is read in to from the am file */
+};
+
+/* The number of warnings and errors the compilation printed, for the counter of the trace */
+static long amount_of_diagnostics = 0;
+
 /*
  * This function prints a warning message with formatted output.
  * It includes the file name, line number, and the provided formatted message.
@@ -22,6 +35,7 @@
  */
 static void warning_fmt(const char * name_of_file,int number_of_line, const char * fmt,...){
     va_list vl;
+    amount_of_diagnostics++;
     va_start(vl,fmt);
     printf("%s:%d: " ANSI_COLOR_YELLOW "warning: " ANSI_COLOR_RESET,name_of_file, number_of_line);
     vprintf(fmt,vl);
@@ -40,6 +54,7 @@ static void warning_fmt(const char * name_of_file,int number_of_line, const char
  */
 static void error_fmt(const char * name_of_file,int number_of_line, const char * fmt,...){
     va_list vl;
+    amount_of_diagnostics++;
     va_start(vl,fmt);
     printf("%s:%d: " ANSI_COLOR_RED "error: " ANSI_COLOR_RESET, name_of_file,number_of_line);
     vprintf(fmt,vl);
@@ -47,106 +62,160 @@ static void error_fmt(const char * name_of_file,int number_of_line, const char *
     va_end(vl);
 }
 
+/*
+ * Inserts a symbol in to the symbol table of an object file and records it as the symbol of its id.
+ *
+ * @param object A pointer to the object_file structure.
+ * @param symbol A pointer to the symbol, it is copied in to the symbol table.
+ */
+static void insert_symbol_in_to_table(struct object_file *object, struct symbol *symbol) {
+    SymbolNode *new_node = insert_symbol_to_linked_list(&(object->table_of_symbols), symbol);
+
+    if (new_node != NULL) {
+        set_symbol_of_id(&object->interned_symbols, new_node->symbol_data);
+    }
+}
+
 /*
  * Handles the processing of instructions.
  *
- * This function generates machine words for instructions found in the AST,
- * updates the relevant data structures in the object_file, handles symbol definitions
- * and warnings, generates errors when appropriate, and processes labels as operands.
- * It also identifies and handles missing symbols that were not defined but referenced.
+ * This function adds the instruction found in the AST to the instructions of the object_file,
+ * and moves the IC past its words. The number of words comes from the encoding table, and the
+ * words themselves are encoded by encode_instructions once the whole file was read.
  *
  * @param ast The Abstract Syntax Tree for the current line.
  * @param object A pointer to the object_file structure containing symbol and address information.
  * @param number_of_the_line The current line number in the am file.
+ * @return 1 if the instruction was added, 0 on memory allocation error.
+ */
+int process_ast_instruction(mmn14_ast ast, struct object_file *object, int number_of_the_line) {
+    if (!add_instruction_to_ir(&object->instructions, &ast, number_of_the_line, object->IC)) {
+        return 0;
+    }
+    object->IC += words_of_line(&ast);
+    return 1;
+}
+
+/*
+ * Checks that the labels the instructions of the object_file use are defined, without encoding them.
+ *
+ * A label that is not defined, or was only declared as an entry, is added to the list of missing symbols
+ * in the order of the instructions, so handle_missing_symbols reports it like it does when the file is assembled.
+ *
+ * @param object A pointer to the object_file structure.
  * @param were_to_fill_in_symbol_table A pointer to the list of missing symbols.
- * @param find_symbol A pointer to a symbol structure for symbol search.
- * @param local_symbol A pointer to a local symbol structure for creating new symbols.
  */
-void process_ast_instruction(mmn14_ast ast, struct object_file *object, int number_of_the_line, SymbolsNotFoundLinkedList **were_to_fill_in_symbol_table, struct symbol **find_symbol, struct symbol *local_symbol) {
-    unsigned int machine_word = 0;
-    int i = 0;
-    struct symbols_that_were_not_found_at_first symbol_not_found = {0};  
-    unsigned int extern_address = 0;
-    unsigned int current_machine_word_that_inserted = 0;
-    
-    /* Generate the machine word */
-    machine_word = ast.directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_operand_opt[1] << 2;
-    machine_word |= ast.directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_operand_opt[0] << 9;
-    machine_word |= ast.directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_opt << 5;
-    /* Store the generated machine word in the code image at the current IC */
-    object->code_image[object->IC].code_word = machine_word;
-    object->IC++; 
-    
-    /* Handle specific instruction types that have one or two operands */
-    if (ast.directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_opt <= mmn14_ast_instruction_jsr && ast.directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_opt >= mmn14_ast_instruction_mov) {
-        if (ast.directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_operand_opt[1] == mmn14_ast_operand_opt_operand_register && ast.directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_operand_opt[0] == mmn14_ast_operand_opt_operand_register) {
-            /* Handle the case if both operands are registers */
-            machine_word = ast.directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_operands[1].register_number << 2;
-            machine_word |= ast.directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_operands[0].register_number << 7;
-            object->code_image[object->IC].code_word = machine_word;
-            object->IC++; 
-        } else {
-            
-            for (i = 0; i < 2; i++) {
-                switch (ast.directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_operand_opt[i]) {
-                    case mmn14_ast_operand_opt_constant_number:
-                        /* Handle the case that the operand is a constant number */
-                        machine_word = ast.directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_operands[i].constent_number << 2;
-                        object->code_image[object->IC].code_word = machine_word;
-                        object->IC++; 
-                        break;
-                    case mmn14_ast_operand_opt_operand_register:
-                        /* Handle the case that the operand is a register */
-                        machine_word = ast.directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_operands[i].register_number << (7 - (i * 5));
-                        object->code_image[object->IC].code_word = machine_word;
-                        object->IC++; 
-                        break;
-                    case mmn14_ast_operand_opt_operand_label:
-                        /* Handle the case that the operand is a label */
-                        *find_symbol = find_symbol_in_linked_list((object->table_of_symbols), ast.directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_operands[i].label);
-                        /* Checks if the symbol was found or is of type 'symbol_entry' */
-                        if (*find_symbol && ((*find_symbol)->type_of_symbol != symbol_entry)) {
-                            /* Extract address from symbol and shift left by 2 bits */
-                            machine_word = (*find_symbol)->address_of_symbol << 2;
-                            if ((*find_symbol)->type_of_symbol == symbol_extern) {
-                                /* If the type of symbol is extern */
-                                /* Set the least significant bit to 1 if symbol is external */
-                                machine_word |= 1;
-                                extern_address = object->IC + BEGINNING_ADDRESS;
-                                /* Add external symbol to the list of externals */
-                                add_external_symbol(&(object->name_and_addresses_certain_extern), (*find_symbol)->name_of_symbol, extern_address);
-                            } else {
-                                /* Set the second least significant bit to 1 if symbol is internal */
-                                machine_word |= 2;
-                            }
-                        }
-                        object->code_image[object->IC].code_word = machine_word;
-                        
-                        current_machine_word_that_inserted = object->code_image[object->IC].code_word;  
-                        object->IC++; 
-                        /* Check if the symbol was not found or if the symbol type is 'symbol_entry' */
-                        if (!*find_symbol || (*find_symbol && (*find_symbol)->type_of_symbol == symbol_entry)) {
-                            strcpy(symbol_not_found.name_of_symble, ast.directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_operands[i].label);
-                            /* Save the current machine word that was being inserted */
-                            symbol_not_found.machine_word = current_machine_word_that_inserted;
-                            /* Save the number of the line where the symbol was called */
-                            symbol_not_found.line_it_was_called = number_of_the_line;
-                            /* Calculate the address */
-                            symbol_not_found.address_of_calling = object->IC + BEGINNING_ADDRESS + 1;
-                            /* Insert the symbol_not_found in to the linked list */
-                            insert_symbol_not_found_to_linked_list(were_to_fill_in_symbol_table, &symbol_not_found);
+static void check_instructions(struct object_file *object, SymbolsNotFoundLinkedList **were_to_fill_in_symbol_table) {
+    const struct instruction_ir *ir = &object->instructions;
+    struct symbols_that_were_not_found_at_first symbol_not_found = {0};
+    struct symbol *find_symbol;
+    size_t index;
+    int i;
+
+    for (index = 0; index < ir->amount_of_instructions; index++) {
+        for (i = 0; i < 2; i++) {
+            if (ir->operand_modes[i][index] != mmn14_ast_operand_opt_operand_label) {
+                continue;
+            }
+            find_symbol = find_symbol_by_id(&object->interned_symbols, ir->operand_ids[i][index]);
+            if (find_symbol == NULL || find_symbol->type_of_symbol == symbol_entry) {
+                symbol_not_found.id_of_symbol = ir->operand_ids[i][index];
+                symbol_not_found.line_it_was_called = ir->lines[index];
+                insert_symbol_not_found_to_linked_list(were_to_fill_in_symbol_table, &symbol_not_found);
+            }
+        }
+    }
+}
+
+/*
+ * Encodes the instructions of the object_file in to its code image.
+ *
+ * Every instruction takes its first word from the encoding table and the bits of its operands are added
+ * to the words of the operands. Labels that have their final address are encoded right away, the others
+ * are added to the list of missing symbols in the order of the instructions, and filled in later.
+ *
+ * @param object A pointer to the object_file structure.
+ * @param were_to_fill_in_symbol_table A pointer to the list of missing symbols.
+ */
+static void encode_instructions(struct object_file *object, SymbolsNotFoundLinkedList **were_to_fill_in_symbol_table) {
+    const struct instruction_ir *ir = &object->instructions;
+    const struct instruction_encoding *encoding;
+    struct symbols_that_were_not_found_at_first symbol_not_found = {0};
+    struct symbol *find_symbol;
+    unsigned int machine_word;
+    int symbol_is_final;
+    code_w *operand_word;
+    long address_of_word;
+    size_t index;
+    int i;
+
+    for (index = 0; index < ir->amount_of_instructions; index++) {
+        encoding = encoding_of_instruction(ir->opcodes[index], ir->operand_modes[0][index], ir->operand_modes[1][index]);
+        /* The first word comes from the table, the words of the operands start empty */
+        object->code_image[ir->addresses[index]].code_word = encoding->first_word;
+        for (i = 1; i < encoding->amount_of_words; i++) {
+            object->code_image[ir->addresses[index] + i].code_word = 0;
+        }
+        /* Add the bits of every operand to its word, two registers share the same word */
+        for (i = 0; i < 2; i++) {
+            if (encoding->word_of_operand[i] == 0) {
+                /* The operand has no word, or there is no operand */
+                continue;
+            }
+            address_of_word = ir->addresses[index] + encoding->word_of_operand[i];
+            operand_word = &object->code_image[address_of_word];
+            switch (ir->operand_modes[i][index]) {
+                case mmn14_ast_operand_opt_constant_number:
+                    /* Handle the case that the operand is a constant number */
+                    machine_word = ir->operand_values[i][index] << 2;
+                    operand_word->code_word |= machine_word;
+                    break;
+                case mmn14_ast_operand_opt_operand_register:
+                    /* Handle the case that the operand is a register */
+                    machine_word = ir->operand_values[i][index] << (7 - (i * 5));
+                    operand_word->code_word |= machine_word;
+                    break;
+                case mmn14_ast_operand_opt_operand_label:
+                    /* Handle the case that the operand is a label */
+                    find_symbol = find_symbol_by_id(&object->interned_symbols, ir->operand_ids[i][index]);
+                    /* Data symbols get their final address only after the code image is done, so they are filled in later like missing symbols */
+                    symbol_is_final = find_symbol && find_symbol->type_of_symbol != symbol_entry &&
+                                      find_symbol->type_of_symbol != symbol_data && find_symbol->type_of_symbol != symbol_entry_data;
+                    /* Checks if the symbol was found and has its final address */
+                    if (symbol_is_final) {
+                        /* Extract address from symbol and shift left by 2 bits */
+                        machine_word = find_symbol->address_of_symbol << 2;
+                        if (find_symbol->type_of_symbol == symbol_extern) {
+                            /* Set the least significant bit to 1 if symbol is external */
+                            machine_word |= 1;
+                            /* Add external symbol to the list of externals */
+                            add_external_symbol(&(object->extern_uses), find_symbol->id_of_symbol, address_of_word + BEGINNING_ADDRESS);
+                        } else {
+                            /* Set the second least significant bit to 1 if symbol is internal */
+                            machine_word |= 2;
+                            /* The word changes when the code is loaded at another address */
+                            add_relocation(&(object->relocations), address_of_word);
                         }
-                        break;
-                    case mmn14_ast_operand_opt_no_operand:
-                        /* This handles the case that theres no operand */
-                        break;
-                }
+                        operand_word->code_word |= machine_word;
+                    } else {
+                        /* Leave the word empty until the symbol is defined */
+                        symbol_not_found.id_of_symbol = ir->operand_ids[i][index];
+                        /* Save the machine word that was left for the symbol */
+                        symbol_not_found.machine_word = operand_word->code_word;
+                        /* Save the number of the line where the symbol was called */
+                        symbol_not_found.line_it_was_called = ir->lines[index];
+                        /* Save the address of the word that was left for the symbol */
+                        symbol_not_found.address_of_calling = address_of_word + BEGINNING_ADDRESS;
+                        /* Insert the symbol_not_found in to the linked list */
+                        insert_symbol_not_found_to_linked_list(were_to_fill_in_symbol_table, &symbol_not_found);
+                    }
+                    break;
+                default:
+                    /* This handles the case that theres no operand */
+                    break;
             }
         }
-    } else {
-       /* No change needed for mmn14_ast_instruction_rts or mmn14_ast_instruction_stop */
     }
-    
 }
 
 /* Handles the processing of directives within the Abstract Syntax Tree (AST).
@@ -184,6 +253,12 @@ void process_ast_directive(mmn14_ast ast, struct object_file *object, const char
     case mmn14_ast_directive_string:
         /* Handle .string directive */
         str = ast.directive_or_instruction.mmn14_ast_directive.directive_operand.string;
+        if (options_of_assembler.check_level)
+        {
+            /* Only the size of the string matters when the file is checked */
+            object->DC += strlen(str) + 1;
+            break;
+        }
         for (i = 0; str[i] != '\0'; i++)
         {
             machine_word = str[i];
@@ -200,7 +275,11 @@ void process_ast_directive(mmn14_ast ast, struct object_file *object, const char
         (object->DC)++;
         break;
     case mmn14_ast_directive_data:
-        
+        if (options_of_assembler.check_level)
+        {
+            object->DC += ast.directive_or_instruction.mmn14_ast_directive.directive_operand.data.num_of_numbers;
+            break;
+        }
         for (i = 0; i < ast.directive_or_instruction.mmn14_ast_directive.directive_operand.data.num_of_numbers; i++)
         {
             object->data_image[object->DC].data_word = ast.directive_or_instruction.mmn14_ast_directive.directive_operand.data.data[i];
@@ -209,7 +288,7 @@ void process_ast_directive(mmn14_ast ast, struct object_file *object, const char
         break;
     case mmn14_ast_directive_extern:  case mmn14_ast_directive_entry:
          /* Handle .extern and .entry directives */
-        *find_symbol = find_symbol_in_linked_list(object->table_of_symbols, ast.directive_or_instruction.mmn14_ast_directive.directive_operand.name_of_label);
+        *find_symbol = find_symbol_by_id(&object->interned_symbols, ast.directive_or_instruction.mmn14_ast_directive.id_of_operand_label);
         /* Check if the symbol is found in the symbol table */
         if ((*find_symbol))
         {
@@ -220,10 +299,10 @@ void process_ast_directive(mmn14_ast ast, struct object_file *object, const char
                 if ((*find_symbol)->type_of_symbol == symbol_entry || (*find_symbol)->type_of_symbol == symbol_entry_code || (*find_symbol)->type_of_symbol == symbol_entry_data)
                 {
                     /* Generate a warning if the symbol is already defined as an entry symbol */
-                    warning_fmt(name_of_am_file, number_of_the_line, "The label '%s': '%s' was defined already in line: '%d'.", (*find_symbol)->name_of_symbol, string_type_of_symbol[(*find_symbol)->type_of_symbol], (*find_symbol)->line_of_declaration);
+                    warning_fmt(name_of_am_file, number_of_the_line, "The label '%s': '%s' was defined already in line: '%d'.", name_of_symbol_id(&object->interned_symbols, (*find_symbol)->id_of_symbol), string_type_of_symbol[(*find_symbol)->type_of_symbol], (*find_symbol)->line_of_declaration);
                 }else if((*find_symbol)->type_of_symbol == symbol_extern){
                     /* Generate an error if the symbol is defined as extern and attempted to be redefined as entry */
-                    error_fmt(name_of_am_file, number_of_the_line, "The label '%s': '%s' was defined already in line: '%d'.", (*find_symbol)->name_of_symbol, string_type_of_symbol[(*find_symbol)->type_of_symbol], (*find_symbol)->line_of_declaration);
+                    error_fmt(name_of_am_file, number_of_the_line, "The label '%s': '%s' was defined already in line: '%d'.", name_of_symbol_id(&object->interned_symbols, (*find_symbol)->id_of_symbol), string_type_of_symbol[(*find_symbol)->type_of_symbol], (*find_symbol)->line_of_declaration);
 
                 }else{ /* In this case its symbol_code or symbol_data */
                     /* Change the symbol type to entry_code or entry_data based on its current type (symbol_code or symbol_data) */
@@ -233,10 +312,10 @@ void process_ast_directive(mmn14_ast ast, struct object_file *object, const char
                     /* Handle .extern directive */
                     if((*find_symbol)->type_of_symbol == symbol_extern){
                         /* Generate a warning if the symbol is already defined as an extern symbol */
-                        warning_fmt(name_of_am_file, number_of_the_line, "The label '%s': '%s' was defined already in line: '%d'.", (*find_symbol)->name_of_symbol, string_type_of_symbol[(*find_symbol)->type_of_symbol], (*find_symbol)->line_of_declaration);
+                        warning_fmt(name_of_am_file, number_of_the_line, "The label '%s': '%s' was defined already in line: '%d'.", name_of_symbol_id(&object->interned_symbols, (*find_symbol)->id_of_symbol), string_type_of_symbol[(*find_symbol)->type_of_symbol], (*find_symbol)->line_of_declaration);
                     }else{
                        /* Generate an error if the symbol is already defined and not as an extern symbol */
-                       error_fmt(name_of_am_file, number_of_the_line, "The label '%s': '%s' was defined already in line: '%d'.", (*find_symbol)->name_of_symbol, string_type_of_symbol[(*find_symbol)->type_of_symbol], (*find_symbol)->line_of_declaration);
+                       error_fmt(name_of_am_file, number_of_the_line, "The label '%s': '%s' was defined already in line: '%d'.", name_of_symbol_id(&object->interned_symbols, (*find_symbol)->id_of_symbol), string_type_of_symbol[(*find_symbol)->type_of_symbol], (*find_symbol)->line_of_declaration);
 
                     }
             }
@@ -245,15 +324,15 @@ void process_ast_directive(mmn14_ast ast, struct object_file *object, const char
         {
             /* Handle the case when the symbol is not found in the symbol table */
 
-            /* Copy the name of the symbol */
-            strcpy(local_symbol->name_of_symbol, ast.directive_or_instruction.mmn14_ast_directive.directive_operand.name_of_label);
+            /* Set the id of the name of the symbol */
+            local_symbol->id_of_symbol = ast.directive_or_instruction.mmn14_ast_directive.id_of_operand_label;
             /* Set the type of the symbol based on the directive option */
             local_symbol->type_of_symbol = ast.directive_or_instruction.mmn14_ast_directive.mmn14_ast_directive_opt;
             local_symbol->address_of_symbol = 0; 
             /* Save the line number where the symbol is declared */
             local_symbol->line_of_declaration = number_of_the_line;
             /* Insert the new created symbol in to the symbol table */
-            insert_symbol_to_linked_list(&(object->table_of_symbols), local_symbol);
+            insert_symbol_in_to_table(object, local_symbol);
 
            
         }
@@ -278,7 +357,13 @@ void process_ast_directive(mmn14_ast ast, struct object_file *object, const char
 void handle_symbol_table_process(SymbolLinkedList *table_of_symbols, struct object_file *object, const char *name_of_am_file, int *error_d) {
     size_t index;
     struct symbol *current_symbol;
-    SymbolNode *current_node = table_of_symbols->head; /* Start at the head of the symbol table */
+    SymbolNode *current_node;
+
+    /* Checks if the file has no symbols at all */
+    if (table_of_symbols == NULL) {
+        return;
+    }
+    current_node = table_of_symbols->head; /* Start at the head of the symbol table */
 
     /* Iterate through the symbol table */
     for (index = 0; index < table_of_symbols->size_of_linked_list && current_node != NULL; index++) {
@@ -320,52 +405,175 @@ void handle_symbol_table_process(SymbolLinkedList *table_of_symbols, struct obje
  */
 void handle_missing_symbols(SymbolsNotFoundLinkedList *were_to_fill_in_symbol_table, struct object_file *object, const char *name_of_am_file, int *error_d, int number_of_the_line, struct symbol *find_symbol) {
     struct symbols_that_were_not_found_at_first *current_symbol;
-    /* Store the size of the 'were_to_fill_in_symbol_table' list */
-    size_t length_were_to_fill_in_symbol_table = were_to_fill_in_symbol_table->size_of_linked_list;
-    size_t index = 0;
+    SymbolsNotFoundNode *current_node;
+
+    /* Checks if every symbol was found at first */
+    if (were_to_fill_in_symbol_table == NULL) {
+        return;
+    }
 
     /* Iterate through the list of missing symbols */
-    while (index < length_were_to_fill_in_symbol_table) {
+    for (current_node = were_to_fill_in_symbol_table->head; current_node != NULL; current_node = current_node->next) {
         /* Retrieve the current missing symbol from the list */
-        current_symbol = (struct symbols_that_were_not_found_at_first *)were_to_fill_in_symbol_table->head->data;
+        current_symbol = (struct symbols_that_were_not_found_at_first *)current_node->data;
         
         if (current_symbol) {
-            /* Check if the machine_word is set */
-            if (current_symbol->machine_word) {
-                /* Find the symbol in the object's symbol table */
-                find_symbol = find_symbol_in_linked_list(object->table_of_symbols, current_symbol->name_of_symble);
-                
-                if (find_symbol && (find_symbol->type_of_symbol != symbol_entry)) {
-                    /* If the symbol is found and not an entry symbol */
-                    current_symbol->machine_word = find_symbol->address_of_symbol << 2;
-
-                    if (find_symbol->type_of_symbol == symbol_extern) {
-                        /* Set the 'external' */
-                        current_symbol->machine_word |= 1;
-                        /* Add the symbol into the external symbol list */
-                        add_external_symbol(&(object->name_and_addresses_certain_extern), find_symbol->name_of_symbol, current_symbol->address_of_calling);
-                    } else {
-                        current_symbol->machine_word |= 2;
-                    }
-                    
+            /* Find the symbol in the object's symbol table */
+            find_symbol = find_symbol_by_id(&object->interned_symbols, current_symbol->id_of_symbol);
+            
+            if (find_symbol && (find_symbol->type_of_symbol != symbol_entry)) {
+                /* If the symbol is found and not an entry symbol */
+                current_symbol->machine_word = find_symbol->address_of_symbol << 2;
+
+                if (find_symbol->type_of_symbol == symbol_extern) {
+                    /* Set the 'external' */
+                    current_symbol->machine_word |= 1;
+                    /* Add the symbol into the external symbol list */
+                    add_external_symbol(&(object->extern_uses), find_symbol->id_of_symbol, current_symbol->address_of_calling);
                 } else {
-                    /* If the symbol is not found or is an 'entry' symbol, generate an error */
-                    error_fmt(name_of_am_file, number_of_the_line, "The label: '%s' was called in line: '%d' but was not defined in the file.", current_symbol->name_of_symble, current_symbol->line_it_was_called);
-                    /* Reset the error flag */
-                    *error_d = 0;
+                    current_symbol->machine_word |= 2;
+                    /* The word changes when the code is loaded at another address */
+                    add_relocation(&(object->relocations), current_symbol->address_of_calling - BEGINNING_ADDRESS);
                 }
+                /* Fill in the word that was left for the symbol in the code image */
+                object->code_image[current_symbol->address_of_calling - BEGINNING_ADDRESS].code_word = current_symbol->machine_word;
+                
             } else {
-                /* In case memory allocation for 'machine_word' failed, terminate with an error */
-                fprintf(stderr, "Memory allocation for current_symbol->machine_word failed\n");
-                exit(1);
+                /* If the symbol is not found or is an 'entry' symbol, generate an error */
+                error_fmt(name_of_am_file, number_of_the_line, "The label: '%s' was called in line: '%d' but was not defined in the file.", name_of_symbol_id(&object->interned_symbols, current_symbol->id_of_symbol), current_symbol->line_it_was_called);
+                /* Reset the error flag */
+                *error_d = 0;
             }
-            }
-            /* Continue to the next node in the 'were_to_fill_in_symbol_table' list */
-            were_to_fill_in_symbol_table->head = were_to_fill_in_symbol_table->head->next;
-            index++;
+        }
     }
+}
 
-    
+/*
+ * Adds the words that were assembled from a line to the source map of the object file, if the source map is needed.
+ *
+ * @param object A pointer to the object_file structure.
+ * @param origins_of_lines The origins of the lines of the am file.
+ * @param index_of_line The index of the line in the am file, starting at 0.
+ * @param first_address The address of the first word that was assembled from the line.
+ * @param end_address The address right after the last word that was assembled from the line.
+ * @param is_data 1 if the words are in the data image, 0 if they are in the code image.
+ * @param name_of_label The last label that was defined before the line.
+ */
+static void map_line_to_source(struct object_file *object, const struct line_origin_table *origins_of_lines, size_t index_of_line,
+                               long first_address, long end_address, int is_data, const char *name_of_label) {
+    struct source_map_record record = {0};
+
+    /* Without the options that need it, the lines have no origins and the map stays empty */
+    if (!source_map_is_needed() || index_of_line >= origins_of_lines->amount_of_lines) {
+        return;
+    }
+    record.first_address = (unsigned int)first_address;
+    record.end_address = (unsigned int)end_address;
+    record.line_in_source = origins_of_lines->origins[index_of_line].line_in_source;
+    record.line_of_calling = origins_of_lines->origins[index_of_line].line_of_calling;
+    record.is_data = is_data;
+    strcpy(record.name_of_label, name_of_label);
+    strcpy(record.name_of_macro, origins_of_lines->origins[index_of_line].name_of_macro);
+    add_source_map_record(&object->map_of_sources, &record);
+}
+
+/*
+ * Counts the words of a line that comes after the memory was full, for the resource report.
+ *
+ * The words are not stored, they only get addresses after the last word that was stored
+ * and are added to the source map, so the report shows how much memory the whole program needs.
+ *
+ * @param object A pointer to the object_file structure.
+ * @param ast A pointer to the AST of the line, without syntax errors.
+ * @param origins_of_lines The origins of the lines of the am file.
+ * @param index_of_line The index of the line in the am file, starting at 0.
+ * @param last_code_label The last label that was defined in the code image, it is updated.
+ * @param last_data_label The last label that was defined in the data image, it is updated.
+ */
+static void count_words_beyond_memory(struct object_file *object, const mmn14_ast *ast, const struct line_origin_table *origins_of_lines,
+                                      size_t index_of_line, char *last_code_label, char *last_data_label) {
+    long first_address;
+    long words;
+
+    if (ast->mmn14_ast_options == mmn14_ast_instruction) {
+        if (ast->name_of_label[0] != '\0') {
+            strcpy(last_code_label, ast->name_of_label);
+        }
+        words = words_of_line(ast);
+        first_address = object->IC + object->code_words_beyond_memory + BEGINNING_ADDRESS;
+        map_line_to_source(object, origins_of_lines, index_of_line, first_address, first_address + words, 0, last_code_label);
+        object->code_words_beyond_memory += words;
+    } else if (ast->mmn14_ast_options == mmn14_ast_directive &&
+               (ast->directive_or_instruction.mmn14_ast_directive.mmn14_ast_directive_opt == mmn14_ast_directive_string ||
+                ast->directive_or_instruction.mmn14_ast_directive.mmn14_ast_directive_opt == mmn14_ast_directive_data)) {
+        if (ast->name_of_label[0] != '\0') {
+            strcpy(last_data_label, ast->name_of_label);
+        }
+        if (ast->directive_or_instruction.mmn14_ast_directive.mmn14_ast_directive_opt == mmn14_ast_directive_string) {
+            words = (long)strlen(ast->directive_or_instruction.mmn14_ast_directive.directive_operand.string) + 1;
+        } else {
+            words = ast->directive_or_instruction.mmn14_ast_directive.directive_operand.data.num_of_numbers;
+        }
+        first_address = object->DC + object->data_words_beyond_memory;
+        map_line_to_source(object, origins_of_lines, index_of_line, first_address, first_address + words, 1, last_data_label);
+        object->data_words_beyond_memory += words;
+    }
+}
+
+/*
+ * Reads the next line of the am file and its AST.
+ *
+ * The line is read and lexed from the am file, taken from the lines that were lexed in parallel,
+ * or taken from the lexed lines of the pipeline. A line of the pipeline stays in its slot until
+ * the next line is read, since its AST points in to it, and its origin is added to the table of line origins.
+ *
+ * @param source A pointer to the source of the lines.
+ * @param line A pointer that receives the text of the line, after it was lexed.
+ * @param ast A pointer that receives the AST of the line.
+ * @param ends_line A pointer that is set if the line was read to its end.
+ * @param object A pointer to the object_file structure, the names of the labels are interned in it.
+ * @param origins_of_lines The origins of the lines of the am file.
+ * @return 1 if a line was read, 0 at the end of the file.
+ */
+static int read_am_line(struct am_line_source *source, char **line, mmn14_ast *ast, int *ends_line,
+                        struct object_file *object, struct line_origin_table *origins_of_lines) {
+    struct lexed_line *lexed;
+
+    if (source->lexed_file != NULL) {
+        if (source->next_line_of_file == source->lexed_file->amount_of_lines) {
+            return 0;
+        }
+        lexed = source->lexed_file->kept_lines != NULL ? source->lexed_file->kept_lines[source->next_line_of_file++] :
+                &source->lexed_file->lines[source->next_line_of_file++];
+    } else if (source->lexed_lines != NULL) {
+        /* The previous line is not needed anymore */
+        if (source->current_line != NULL) {
+            end_pop_from_ring(source->lexed_lines);
+        }
+        source->current_line = (struct lexed_line *)begin_pop_from_ring(source->lexed_lines);
+        if (source->current_line == NULL) {
+            return 0;
+        }
+        lexed = source->current_line;
+    } else {
+        if (!fgets(source->line_buffer, MAX_LENGTH_OF_LINE + 1, source->am_file)) {
+            return 0;
+        }
+        *ends_line = strchr(source->line_buffer, '\n') != NULL;
+        *ast = get_ast_lexer(source->line_buffer, &object->interned_symbols);
+        *line = source->line_buffer;
+        return 1;
+    }
+    if (lexed->has_origin) {
+        add_line_origin(origins_of_lines, lexed->origin.line_in_source,
+                        lexed->origin.name_of_macro[0] != '\0' ? lexed->origin.name_of_macro : NULL, lexed->origin.line_of_calling);
+    }
+    *ends_line = lexed->ends_line;
+    *ast = lexed->ast;
+    /* The lexed lines are interned in their order, so the ids are the same as when the file is read */
+    intern_labels_of_ast(ast, &object->interned_symbols);
+    *line = lexed->text;
+    return 1;
 }
 
 /*
@@ -375,15 +583,18 @@ void handle_missing_symbols(SymbolsNotFoundLinkedList *were_to_fill_in_symbol_ta
  * and processes the instructions and directives. It handles symbol table management, missing symbols,
  * and other aspects of the compilation process.
  *
- * @param am_file A pointer to the am file.
+ * @param source A pointer to the source of the lines of the am file.
  * @param object A pointer to the object_file structure.
  * @param name_of_am_file The name of the am file being compiled.
+ * @param origins_of_lines The origins of the lines of the am file, used for the source map.
  * @return 1 if the compilation process finishes successfully, 0 if errors are encountered.
  */
-static int compilation_function(FILE * am_file, struct object_file * object, const char * name_of_am_file)
+static int compilation_function(struct am_line_source *source, struct object_file * object, const char * name_of_am_file, struct line_origin_table *origins_of_lines)
 {
-    /* Buffer to hold a line */
-    char line_buffer[MAX_LENGTH_OF_LINE + 1] = {0}; 
+    /* The text of the line after it was lexed */
+    char *line;
+    /* Set if the line was read to its end */
+    int ends_line;
     /* Structure to store the Abstract Syntax Tree for each line */
     mmn14_ast ast; 
     struct symbol local_symbol = {0};
@@ -395,16 +606,60 @@ static int compilation_function(FILE * am_file, struct object_file * object, con
     int number_of_the_line = 1;
     /* This is a error flag, to know if the compilation finished succesfuly , if error_d == 1than fnished succesfuly, if error_d == 0 than didnt finish succesfuly */
     int error_d = 1; 
+    /* The number of lines of the am file that were read to their end */
+    size_t lines_that_ended = 0;
+    /* The index of the current line in the am file */
+    size_t index_of_line;
+    /* The counters before the current line */
+    long IC_before_line;
+    long DC_before_line;
+    /* The last labels that were defined in the code and data images */
+    char last_code_label[LABEL_MAX_LENGTH + 1] = {0};
+    char last_data_label[LABEL_MAX_LENGTH + 1] = {0};
+    /* The constants of the data image, by their content */
+    struct constant_pool pool_of_constants = {{0}};
+    long offset_of_constant;
+    /* The instructions that the peephole optimizer removed */
+    struct peephole_result peephole = {0};
+    /* The number of times a line was read from the am file */
+    size_t index_of_read = 0;
+    /* Set if the instruction of the current line was removed by the optimizer */
+    int optimized_out;
+    /* The time the current phase of the compilation started, for the trace */
+    double start_of_phase = trace_clock();
+    /* The number of diagnostics that were printed before the file */
+    long diagnostics_before_file = amount_of_diagnostics;
+
+    /* Mark the instructions the optimizer removes before anything is encoded */
+    if (options_of_assembler.optimize && !options_of_assembler.check_level && source->am_file != NULL && optimize_am_file(source->am_file, &object->interned_symbols, &peephole)) {
+        object->optimized_out_instructions = peephole.removed_instructions;
+        object->words_saved_by_optimizer = peephole.removed_words;
+    }
+    if (options_of_assembler.optimize) {
+        add_trace_span("optimize_am_file", name_of_am_file, start_of_phase);
+        start_of_phase = trace_clock();
+    }
      
     /* Iterate through each line in the am file */
-     while(fgets(line_buffer, sizeof(line_buffer), am_file)) 
+     /* Get the Abstract Syntax Tree (AST) for every line using the lexer */
+     while(read_am_line(source, &line, &ast, &ends_line, object, origins_of_lines)) 
      {
-           /* Get the Abstract Syntax Tree (AST) for the current line using the lexer */
-           ast = get_ast_lexer(line_buffer); 
+           index_of_line = lines_that_ended;
+           optimized_out = line_was_optimized_out(&peephole, index_of_read++);
+           if (ends_line) {
+               lines_that_ended++;
+           }
            /* check if the line is empty or just a newline character */
-            if (line_buffer[0] == '\0' || (line_buffer[0] == '\n' && line_buffer[1] == '\0')) {
+            if (line[0] == '\0' || (line[0] == '\n' && line[1] == '\0')) {
                 continue;  /* Skip this iteration */
             }
+            /* After the memory is full, the words of the lines are only counted for the report */
+            if (object->memory_is_full) {
+                if (ast.syntax_error[0] == '\0' && !optimized_out) {
+                    count_words_beyond_memory(object, &ast, origins_of_lines, index_of_line, last_code_label, last_data_label);
+                }
+                continue;
+            }
             /* Check for syntax errors in the AST */
            if (ast.syntax_error[0] != '\0') 
            {
@@ -414,22 +669,29 @@ static int compilation_function(FILE * am_file, struct object_file * object, con
               error_d = 0; 
               continue;
            }
+           /* Only the syntax of the lines is checked */
+           if (options_of_assembler.check_level == CHECK_SYNTAX)
+           {
+              number_of_the_line++;
+              continue;
+           }
            /* Check if the line has a label */
            if (ast.name_of_label[0] != '\0') 
            {
-                /* Copy the label name into the local symbol */
-                strcpy(local_symbol.name_of_symbol, ast.name_of_label); 
+                /* Set the id of the label in the local symbol */
+                local_symbol.id_of_symbol = ast.id_of_label; 
                 /* Search for the symbol in the object's symbol table */
-                find_symbol = find_symbol_in_linked_list(object->table_of_symbols, ast.name_of_label);
+                find_symbol = find_symbol_by_id(&object->interned_symbols, ast.id_of_label);
                 /* Process the instruction lines */
                 if (ast.mmn14_ast_options == mmn14_ast_instruction)
                 {
+                    strcpy(last_code_label, ast.name_of_label);
                     if (find_symbol) 
                     {
                         if (find_symbol->type_of_symbol != symbol_entry) 
                         {
                            /* Error: Label was already defined */
-                           error_fmt(name_of_am_file, number_of_the_line, "The label '%s': '%s' was defined already in line: '%d'.", find_symbol->name_of_symbol, string_type_of_symbol[find_symbol->type_of_symbol], find_symbol->line_of_declaration);
+                           error_fmt(name_of_am_file, number_of_the_line, "The label '%s': '%s' was defined already in line: '%d'.", name_of_symbol_id(&object->interned_symbols, find_symbol->id_of_symbol), string_type_of_symbol[find_symbol->type_of_symbol], find_symbol->line_of_declaration);
                            /* Update error flag */
                            error_d = 0;
                         }else{ 
@@ -443,7 +705,7 @@ static int compilation_function(FILE * am_file, struct object_file * object, con
                         local_symbol.address_of_symbol = object->IC + BEGINNING_ADDRESS; 
                         local_symbol.line_of_declaration = number_of_the_line;
 
-                        insert_symbol_to_linked_list(&(object->table_of_symbols), &local_symbol );
+                        insert_symbol_in_to_table(object, &local_symbol);
                     }
                 }else if(ast.mmn14_ast_options == mmn14_ast_directive){ 
                      /* Process directive lines */
@@ -452,6 +714,11 @@ static int compilation_function(FILE * am_file, struct object_file * object, con
                      {
                         /* Entries and externs have no meaning here */
                      }else{
+                        if (ast.directive_or_instruction.mmn14_ast_directive.mmn14_ast_directive_opt == mmn14_ast_directive_string ||
+                            ast.directive_or_instruction.mmn14_ast_directive.mmn14_ast_directive_opt == mmn14_ast_directive_data)
+                        {
+                            strcpy(last_data_label, ast.name_of_label);
+                        }
                         if (find_symbol) 
                         {
                             /* Checks if string or data directives */
@@ -461,7 +728,7 @@ static int compilation_function(FILE * am_file, struct object_file * object, con
                                if (find_symbol->type_of_symbol != symbol_entry)
                                {
                                   /* Error: Label was already defined */
-                                  error_fmt(name_of_am_file, number_of_the_line, "The label '%s': '%s' was defined already in line: '%d'.", find_symbol->name_of_symbol, string_type_of_symbol[find_symbol->type_of_symbol], find_symbol->line_of_declaration);
+                                  error_fmt(name_of_am_file, number_of_the_line, "The label '%s': '%s' was defined already in line: '%d'.", name_of_symbol_id(&object->interned_symbols, find_symbol->id_of_symbol), string_type_of_symbol[find_symbol->type_of_symbol], find_symbol->line_of_declaration);
                                   /* Update error flag */
                                   error_d = 0;
                                }else{ 
@@ -487,17 +754,27 @@ static int compilation_function(FILE * am_file, struct object_file * object, con
                                 /* Line thats declared */
                                 local_symbol.line_of_declaration = number_of_the_line;
                                 /* Insert the new data symbol into the symbol table */
-                                insert_symbol_to_linked_list(&(object->table_of_symbols), &local_symbol);
+                                insert_symbol_in_to_table(object, &local_symbol);
                             }
                        }
                     }
                 }
             }
+        IC_before_line = object->IC;
+        DC_before_line = object->DC;
+        /* Checks if the optimizer removed the instruction, its label stays at the address of the next instruction */
+        if (optimized_out)
+        {
+            number_of_the_line++;
+            continue;
+        }
         /* Process the AST options */
         switch (ast.mmn14_ast_options){
             case mmn14_ast_instruction:
                 /* Process instruction AST */
-                process_ast_instruction(ast, object, number_of_the_line, &were_to_fill_in_symbol_table, &find_symbol, &local_symbol);
+                if (!process_ast_instruction(ast, object, number_of_the_line)) {
+                    error_d = 0;
+                }
 
             break;
             case mmn14_ast_directive:
@@ -509,19 +786,512 @@ static int compilation_function(FILE * am_file, struct object_file * object, con
                 
             break;
         }
+        /* Pool the labeled constant of the line with an identical one */
+        if (options_of_assembler.pool_constants && !options_of_assembler.check_level && ast.mmn14_ast_options == mmn14_ast_directive && ast.name_of_label[0] != '\0' && object->DC != DC_before_line &&
+            (ast.directive_or_instruction.mmn14_ast_directive.mmn14_ast_directive_opt == mmn14_ast_directive_string ||
+             ast.directive_or_instruction.mmn14_ast_directive.mmn14_ast_directive_opt == mmn14_ast_directive_data))
+        {
+            offset_of_constant = pool_data_constant(&pool_of_constants, object, DC_before_line);
+            find_symbol = find_symbol_by_id(&object->interned_symbols, ast.id_of_label);
+            /* The label aliases the copy that was already in the data image */
+            if (offset_of_constant >= 0 && find_symbol && find_symbol->address_of_symbol == (unsigned int)DC_before_line &&
+                (find_symbol->type_of_symbol == symbol_data || find_symbol->type_of_symbol == symbol_entry_data))
+            {
+                find_symbol->address_of_symbol = (unsigned int)offset_of_constant;
+            }
+        }
+        /* Map the words of the line to the line of the source file */
+        if (object->IC != IC_before_line && !options_of_assembler.check_level) {
+            map_line_to_source(object, origins_of_lines, index_of_line, IC_before_line + BEGINNING_ADDRESS, object->IC + BEGINNING_ADDRESS, 0, last_code_label);
+        }
+        if (object->DC != DC_before_line && !options_of_assembler.check_level) {
+            map_line_to_source(object, origins_of_lines, index_of_line, DC_before_line, object->DC, 1, last_data_label);
+        }
+        /* Stop before the images grow beyond the memory, a single line can't fill the rest of the arrays */
+        if (object->IC + object->DC > MEMORY_SIZE - BEGINNING_ADDRESS) {
+            error_fmt(name_of_am_file, number_of_the_line, "The program needs more than the %d words of memory that start at address %d.", MEMORY_SIZE - BEGINNING_ADDRESS, BEGINNING_ADDRESS);
+            error_d = 0;
+            /* The report shows how much memory the whole program needs, so the rest of the lines are counted for it */
+            if (!options_of_assembler.output_report || options_of_assembler.check_level) {
+                break;
+            }
+            object->memory_is_full = 1;
+        }
         /* Continue to the next line */
         number_of_the_line++; 
      }
+    add_trace_span("first pass", name_of_am_file, start_of_phase);
+    /* Encode the instructions, now that every symbol of the code image is defined, or only check their labels */
+    start_of_phase = trace_clock();
+    if (options_of_assembler.check_level) {
+        check_instructions(object, &were_to_fill_in_symbol_table);
+        add_trace_span("check_instructions", name_of_am_file, start_of_phase);
+    } else {
+        encode_instructions(object, &were_to_fill_in_symbol_table);
+        add_trace_span("encode_instructions", name_of_am_file, start_of_phase);
+    }
     /* Handle the symbol table */
+    start_of_phase = trace_clock();
     handle_symbol_table_process((object->table_of_symbols), object, name_of_am_file, &error_d);
+    add_trace_span("handle_symbol_table_process", name_of_am_file, start_of_phase);
     /* Handle missing symbols */
+    start_of_phase = trace_clock();
     handle_missing_symbols(were_to_fill_in_symbol_table, object, name_of_am_file, &error_d, number_of_the_line, find_symbol);
+    add_trace_span("handle_missing_symbols", name_of_am_file, start_of_phase);
+    add_trace_counter("lines", number_of_the_line - 1);
+    add_trace_counter("symbols", object->table_of_symbols != NULL ? (long)object->table_of_symbols->size_of_linked_list : 0);
+    add_trace_counter("diagnostics", amount_of_diagnostics - diagnostics_before_file);
     /* Free memory used for the missing symbols list */
     free_symbols_not_found_linked_list(&were_to_fill_in_symbol_table);
+    /* Free memory used for the constant pool */
+    free_constant_pool(&pool_of_constants);
+    /* Free memory used for the result of the optimizer */
+    free_peephole_result(&peephole);
     
     return error_d; 
 } /* END OF compilation_function */
 
+/*
+ * Parses an option that was given in the command line.
+ *
+ * This function recognizes an option and updates the options of the assembler.
+ *
+ * @param option The option as it was given in the command line.
+ * @param next_argument The argument after the option, or NULL if it is the last one.
+ * @return The number of arguments the option took, 0 if it was not recognized.
+ */
+static int parse_option(const char *option, const char *next_argument) {
+    if (strcmp(option, "-o") == 0) {
+        if (next_argument == NULL) {
+            fprintf(stderr, "the option -o needs the name of a directory\n");
+            return 1;
+        }
+        options_of_assembler.output_directory = next_argument;
+        return 2;
+    } else if (strncmp(option, "-I", 2) == 0) {
+        /* The directory is either the rest of the option or the next argument */
+        if (option[2] == '\0' && next_argument == NULL) {
+            fprintf(stderr, "the option -I needs the name of a directory\n");
+            return 1;
+        }
+        if (options_of_assembler.amount_of_include_directories == MAX_INCLUDE_DIRECTORIES) {
+            fprintf(stderr, "there can be at most %d include directories\n", MAX_INCLUDE_DIRECTORIES);
+        } else {
+            options_of_assembler.include_directories[options_of_assembler.amount_of_include_directories++] = option[2] != '\0' ? option + 2 : next_argument;
+        }
+        return option[2] != '\0' ? 1 : 2;
+    } else if (strncmp(option, "-L", 2) == 0) {
+        /* The library is either the rest of the option or the next argument */
+        if (option[2] == '\0' && next_argument == NULL) {
+            fprintf(stderr, "the option -L needs the name of a macro library\n");
+            return 1;
+        }
+        if (options_of_assembler.amount_of_macro_libraries == MAX_MACRO_LIBRARIES) {
+            fprintf(stderr, "there can be at most %d macro libraries\n", MAX_MACRO_LIBRARIES);
+        } else {
+            options_of_assembler.macro_libraries[options_of_assembler.amount_of_macro_libraries++] = option[2] != '\0' ? option + 2 : next_argument;
+        }
+        return option[2] != '\0' ? 1 : 2;
+    } else if (strcmp(option, "-MD") == 0) {
+        options_of_assembler.write_dependency_files = 1;
+    } else if (strncmp(option, "-MF", 3) == 0) {
+        /* The file is either the rest of the option or the next argument, and it turns on -MD */
+        if (option[3] == '\0' && next_argument == NULL) {
+            fprintf(stderr, "the option -MF needs the name of a file\n");
+            return 1;
+        }
+        options_of_assembler.write_dependency_files = 1;
+        options_of_assembler.dependency_file = option[3] != '\0' ? option + 3 : next_argument;
+        return option[3] != '\0' ? 1 : 2;
+    } else if (strncmp(option, "--archive", strlen("--archive")) == 0 && (option[strlen("--archive")] == '\0' || option[strlen("--archive")] == '=')) {
+        /* The archive is either after the = or the next argument */
+        if (option[strlen("--archive")] == '\0' && next_argument == NULL) {
+            fprintf(stderr, "the option --archive needs the name of a file\n");
+            return 1;
+        }
+        options_of_assembler.object_archive = option[strlen("--archive")] == '=' ? option + strlen("--archive=") : next_argument;
+        return option[strlen("--archive")] == '=' ? 1 : 2;
+    } else if (strncmp(option, "--trace", strlen("--trace")) == 0 && (option[strlen("--trace")] == '\0' || option[strlen("--trace")] == '=')) {
+        /* The trace file is either after the = or the next argument */
+        if (option[strlen("--trace")] == '\0' && next_argument == NULL) {
+            fprintf(stderr, "the option --trace needs the name of a file\n");
+            return 1;
+        }
+        options_of_assembler.trace_file = option[strlen("--trace")] == '=' ? option + strlen("--trace=") : next_argument;
+        return option[strlen("--trace")] == '=' ? 1 : 2;
+    } else if (strcmp(option, "--find") == 0) {
+        options_of_assembler.archive_action = ARCHIVE_FIND;
+    } else if (strcmp(option, "--extract") == 0) {
+        options_of_assembler.archive_action = ARCHIVE_EXTRACT;
+    } else if (strcmp(option, "--mem-stats") == 0) {
+        options_of_assembler.print_memory_statistics = 1;
+    } else if (strcmp(option, "--mem-leaks") == 0) {
+        options_of_assembler.report_memory_leaks = 1;
+    } else if (strcmp(option, "--watch") == 0) {
+        options_of_assembler.watch_files = 1;
+    } else if (strcmp(option, "--make-mlib") == 0) {
+        options_of_assembler.make_macro_library = 1;
+    } else if (strcmp(option, "--check") == 0 || strcmp(option, "--check=full") == 0) {
+        options_of_assembler.check_level = CHECK_SEMANTICS;
+    } else if (strcmp(option, "--check=syntax") == 0) {
+        options_of_assembler.check_level = CHECK_SYNTAX;
+    } else if (strcmp(option, "--emit-c") == 0) {
+        options_of_assembler.emit_c = 1;
+    } else if (strcmp(option, "--run") == 0) {
+        options_of_assembler.run_program = 1;
+    } else if (strcmp(option, "--diff-test") == 0) {
+        /* The differential test compiles the C translation */
+        options_of_assembler.emit_c = 1;
+        options_of_assembler.differential_test = 1;
+    } else if (strcmp(option, "--map") == 0) {
+        options_of_assembler.output_map = 1;
+    } else if (strcmp(option, "--report") == 0) {
+        options_of_assembler.output_report = 1;
+    } else if (strcmp(option, "--pool") == 0) {
+        options_of_assembler.pool_constants = 1;
+    } else if (strcmp(option, "--stats") == 0) {
+        options_of_assembler.print_statistics = 1;
+    } else if (strcmp(option, "-O") == 0) {
+        options_of_assembler.optimize = 1;
+    } else if (strcmp(option, "--reloc") == 0) {
+        options_of_assembler.output_relocations = 1;
+    } else if (strcmp(option, "--ext-grouped") == 0) {
+        options_of_assembler.group_extern_output = 1;
+    } else if (strcmp(option, "--pipeline") == 0) {
+        options_of_assembler.pipeline = 1;
+    } else if (strncmp(option, "--read-ahead=", strlen("--read-ahead=")) == 0) {
+        options_of_assembler.files_to_read_ahead = atoi(option + strlen("--read-ahead="));
+        if (options_of_assembler.files_to_read_ahead < 1 || options_of_assembler.files_to_read_ahead > MAX_FILES_TO_READ_AHEAD) {
+            fprintf(stderr, "the number of files to read ahead must be between 1 and %d\n", MAX_FILES_TO_READ_AHEAD);
+            options_of_assembler.files_to_read_ahead = 0;
+        }
+    } else if (strncmp(option, "--jobs=", strlen("--jobs=")) == 0) {
+        options_of_assembler.amount_of_jobs = atoi(option + strlen("--jobs="));
+        if (options_of_assembler.amount_of_jobs < 1 || options_of_assembler.amount_of_jobs > MAX_AMOUNT_OF_JOBS) {
+            fprintf(stderr, "the number of jobs must be between 1 and %d\n", MAX_AMOUNT_OF_JOBS);
+            options_of_assembler.amount_of_jobs = 0;
+        }
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Handles the programs that were assembled successfully, according to the options of the assembler.
+ *
+ * This function writes the source map and the resource report of the program, prints its statistics, writes the C translation of the program,
+ * runs it in the emulator and runs the differential test between both, if these were requested.
+ *
+ * @param name_of_file The base name of the assembled file.
+ * @param object A pointer to the object_file structure of the program.
+ */
+static void handle_assembled_program(const char *name_of_file, const struct object_file *object) {
+    static struct machine_state machine;
+    const struct source_map_record *record;
+    char *as_name_of_file;
+
+    if (options_of_assembler.output_map) {
+        as_name_of_file = create_file_name(name_of_file, ".as");
+        if (as_name_of_file != NULL) {
+            output_map_file(name_of_file, as_name_of_file, &object->map_of_sources);
+            tracked_free(as_name_of_file);
+        }
+    }
+    if (options_of_assembler.output_report) {
+        output_report_files(name_of_file, object);
+    }
+    if (options_of_assembler.print_statistics) {
+        printf("%s: %ld code words, %ld data words, %ld duplicate constants pooled, %ld words (%ld bytes of .ob) saved\n",
+               name_of_file, object->IC, object->DC, object->pooled_constants, object->words_saved_by_pool, object->words_saved_by_pool * BYTES_OF_OBJECT_WORD);
+        printf("%s: %ld instructions removed by the optimizer, %ld code words saved\n",
+               name_of_file, object->optimized_out_instructions, object->words_saved_by_optimizer);
+    }
+    if (options_of_assembler.emit_c && output_c_file(name_of_file, object) && options_of_assembler.differential_test) {
+        differential_test(name_of_file, object);
+    }
+    if (options_of_assembler.run_program) {
+        if (emulator_load(&machine, object)) {
+            if (emulator_run(&machine, stdin, stdout, EMULATOR_MAX_STEPS) == emulator_fault) {
+                /* Point at the line of the source file the fault came from */
+                record = find_source_map_record(&object->map_of_sources, machine.fault_address);
+                if (record != NULL && record->name_of_macro[0] != '\0') {
+                    fprintf(stderr, "%s.as:%u: the fault happened here, in macro '%s' that was called in line %u\n", name_of_file, record->line_in_source, record->name_of_macro, record->line_of_calling);
+                } else if (record != NULL) {
+                    fprintf(stderr, "%s.as:%u: the fault happened here\n", name_of_file, record->line_in_source);
+                }
+            }
+        } else {
+            fprintf(stderr, "%s: the program does not fit in the memory\n", name_of_file);
+        }
+    }
+}
+
+/*
+ * Writes the output files of a file that was compiled successfully and handles it according to the options.
+ *
+ * @param name_of_file The base name of the file.
+ * @param object A pointer to the object_file structure of the file.
+ */
+static void output_assembled_file(char *name_of_file, struct object_file *object) {
+    double start_of_output = trace_clock();
+
+    /* Move the data records of the source map after the code image */
+    finish_source_map(&object->map_of_sources, object->IC);
+    /* Group the uses of every external symbol together */
+    group_extern_uses(&object->extern_uses);
+    /* Order the relocatable words by their offset */
+    sort_relocations(&object->relocations);
+    /* Output the relevent files */
+    output(name_of_file, object);
+    add_trace_span("output", name_of_file, start_of_output);
+    handle_assembled_program(name_of_file, object);
+}
+
+/*
+ * Writes the resource report of a file whose images didn't fit in the memory, if the report was requested.
+ *
+ * @param name_of_file The base name of the file.
+ * @param object A pointer to the object_file structure of the file.
+ */
+static void output_report_of_full_memory(const char *name_of_file, struct object_file *object) {
+    if (!object->memory_is_full) {
+        return;
+    }
+    /* The data records come after all the code words, the ones that didn't fit as well */
+    finish_source_map(&object->map_of_sources, object->IC + object->code_words_beyond_memory);
+    output_report_files(name_of_file, object);
+}
+
+/*
+ * Outputs the make rule of a module that was assembled, with the files it was assembled from.
+ *
+ * The rule goes to the .d file of the module, or to the rules of all the modules when they are written to one file.
+ *
+ * @param name_of_file The base name of the module.
+ * @param extension_of_target The extension of the file the rule makes.
+ * @param dependencies A pointer to the source file of the module and the files it included.
+ * @param rules_of_all_modules A pointer to the text that receives the rule, when -MF was given.
+ */
+static void output_dependencies(const char *name_of_file, const char *extension_of_target, struct source_dependencies *dependencies, struct output_text *rules_of_all_modules) {
+    struct output_text rule = {0};
+    char *name_of_target;
+    char *name_of_dependency_file;
+
+    /* Every module can call the macros of the libraries */
+    add_macro_library_dependencies(dependencies);
+    name_of_target = create_output_file_name(name_of_file, extension_of_target);
+    if (name_of_target == NULL) {
+        return;
+    }
+    if (options_of_assembler.dependency_file != NULL) {
+        if (!append_dependency_rule(rules_of_all_modules, name_of_target, dependencies)) {
+            fprintf(stderr, "wasn't able to allocate memory for the dependencies of %s\n", name_of_file);
+        }
+    } else if (append_dependency_rule(&rule, name_of_target, dependencies)) {
+        name_of_dependency_file = create_output_file_name(name_of_file, FILE_EXTENSION_DEPENDENCIES);
+        if (name_of_dependency_file != NULL) {
+            write_output_if_changed(name_of_dependency_file, &rule);
+        }
+        tracked_free(name_of_dependency_file);
+    } else {
+        fprintf(stderr, "wasn't able to allocate memory for the dependencies of %s\n", name_of_file);
+    }
+    free_output_text(&rule);
+    tracked_free(name_of_target);
+}
+
+/*
+ * Assembles a file while it is preprocessed and lexed by the threads of a pipeline.
+ *
+ * The compilation takes the lexed lines as soon as they are ready, and the outputs are the same as
+ * when the file is preprocessed, lexed and compiled one after the other.
+ *
+ * @param name_of_file The base name of the file.
+ * @param origins_of_lines A pointer to the table that receives the origins of the lines of the am file.
+ * @param preloaded The source file that was read ahead of time, or NULL.
+ * @param dependencies A pointer that receives the files the preprocessor read, or NULL.
+ * @param assembled A pointer that is set to 1 if the file was assembled without errors, and to 0 otherwise.
+ * @return 1 if the pipeline was started, 0 if the file has to be assembled without it.
+ */
+static int assemble_file_in_pipeline(char *name_of_file, struct line_origin_table *origins_of_lines, struct preloaded_source *preloaded,
+                                     struct source_dependencies *dependencies, int *assembled) {
+    struct pipeline pipeline;
+    struct am_line_source source = {0};
+    struct object_file current_object_file;
+    char *am_name_of_file;
+    const char *name_from_preprocessor;
+    int compiled;
+
+    am_name_of_file = create_output_file_name(name_of_file, file_extension_am);
+    if (am_name_of_file == NULL || !start_pipeline(&pipeline, name_of_file, preloaded, dependencies)) {
+        tracked_free(am_name_of_file);
+        return 0;
+    }
+    current_object_file = assembler_new_object_file();
+    source.lexed_lines = &pipeline.lexed_lines;
+    compiled = compilation_function(&source, &current_object_file, am_name_of_file, origins_of_lines);
+    /* The file is assembled only if the preprocessing was successful as well */
+    name_from_preprocessor = finish_pipeline(&pipeline);
+    *assembled = compiled == 1 && name_from_preprocessor != NULL;
+    if (*assembled && !options_of_assembler.check_level) {
+        output_assembled_file(name_of_file, &current_object_file);
+    } else {
+        output_report_of_full_memory(name_of_file, &current_object_file);
+    }
+    tracked_free((char *)name_from_preprocessor);
+    tracked_free(am_name_of_file);
+    assembler_delete_object_file(&current_object_file);
+    return 1;
+}
+
+/* Represents an input file in --watch, it is assembled again whenever the files it was assembled from change */
+struct watched_module {
+    char *name_of_file; /* The base name of the file */
+    struct lexed_file lexed_file; /* The lexed lines of the am file from the last assembly, only the lines that change are lexed again */
+    struct source_dependencies dependencies; /* The files the module was assembled from, they are watched */
+    int assembled; /* Set if the last assembly had no errors */
+};
+
+/*
+ * Assembles a module of --watch again.
+ *
+ * The file is preprocessed again, since a change of a macro can change any line, but only the lines of the
+ * am file that changed are lexed again. The lines after them keep their ASTs, the compilation then defines
+ * the symbols, encodes the words and writes the outputs of the whole file.
+ *
+ * @param module A pointer to the module.
+ * @param rules_of_all_modules A pointer to the text that receives the make rule of the module, with -MF.
+ */
+static void assemble_watched_module(struct watched_module *module, struct output_text *rules_of_all_modules) {
+    struct line_origin_table origins_of_lines = {0};
+    struct am_line_source source = {0};
+    struct object_file current_object_file;
+    const char *am_name_of_file;
+    FILE *am_file;
+    char *as_name_of_file;
+
+    module->assembled = 0;
+    free_source_dependencies(&module->dependencies);
+    am_name_of_file = file_preprocessor(module->name_of_file, &origins_of_lines, NULL, NULL, &module->dependencies);
+    if (am_name_of_file != NULL && (am_file = fopen(am_name_of_file, "r")) != NULL) {
+        source.am_file = am_file;
+        /* The optimizer reads the am file itself */
+        if (!options_of_assembler.optimize && relex_am_file(am_file, &module->lexed_file)) {
+            source.lexed_file = &module->lexed_file;
+        }
+        current_object_file = assembler_new_object_file();
+        module->assembled = compilation_function(&source, &current_object_file, am_name_of_file, &origins_of_lines) == 1;
+        if (module->assembled && !options_of_assembler.check_level) {
+            output_assembled_file(module->name_of_file, &current_object_file);
+            if (options_of_assembler.write_dependency_files) {
+                output_dependencies(module->name_of_file, FILE_EXTENSION_OB, &module->dependencies, rules_of_all_modules);
+            }
+        } else {
+            output_report_of_full_memory(module->name_of_file, &current_object_file);
+        }
+        fclose(am_file);
+        assembler_delete_object_file(&current_object_file);
+    }
+    /* A source file that couldn't be read is watched until it can be */
+    if (module->dependencies.amount_of_paths == 0 && (as_name_of_file = create_file_name(module->name_of_file, file_extension_as)) != NULL) {
+        add_source_dependency(&module->dependencies, as_name_of_file);
+        tracked_free(as_name_of_file);
+    }
+    add_macro_library_dependencies(&module->dependencies);
+    tracked_free((char *)am_name_of_file);
+    free_line_origin_table(&origins_of_lines);
+}
+
+/*
+ * Assembles the input files and then assembles them again whenever the files they were assembled from change (--watch).
+ *
+ * Every module keeps the lexed lines of its am file between the assemblies. A change of a macro library maps
+ * the libraries again and assembles all the modules. The function returns only if the files can't be watched.
+ *
+ * @param name_of_file The base names of the input files, NULL for the arguments that are not files.
+ * @param amount_of_files The number of arguments.
+ * @return 1 if the files were assembled and watched, 0 if they couldn't be watched and have to be assembled once.
+ */
+static int watch_input_files(char **name_of_file, int amount_of_files) {
+    struct file_watcher watcher;
+    struct watched_module *modules;
+    struct output_text rules_of_all_modules;
+    int *changed_modules;
+    int amount_of_modules = 0;
+    int changed;
+    int i;
+    size_t j;
+    double start_of_assembly;
+
+    if (!start_file_watcher(&watcher)) {
+        return 0;
+    }
+    /* The flag after the flags of the modules is for the macro libraries */
+    modules = (struct watched_module *)tracked_calloc(amount_of_files + 1, sizeof(struct watched_module), MEMORY_SOURCES);
+    changed_modules = (int *)tracked_calloc(amount_of_files + 1, sizeof(int), MEMORY_SOURCES);
+    if (modules == NULL || changed_modules == NULL) {
+        fprintf(stderr, "Memory allocation error.\n");
+        exit(1);
+    }
+    for (i = 0; i < amount_of_files; i++) {
+        if (name_of_file[i] != NULL) {
+            changed_modules[amount_of_modules] = 1;
+            modules[amount_of_modules++].name_of_file = name_of_file[i];
+        }
+    }
+    for (i = 0; i < options_of_assembler.amount_of_macro_libraries; i++) {
+        watch_file(&watcher, options_of_assembler.macro_libraries[i], amount_of_modules);
+    }
+
+    for (changed = amount_of_modules; changed >= 0; changed = wait_for_changed_modules(&watcher, changed_modules, amount_of_modules + 1)) {
+        /* The included files may call the macros of the libraries, so they are preprocessed again too */
+        if (changed_modules[amount_of_modules]) {
+            free_included_files();
+            free_macro_libraries();
+            for (i = 0; i < options_of_assembler.amount_of_macro_libraries; i++) {
+                load_macro_library(options_of_assembler.macro_libraries[i]);
+            }
+            for (i = 0; i < amount_of_modules; i++) {
+                changed_modules[i] = 1;
+            }
+        }
+        memset(&rules_of_all_modules, 0, sizeof(rules_of_all_modules));
+        for (i = 0; i < amount_of_modules; i++) {
+            if (changed_modules[i]) {
+                start_of_assembly = milliseconds_of_clock();
+                assemble_watched_module(&modules[i], &rules_of_all_modules);
+                printf("%s: %s in %.1f ms, %lu of %lu lines were lexed again\n", modules[i].name_of_file, modules[i].assembled ? "assembled" : "has errors",
+                       milliseconds_of_clock() - start_of_assembly, (unsigned long)modules[i].lexed_file.amount_of_relexed_lines,
+                       (unsigned long)modules[i].lexed_file.amount_of_lines);
+                /* The module may include other files now */
+                forget_files_of_module(&watcher, i);
+                for (j = 0; j < modules[i].dependencies.amount_of_paths; j++) {
+                    watch_file(&watcher, modules[i].dependencies.paths[j], i);
+                }
+            } else if (options_of_assembler.dependency_file != NULL && modules[i].assembled && !options_of_assembler.check_level) {
+                /* The file of all the rules is written again with the rules of the modules that didn't change */
+                output_dependencies(modules[i].name_of_file, FILE_EXTENSION_OB, &modules[i].dependencies, &rules_of_all_modules);
+            }
+        }
+        if (options_of_assembler.dependency_file != NULL) {
+            write_output_if_changed(options_of_assembler.dependency_file, &rules_of_all_modules);
+        }
+        free_output_text(&rules_of_all_modules);
+        fflush(stdout);
+    }
+
+    fprintf(stderr, "stopped watching the files\n");
+    for (i = 0; i < amount_of_modules; i++) {
+        free_lexed_file(&modules[i].lexed_file);
+        free_source_dependencies(&modules[i].dependencies);
+    }
+    tracked_free(modules);
+    tracked_free(changed_modules);
+    stop_file_watcher(&watcher);
+    return 1;
+}
+
 /*
  * This function takes the number of input files and their names, 
  * iterates through each file, preprocesses the file and compiles it with using the compilation function,
@@ -529,13 +1299,38 @@ static int compilation_function(FILE * am_file, struct object_file * object, con
  *
  * @param amount_of_files The number of input files.
  * @param name_of_file An array of pointers to file names.
- * @return 0 if the assembly process completes successfully.
+ * @return 0 if the assembly process completes successfully, 1 if a file had errors with --check or --make-mlib.
  */
 int assembler(int amount_of_files, char ** name_of_file){
     int i; /* Loop counter */
     const char * am_name_of_file;
     FILE * am_file; /* Pointer to the am file */
+    struct am_line_source source; /* Where the compilation reads the lines of the am file from */
+    struct lexed_file lexed_file; /* The lines of the am file, when they are lexed in parallel */
     struct object_file current_object_file; 
+    struct line_origin_table origins_of_lines = {0}; /* The origins of the lines of the am file */
+    struct read_ahead read_ahead; /* The helper thread that reads the next input files */
+    int reading_ahead = 0; /* Set if the helper thread was started */
+    struct preloaded_source preloaded; /* The current input file, if it was read ahead of time */
+    struct input_list inputs; /* The arguments after response files, directories and patterns were expanded */
+    int taken_arguments; /* The number of arguments an option took */
+    int assembled; /* Set if the current file was assembled without errors */
+    int files_with_errors = 0; /* The number of files that weren't assembled */
+    struct source_dependencies dependencies = {0}; /* The files the current module was assembled from, with -MD */
+    struct output_text rules_of_all_modules = {0}; /* The make rules of all the modules, with -MF */
+    struct source_dependencies *dependencies_of_file; /* Where the preprocessor adds the files it reads, NULL without -MD */
+    struct object_archive archive = {0}; /* The outputs of the assembled modules, with --archive */
+    struct object_archive *archive_of_modules; /* Where the outputs of every assembled module are added, NULL without --archive */
+    double start_of_file; /* The time the assembly of the current file started, for the trace */
+    double start_of_phase; /* The time the current phase of the file started, for the trace */
+
+    /* Expand the response files, directories and patterns in to base names */
+    if (!expand_input_arguments(amount_of_files, name_of_file, &inputs))
+    {
+        return 0;
+    }
+    amount_of_files = inputs.amount_of_names;
+    name_of_file = inputs.arguments;
     
    /* Iterate through the list of input files */
    for(i = 0; i < amount_of_files; i++){
@@ -545,7 +1340,73 @@ int assembler(int amount_of_files, char ** name_of_file){
            /* If the current file name is NULL than skip to the next iteration */
            continue;
         }
+        /* Checks if the current argument is an option */
+        if (name_of_file[i][0] == '-')
+        {
+           taken_arguments = parse_option(name_of_file[i], i + 1 < amount_of_files ? name_of_file[i + 1] : NULL);
+           if (taken_arguments == 0)
+           {
+              fprintf(stderr, "unknown option: %s\n", name_of_file[i]);
+              taken_arguments = 1;
+           }
+           /* Options and their values are not files, so skip them when assembling */
+           for (; taken_arguments > 0; taken_arguments--, i++)
+           {
+              name_of_file[i] = NULL;
+           }
+           i--;
+        }
    }
+    /* An archive that is read is not assembled, the arguments are the symbols to find or the members to extract */
+    if (options_of_assembler.archive_action != 0)
+    {
+        if (options_of_assembler.object_archive == NULL)
+        {
+            fprintf(stderr, "the options --find and --extract need --archive FILE\n");
+            assembled = 0;
+        }
+        else if (options_of_assembler.archive_action == ARCHIVE_FIND)
+        {
+            assembled = find_archive_exports(options_of_assembler.object_archive, name_of_file, amount_of_files);
+        }
+        else
+        {
+            assembled = extract_archive_members(options_of_assembler.object_archive, name_of_file, amount_of_files);
+        }
+        free_input_list(&inputs);
+        return !assembled;
+    }
+    /* The blocks from before are the list of the inputs, it is freed at the end like the rest */
+    if (options_of_assembler.report_memory_leaks)
+    {
+        start_memory_leak_tracking();
+    }
+    else if (options_of_assembler.print_memory_statistics)
+    {
+        start_memory_statistics();
+    }
+    if (options_of_assembler.trace_file != NULL)
+    {
+        start_trace();
+    }
+    /* Map the macro libraries once, their macros are shared by all the files */
+    for (i = 0; i < options_of_assembler.amount_of_macro_libraries; i++)
+    {
+        load_macro_library(options_of_assembler.macro_libraries[i]);
+    }
+    /* In --watch the files are assembled by the watcher, as long as it runs */
+    if (options_of_assembler.watch_files && !options_of_assembler.make_macro_library && watch_input_files(name_of_file, amount_of_files))
+    {
+        amount_of_files = 0;
+    }
+    /* Read the next input files while the current one is assembled, if it was requested */
+    if (options_of_assembler.files_to_read_ahead > 0 && !options_of_assembler.make_macro_library)
+    {
+        reading_ahead = start_read_ahead(&read_ahead, name_of_file, amount_of_files, options_of_assembler.files_to_read_ahead);
+    }
+    dependencies_of_file = options_of_assembler.write_dependency_files ? &dependencies : NULL;
+    archive_of_modules = options_of_assembler.object_archive != NULL && !options_of_assembler.check_level && !options_of_assembler.make_macro_library &&
+                         !options_of_assembler.watch_files ? &archive : NULL;
     /* Iterate through the list of input files again */
     for(i = 0; i < amount_of_files; i++){
         /* Checks if the current file name is NULL */
@@ -553,8 +1414,51 @@ int assembler(int amount_of_files, char ** name_of_file){
         {
            continue;
         }
-        /* Preprocess the am file name */
-        am_name_of_file = file_preprocessor(name_of_file[i]); 
+        start_of_file = trace_clock();
+        /* A macro library is compiled from the macros of the file, the file is not assembled */
+        if (options_of_assembler.make_macro_library)
+        {
+            assembled = compile_macro_library(name_of_file[i], dependencies_of_file);
+            if (assembled && dependencies_of_file != NULL)
+            {
+                output_dependencies(name_of_file[i], FILE_EXTENSION_MLIB, &dependencies, &rules_of_all_modules);
+            }
+            free_source_dependencies(&dependencies);
+            files_with_errors += !assembled;
+            add_trace_span("compile_macro_library", name_of_file[i], start_of_file);
+            continue;
+        }
+        memset(&preloaded, 0, sizeof(preloaded));
+        if (reading_ahead)
+        {
+            /* The time the file takes to arrive is the time the disk was slower than the assembly */
+            start_of_phase = trace_clock();
+            take_preloaded_source(&read_ahead, i, &preloaded);
+            add_trace_span("wait for read ahead", name_of_file[i], start_of_phase);
+        }
+        /* The optimizer needs the whole am file, so it isn't pipelined */
+        if (options_of_assembler.pipeline && !options_of_assembler.optimize &&
+            assemble_file_in_pipeline(name_of_file[i], &origins_of_lines, preloaded.is_loaded ? &preloaded : NULL, dependencies_of_file, &assembled))
+        {
+            if (assembled && !options_of_assembler.check_level && dependencies_of_file != NULL)
+            {
+                output_dependencies(name_of_file[i], FILE_EXTENSION_OB, &dependencies, &rules_of_all_modules);
+            }
+            if (assembled && archive_of_modules != NULL)
+            {
+                add_archive_member(archive_of_modules, name_of_file[i]);
+            }
+            free_source_dependencies(&dependencies);
+            files_with_errors += !assembled;
+            free_line_origin_table(&origins_of_lines);
+            add_trace_span("assemble file", name_of_file[i], start_of_file);
+            continue;
+        }
+        assembled = 0;
+        /* Preprocess the am file name, the preloaded source is empty if the pipeline already took it */
+        start_of_phase = trace_clock();
+        am_name_of_file = file_preprocessor(name_of_file[i], &origins_of_lines, NULL, preloaded.is_loaded ? &preloaded : NULL, dependencies_of_file); 
+        add_trace_span("file_preprocessor", name_of_file[i], start_of_phase);
         /* Checks if preprocessing was successful */
         if (am_name_of_file)
         {
@@ -563,25 +1467,89 @@ int assembler(int amount_of_files, char ** name_of_file){
             /* Checks if the file was opened successfully */
             if (am_file)
             {
+                memset(&source, 0, sizeof(source));
+                source.am_file = am_file;
+                /* Lex the lines in parallel if it was requested, the optimizer reads the am file itself */
+                start_of_phase = trace_clock();
+                if (options_of_assembler.amount_of_jobs > 1 && !options_of_assembler.optimize && lex_am_file_in_parallel(am_file, options_of_assembler.amount_of_jobs, &lexed_file))
+                {
+                    source.lexed_file = &lexed_file;
+                    add_trace_span("lex_am_file_in_parallel", name_of_file[i], start_of_phase);
+                }
                 /* Create a new object file structure */
                 current_object_file = assembler_new_object_file();
                 /* Compile the am file with using the compilation function */
-                if (compilation_function(am_file, &current_object_file, am_name_of_file) == 1) 
+                assembled = compilation_function(&source, &current_object_file, am_name_of_file, &origins_of_lines) == 1;
+                /* A file that is only checked has no output files */
+                if (assembled && !options_of_assembler.check_level) 
+                {
+                    output_assembled_file(name_of_file[i], &current_object_file);
+                    if (dependencies_of_file != NULL)
+                    {
+                        output_dependencies(name_of_file[i], FILE_EXTENSION_OB, &dependencies, &rules_of_all_modules);
+                    }
+                    if (archive_of_modules != NULL)
+                    {
+                        add_archive_member(archive_of_modules, name_of_file[i]);
+                    }
+                }
+                else
                 {
-                     /* Output the relevent files */
-                    output(name_of_file[i], &current_object_file);
+                    output_report_of_full_memory(name_of_file[i], &current_object_file);
+                }
+                if (source.lexed_file != NULL)
+                {
+                    free_lexed_file(&lexed_file);
                 }
                 /* Close the am file */
                 fclose(am_file);
                 /* Delete the object file structure */
                 assembler_delete_object_file(&current_object_file);
             }
-
-            
+            tracked_free((char *)am_name_of_file);
         }
-
+        files_with_errors += !assembled;
+        /* The origins of the lines and the dependencies belong to the file that was assembled */
+        free_line_origin_table(&origins_of_lines);
+        free_source_dependencies(&dependencies);
+        add_trace_span("assemble file", name_of_file[i], start_of_file);
+    }
+    if (reading_ahead)
+    {
+        stop_read_ahead(&read_ahead);
+    }
+    /* The rules of all the modules are written once, so make sees one complete file */
+    if (options_of_assembler.dependency_file != NULL)
+    {
+        write_output_if_changed(options_of_assembler.dependency_file, &rules_of_all_modules);
+        free_output_text(&rules_of_all_modules);
+    }
+    /* The archive is written once, with the modules in the order they were given */
+    if (archive_of_modules != NULL)
+    {
+        write_object_archive(options_of_assembler.object_archive, archive_of_modules);
+        free_object_archive(archive_of_modules);
+    }
+    /* The names of the files of the trace were copied, but the name of the trace is an argument */
+    if (options_of_assembler.trace_file != NULL)
+    {
+        write_trace(options_of_assembler.trace_file);
+        free_trace();
+    }
+    free_input_list(&inputs);
+    free_included_files();
+    free_macro_libraries();
+    deallocate_memory();
+    if (options_of_assembler.print_memory_statistics)
+    {
+        print_memory_statistics();
+    }
+    if (options_of_assembler.report_memory_leaks && print_memory_leaks() > 0)
+    {
+        fprintf(stderr, "some memory was not freed\n");
     }
-    return 0;
+    /* A check or a macro library tells the caller if the files have errors */
+    return (options_of_assembler.check_level || options_of_assembler.make_macro_library) && files_with_errors > 0;
 }
 
 
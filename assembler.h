@@ -6,6 +6,23 @@
 #include "preprocessor.h"
 #include "output_unit.h"
 #include "linked_list.h"
+#include "emulator.h"
+#include "translator.h"
+#include "source_map.h"
+#include "report.h"
+#include "constant_pool.h"
+#include "optimizer.h"
+#include "interner.h"
+#include "pipeline.h"
+#include "parallel_lexer.h"
+#include "encoding_table.h"
+#include "program_ir.h"
+#include "input_files.h"
+#include "macro_library.h"
+#include "dependency_file.h"
+#include "file_watcher.h"
+#include "object_archive.h"
+#include "trace_events.h"
 
 #define MAX_LENGTH_OF_LINE 81 
 #define BEGINNING_ADDRESS 100
@@ -22,7 +39,7 @@
  *
  * @param amount_of_files The number of input files.
  * @param name_of_file An array of pointers to file names.
- * @return 0 if the assembly process completes successfully.
+ * @return 0 if the assembly process completes successfully, 1 if a file had errors with --check or --make-mlib.
  */
 int assembler(int amount_of_files, char ** name_of_file);
 
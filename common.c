@@ -2,10 +2,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "common.h"
+#include "source_map.h"
+#include "interner.h"
+#include "program_ir.h"
 
-CertainExternNode *insert_certain_extern_to_linked_list(CertainExternLinkedList **list, struct certain_extern *extern_data);
-CertainExternLinkedList *new_linked_list_certain_extern(const char *name_of_extern, long address_of_extern);
-void free_certain_extern_linked_list(CertainExternLinkedList **list);
 void free_symbol_linked_list(SymbolLinkedList **list);
 
 const char * string_type_of_symbol[6] = {
@@ -17,12 +17,14 @@ const char * string_type_of_symbol[6] = {
      "entry data symbol" /* [symbol_entry_data] */
 };
 
+struct assembler_options options_of_assembler = {0};
+
 
 /*
  * Creates a new object file.
  *
  * This function initializes a new object_file structure with default values.
- * It creates an empty linked list of certain external symbols and sets the
+ * It starts with an empty table of extern uses and sets the
  * instruction counter (IC) and data counter (DC) to zero.
  *
  * @return An initialized object_file structure.
@@ -30,8 +32,6 @@ const char * string_type_of_symbol[6] = {
 struct object_file assembler_new_object_file() {
     struct object_file obj = {0}; 
     
-    /* Create an empty linked list of certain external symbols */
-    obj.name_and_addresses_certain_extern = new_linked_list_certain_extern("", 0); 
     /* Initialize instruction counter (IC) and data counter (DC) to zero */
     obj.IC = 0;
     obj.DC = 0;
@@ -44,62 +44,203 @@ struct object_file assembler_new_object_file() {
  * Deletes an object file and frees associated memory.
  *
  * This function frees memory associated with an object_file structure,
- * including the linked lists of certain external symbols and symbols.
+ * including the table of extern uses, the table of relocations, the linked list of symbols, the names of the symbols and the source map.
  *
  * @param obj_file A pointer to the object_file structure to be deleted.
  */
 void assembler_delete_object_file(struct object_file *obj_file) {  
-    /* Free memory for the linked list of certain external symbols */
-    free_certain_extern_linked_list(&(obj_file->name_and_addresses_certain_extern));
+    /* Free memory for the table of extern uses */
+    tracked_free(obj_file->extern_uses.uses);
+    memset(&obj_file->extern_uses, 0, sizeof(struct extern_use_table));
+    /* Free memory for the table of relocations */
+    tracked_free(obj_file->relocations.offsets);
+    memset(&obj_file->relocations, 0, sizeof(struct relocation_table));
     /* Free memory for the linked list of symbols */
     free_symbol_linked_list(&obj_file->table_of_symbols);
+    /* Free memory for the names of the symbols */
+    free_symbol_interner(&obj_file->interned_symbols);
+    /* Free memory for the source map */
+    free_source_map(&obj_file->map_of_sources);
+    /* Free memory for the instructions */
+    free_instruction_ir(&obj_file->instructions);
 }
 
 /*
- * Adds a new external symbol to the linked list of certain extern symbols.
+ * Adds a use of an external symbol to the table of extern uses.
  *
- * This function creates a new extern symbol with the provided name and address,
- * and inserts it into the linked list of certain extern symbols. If the list does not
- * exist, a new list is created. 
+ * This function appends the id of the external symbol and the address of the use to the table.
  *
- * @param extern_list A pointer to a pointer to the linked list of certain external symbols.
- * @param name_of_extern The name of the external symbol to be added.
- * @param address_of_extern The address associated with the external symbol.
+ * @param extern_uses A pointer to the table of extern uses.
+ * @param id_of_extern The id of the name of the external symbol.
+ * @param address_of_extern The address of the word that uses the external symbol.
  */
-void add_external_symbol(CertainExternLinkedList **extern_list, const char *name_of_extern, long address_of_extern) {
-    struct certain_extern *new_extern;
-    
-    /* Check if the extern symbol list pointer is NULL */
-    if (extern_list == NULL) {
+void add_external_symbol(struct extern_use_table *extern_uses, unsigned int id_of_extern, long address_of_extern) {
+    struct extern_use *bigger_uses;
+    size_t new_capacity;
+
+    /* Check if the table pointer is NULL */
+    if (extern_uses == NULL) {
         return;
     }
 
-    
-    if (*extern_list == NULL) {
-        /* Create a new linked list for extern symbols */
-        *extern_list = new_linked_list_certain_extern(name_of_extern, address_of_extern);
-        if (*extern_list == NULL) {
-            fprintf(stderr, "wasn't able to create an external symbol list\n");
+    /* Append the use to the table */
+    if (extern_uses->amount_of_uses == extern_uses->capacity_of_uses) {
+        new_capacity = extern_uses->capacity_of_uses ? extern_uses->capacity_of_uses * 2 : 16;
+        bigger_uses = (struct extern_use *)tracked_realloc(extern_uses->uses, new_capacity * sizeof(struct extern_use), MEMORY_EXTERNS);
+        if (bigger_uses == NULL) {
+            fprintf(stderr, "wasn't able to allocate memory for the uses of the external symbols\n");
             return;
         }
+        extern_uses->uses = bigger_uses;
+        extern_uses->capacity_of_uses = new_capacity;
     }
+    extern_uses->uses[extern_uses->amount_of_uses].id_of_symbol = id_of_extern;
+    extern_uses->uses[extern_uses->amount_of_uses].address = (unsigned int)address_of_extern;
+    extern_uses->amount_of_uses++;
+}
 
-    /* Allocate memory for the new external symbol structure */
-    new_extern = (struct certain_extern *)malloc(sizeof(struct certain_extern));
-    if (new_extern == NULL) {
-        fprintf(stderr, "wasn't able to allocate memory for new external symbol\n");
-        return;
+/*
+ * Compares two uses of external symbols by their symbol and address, for qsort.
+ *
+ * @param first A pointer to the first use.
+ * @param second A pointer to the second use.
+ * @return A negative number, zero or a positive number if the first use comes before, with or after the second.
+ */
+static int compare_extern_uses(const void *first, const void *second) {
+    const struct extern_use *first_use = (const struct extern_use *)first;
+    const struct extern_use *second_use = (const struct extern_use *)second;
+
+    if (first_use->id_of_symbol != second_use->id_of_symbol) {
+        return first_use->id_of_symbol < second_use->id_of_symbol ? -1 : 1;
+    }
+    return (first_use->address > second_use->address) - (first_use->address < second_use->address);
+}
+
+/*
+ * Groups the uses of the table of extern uses by symbol.
+ *
+ * The uses are sorted by the id of their symbol, which is the order the symbols first appear in the file,
+ * and by their address within every symbol.
+ *
+ * @param extern_uses A pointer to the table of extern uses.
+ */
+void group_extern_uses(struct extern_use_table *extern_uses) {
+    if (extern_uses->amount_of_uses > 1) {
+        qsort(extern_uses->uses, extern_uses->amount_of_uses, sizeof(struct extern_use), compare_extern_uses);
+    }
+}
+
+/*
+ * Adds a word that holds a relocatable address to the table of relocations.
+ *
+ * @param relocations A pointer to the table of relocations.
+ * @param offset_in_code The offset of the word in the code image.
+ */
+void add_relocation(struct relocation_table *relocations, long offset_in_code) {
+    unsigned int *bigger_offsets;
+    size_t new_capacity;
+
+    /* Append the offset to the table */
+    if (relocations->amount_of_offsets == relocations->capacity_of_offsets) {
+        new_capacity = relocations->capacity_of_offsets ? relocations->capacity_of_offsets * 2 : 16;
+        bigger_offsets = (unsigned int *)tracked_realloc(relocations->offsets, new_capacity * sizeof(unsigned int), MEMORY_CODE);
+        if (bigger_offsets == NULL) {
+            fprintf(stderr, "wasn't able to allocate memory for the relocations\n");
+            return;
+        }
+        relocations->offsets = bigger_offsets;
+        relocations->capacity_of_offsets = new_capacity;
+    }
+    relocations->offsets[relocations->amount_of_offsets] = (unsigned int)offset_in_code;
+    relocations->amount_of_offsets++;
+}
+
+/*
+ * Compares two offsets of relocatable words, for qsort.
+ *
+ * @param first A pointer to the first offset.
+ * @param second A pointer to the second offset.
+ * @return A negative number, zero or a positive number if the first offset is smaller, equal or bigger than the second.
+ */
+static int compare_relocations(const void *first, const void *second) {
+    unsigned int first_offset = *(const unsigned int *)first;
+    unsigned int second_offset = *(const unsigned int *)second;
+
+    return (first_offset > second_offset) - (first_offset < second_offset);
+}
+
+/*
+ * Sorts the offsets of the table of relocations in ascending order.
+ *
+ * The words of the instructions are added in order, but the words that were left for symbols
+ * that weren't defined yet are added after them.
+ *
+ * @param relocations A pointer to the table of relocations.
+ */
+void sort_relocations(struct relocation_table *relocations) {
+    if (relocations->amount_of_offsets > 1) {
+        qsort(relocations->offsets, relocations->amount_of_offsets, sizeof(unsigned int), compare_relocations);
+    }
+}
+
+/*
+ * Creates the name of a file by appending an extension to a base name.
+ *
+ * @param base_name The base name of the file (without extension).
+ * @param extension The extension to append, including the dot.
+ * @return A dynamically allocated string with the file name, or NULL on memory allocation error.
+ * @note The caller is responsible for freeing the allocated memory using `tracked_free()`.
+ */
+char *create_file_name(const char *base_name, const char *extension) {
+    char *file_name = tracked_malloc(strlen(base_name) + strlen(extension) + 1, MEMORY_FILE_NAMES);
+    if (file_name == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the name of a file\n");
+        return NULL;
     }
-    /* Copy the provided name of the extern symbol in to the structure */
-    strncpy(new_extern->name_of_extern, name_of_extern, LABEL_MAX_LENGTH);
-    /* Ensure null-termination */
-    new_extern->name_of_extern[LABEL_MAX_LENGTH] = '\0'; 
+    /* Copy the base name and append the extension */
+    strcpy(file_name, base_name);
+    strcat(file_name, extension);
+    return file_name;
+}
 
-    /* Set the address of the extern symbol in the structure */ 
-    new_extern->address_of_extern = address_of_extern;
+/*
+ * Adds bytes to an FNV-1a hash.
+ *
+ * @param hash The hash so far, FNV1A_OFFSET_BASIS for a new hash.
+ * @param bytes The bytes to add.
+ * @param amount_of_bytes The number of bytes.
+ * @return The hash with the bytes.
+ */
+unsigned long add_to_fnv1a_hash(unsigned long hash, const unsigned char *bytes, size_t amount_of_bytes) {
+    size_t i;
 
-    /* Insert the new extern symbol into the linked list */
-    insert_certain_extern_to_linked_list(extern_list, new_extern);
+    for (i = 0; i < amount_of_bytes; i++) {
+        hash = ((hash ^ bytes[i]) * FNV1A_PRIME) & 0xFFFFFFFFUL;
+    }
+    return hash;
 }
 
+/*
+ * Writes a number to a buffer in little endian order.
+ *
+ * @param buffer The buffer to write to.
+ * @param value The number to write.
+ * @param size The number of bytes to write.
+ */
+void put_little_endian(unsigned char *buffer, unsigned long value, int size) {
+    int i;
 
+    for (i = 0; i < size; i++) {
+        buffer[i] = (unsigned char)((value >> (8 * i)) & 0xFF);
+    }
+}
+
+/*
+ * Reads a number of 4 bytes in little endian order.
+ *
+ * @param buffer The buffer to read from.
+ * @return The number.
+ */
+unsigned long get_little_endian(const unsigned char *buffer) {
+    return (unsigned long)buffer[0] | ((unsigned long)buffer[1] << 8) | ((unsigned long)buffer[2] << 16) | ((unsigned long)buffer[3] << 24);
+}
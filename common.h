@@ -2,11 +2,20 @@
 #define __COMMON_H_
 
 #include <stddef.h>
+#include "memory_tracker.h"
 
 #define MAX_STRING_LENGTH 81
 #define MAX_LENGTH_OF_MACRO 31
 #define LABEL_MAX_LENGTH 31
 #define MEMORY_SIZE 1024 
+#define MAX_INCLUDE_DIRECTORIES 32
+#define MAX_MACRO_LIBRARIES 16
+#define FIRST_SYMBOL_INTERNER_BUCKETS 256
+#define NO_SYMBOL_ID 0
+#define FNV1A_OFFSET_BASIS 2166136261UL
+#define FNV1A_PRIME 16777619UL
+#define CHECK_SYNTAX 1
+#define CHECK_SEMANTICS 2
 
 #define SPACE_CHARS " \t\n\f\r\v"
 #define SKIP_SPACE(str) while(*str && isspace(*str)) str++
@@ -16,17 +25,14 @@
 typedef struct macro_node NodeMacro;
 typedef struct macro_linked_list MacroLinkedList;
 typedef struct symbols_that_were_not_found_at_first SymbolsNotFoundData;
-typedef struct certain_extern_node CertainExternNode;
 typedef struct symbols_not_found_node SymbolsNotFoundNode;
 typedef struct symbol_not_found_linked_list SymbolsNotFoundLinkedList;
 typedef struct string_node StringNode;
 typedef struct symbol_node SymbolNode;
-typedef struct certain_extern_linked_list CertainExternLinkedList;
 typedef struct symbol_linked_list SymbolLinkedList;
 typedef struct string_linked_list StringLinkedList;
 
 struct symbol;
-struct certain_extern;
 struct macro;
 
 struct symbol {  
@@ -40,7 +46,7 @@ struct symbol {
     }type_of_symbol;
     unsigned int address_of_symbol; /* The address of the symbol */
     unsigned int line_of_declaration; /* The line where the symbol was declared */
-    char name_of_symbol[LABEL_MAX_LENGTH + 1]; /* The name of the symbol */
+    unsigned int id_of_symbol; /* The id of the name of the symbol in the interner of the file */
 };
 
 /* Represents a node in the macro linked list */
@@ -96,16 +102,36 @@ struct symbol_linked_list {
     size_t size_of_linked_list; /* The size of the linked list */
 };
 
-/* Represents a node in the certain extern linked list */
-struct certain_extern_node { 
-    struct certain_extern *data; /* The data of the node */
-    struct certain_extern_node *next; /* The next node in the linked list */
+/* Represents a use of an external symbol in the code image */
+struct extern_use {
+    unsigned int id_of_symbol; /* The id of the name of the symbol in the interner of the file */
+    unsigned int address; /* The address of the word that uses the symbol */
 };
-/* Represents a linked list of certain externs */
-struct certain_extern_linked_list {
-    struct certain_extern_node *head; /* The head node of the linked list */
-    struct certain_extern_node *tail; /* The tail node of the linked list */
-    size_t size_of_linked_list; /* The size of the linked list */
+
+/* Represents the instructions of a file as parallel arrays, the elements of every instruction have the same index */
+struct instruction_ir {
+    unsigned char *opcodes; /* The opcode of every instruction */
+    unsigned char *operand_modes[2]; /* The addressing mode of the source and destination operands, 0 if there is no operand */
+    int *operand_values[2]; /* The constant or the number of the register of every operand */
+    unsigned int *operand_ids[2]; /* The id of the label of every operand, NO_SYMBOL_ID for other operands */
+    int *lines; /* The number of the line of the am file every instruction is in */
+    long *addresses; /* The offset of the first word of every instruction in the code image */
+    size_t amount_of_instructions; /* The number of instructions */
+    size_t capacity_of_instructions; /* The number of instructions there is room for */
+};
+
+/* Represents all the uses of external symbols, in one array that is grouped by symbol once it is sorted */
+struct extern_use_table {
+    struct extern_use *uses; /* The uses of the external symbols */
+    size_t amount_of_uses; /* The number of uses */
+    size_t capacity_of_uses; /* The number of uses there is room for */
+};
+
+/* Represents the words of the code image that hold the address of a symbol of the file, so they change with the base address */
+struct relocation_table {
+    unsigned int *offsets; /* The offset of every relocatable word in the code image, sorted once the file is assembled */
+    size_t amount_of_offsets; /* The number of offsets */
+    size_t capacity_of_offsets; /* The number of offsets there is room for */
 };
 
 
@@ -126,33 +152,147 @@ typedef struct code_w {
 
 /* Represents symbols that were not found at first */
 struct symbols_that_were_not_found_at_first {
-    char name_of_symble[LABEL_MAX_LENGTH + 1]; /* The name of the symbol */
+    unsigned int id_of_symbol; /* The id of the name of the symbol in the interner of the file */
     int line_it_was_called; /* The line where the symbol was called */
     unsigned int machine_word; /* The machine word */
     unsigned int address_of_calling; /* The address of calling */
 };
 
+/* Represents the origin of a line of the am file in the source file */
+struct line_origin {
+    unsigned int line_in_source; /* The line of the source file the line was written from */
+    unsigned int line_of_calling; /* The line of the macro call the line was expanded from, 0 if it is not from a macro */
+    char name_of_macro[MAX_LENGTH_OF_MACRO + 1]; /* The macro the line was expanded from, empty if it is not from a macro */
+};
+
+/* Represents the origins of the lines of an am file, in the order of the am file */
+struct line_origin_table {
+    struct line_origin *origins; /* The origin of every line */
+    size_t amount_of_lines; /* The number of lines in the table */
+    size_t capacity; /* The number of lines the table has room for */
+};
+
+/* Represents the files a module was assembled from, for its dependency file */
+struct source_dependencies {
+    char **paths; /* The paths of the files, the source file first */
+    size_t amount_of_paths; /* The number of paths */
+    size_t capacity; /* The number of paths there is room for */
+};
+
+/* Represents a range of addresses and the source it was assembled from */
+struct source_map_record {
+    unsigned int first_address; /* The address of the first word of the range */
+    unsigned int end_address; /* The address right after the last word of the range */
+    unsigned int line_in_source; /* The line of the source file the words were assembled from */
+    unsigned int line_of_calling; /* The line of the macro call the words were expanded from, 0 if they are not from a macro */
+    int is_data; /* 1 if the words are in the data image, 0 if they are in the code image */
+    char name_of_label[LABEL_MAX_LENGTH + 1]; /* The last label that was defined before the words, empty if there is none */
+    char name_of_macro[MAX_LENGTH_OF_MACRO + 1]; /* The macro the words were expanded from, empty if they are not from a macro */
+};
+
+/* Represents the map from the addresses of an object file to its source */
+struct source_map {
+    struct source_map_record *records; /* The records of the map, sorted by address once the map is finished */
+    size_t amount_of_records; /* The number of records in the map */
+    size_t capacity; /* The number of records the map has room for */
+};
+
+/* Represents the names of the symbols of a file, every name is stored once and has an integer id */
+struct symbol_interner {
+    char (*names)[LABEL_MAX_LENGTH + 1]; /* The name of every id, the name of NO_SYMBOL_ID is empty */
+    struct symbol **symbols; /* The symbol of the symbol table every id stands for, NULL if there is none yet */
+    unsigned int *next_in_bucket; /* The next id with the same hash, NO_SYMBOL_ID at the end of the bucket */
+    unsigned int amount_of_ids; /* The number of ids, including NO_SYMBOL_ID */
+    unsigned int capacity_of_ids; /* The number of ids there is room for */
+    unsigned int *buckets; /* The last id of every hash, NO_SYMBOL_ID if there is none */
+    unsigned int amount_of_buckets; /* The number of buckets, it grows with the number of ids */
+};
+
 /* Represents a object file */
 struct object_file {
     code_w code_image[MEMORY_SIZE]; /* Contains the code image of the file */
     data_w data_image[MEMORY_SIZE]; /* Contains the data image of the file */
     long IC; /* The Instruction Counter */
     long DC; /* The Data Counter */
-    CertainExternLinkedList *name_and_addresses_certain_extern; /* A Linked list of certain externs */
+    struct extern_use_table extern_uses; /* The uses of external symbols in the code image */
+    struct relocation_table relocations; /* The words of the code image that hold a relocatable address */
     SymbolLinkedList *table_of_symbols; /* A Linked list of symbols */
+    struct symbol_interner interned_symbols; /* The names of the symbols of the file, by their ids */
+    struct instruction_ir instructions; /* The instructions of the code image, they are encoded after the whole file was read */
     int number_of_entries; /* the number of entry symbols */
+    struct source_map map_of_sources; /* The source every word of the code and data images was assembled from */
+    long pooled_constants; /* The number of constants that were pooled with an identical one */
+    long words_saved_by_pool; /* The number of data words the pooled constants would have taken */
+    long optimized_out_instructions; /* The number of instructions the peephole optimizer removed */
+    long words_saved_by_optimizer; /* The number of code words the removed instructions would have taken */
+    int memory_is_full; /* Set if the images grew beyond the memory, the rest of the lines are only counted */
+    long code_words_beyond_memory; /* The number of code words of the lines after the memory was full */
+    long data_words_beyond_memory; /* The number of data words of the lines after the memory was full */
 };
 
-/* Represents a certain extern */
-struct certain_extern {
-    char name_of_extern[LABEL_MAX_LENGTH + 1]; /* The name of the extern */
-    long address_of_extern; /* The address of the extern */
+/* Represents the command-line options that were given to the assembler */
+struct assembler_options {
+    int emit_c; /* Write a C translation of every assembled program (--emit-c) */
+    int run_program; /* Run every assembled program in the emulator (--run) */
+    int differential_test; /* Compare the C translation against the emulator (--diff-test) */
+    int output_map; /* Write the map from addresses to source lines (--map) */
+    int output_report; /* Write the resource report of every module as text and JSON (--report) */
+    int pool_constants; /* Keep one copy of identical labeled .string and .data constants (--pool) */
+    int print_statistics; /* Print the statistics of every assembled module (--stats) */
+    int optimize; /* Run the peephole optimizer before the instructions are encoded (-O) */
+    int group_extern_output; /* Write every external symbol once in the .ext file, with all its addresses (--ext-grouped) */
+    int pipeline; /* Preprocess, lex and compile every file in three threads (--pipeline) */
+    int files_to_read_ahead; /* The number of input files a helper thread reads before they are assembled, 0 for none (--read-ahead=K) */
+    int amount_of_jobs; /* The number of threads that lex every file, 0 if the lines are lexed while they are compiled (--jobs=N) */
+    const char *output_directory; /* The directory the output files are written to, NULL for next to the inputs (-o DIR) */
+    int check_level; /* CHECK_SYNTAX or CHECK_SEMANTICS to only print the diagnostics, 0 to assemble (--check) */
+    const char *include_directories[MAX_INCLUDE_DIRECTORIES]; /* The directories .include searches after the directory of the including file (-I DIR) */
+    int amount_of_include_directories; /* The number of include directories */
+    const char *macro_libraries[MAX_MACRO_LIBRARIES]; /* The .mlib files whose macros every file can call (-L FILE) */
+    int amount_of_macro_libraries; /* The number of macro libraries */
+    int make_macro_library; /* Compile the macros of every file in to a .mlib file instead of assembling it (--make-mlib) */
+    int write_dependency_files; /* Write the files every module was assembled from as a make rule (-MD) */
+    const char *dependency_file; /* The file that receives the rules of all the modules, NULL for a .d file next to every output (-MF FILE) */
+    int watch_files; /* Assemble the files again whenever they or the files they were assembled from change (--watch) */
+    int output_relocations; /* Write the offsets of the relocatable words of the code image (--reloc) */
+    const char *object_archive; /* The archive the outputs of the assembled modules are packed in to, or that is read (--archive FILE) */
+    int archive_action; /* ARCHIVE_FIND or ARCHIVE_EXTRACT to read the archive instead of assembling, 0 to pack it (--find, --extract) */
+    const char *trace_file; /* The JSON file that receives the trace events of the run, NULL for no trace (--trace FILE) */
+    int print_memory_statistics; /* Print the allocations and the bytes of every owner of memory at the end of the run (--mem-stats) */
+    int report_memory_leaks; /* Print the blocks that were never freed at the end of the run (--mem-leaks) */
+};
+
+/* Represents a piece of the expansion template of a macro */
+struct macro_piece {
+    size_t offset_in_source; /* The offset of the text of the piece in the text of the source file */
+    size_t length; /* The number of characters of the text of the piece, 0 for a parameter */
+    int index_of_parameter; /* The parameter the piece is replaced with, starting at 0, or -1 for text */
+};
+
+/* Represents a line of the expansion template of a macro */
+struct macro_template_line {
+    size_t first_piece; /* The index of the first piece of the line */
+    size_t amount_of_pieces; /* The number of pieces of the line, for a call of a macro these are its arguments */
+    unsigned int line_in_source; /* The line of the source file the line was defined in */
+    int ends_line; /* 1 if the line ends with a new line */
+    struct macro *called_macro; /* The macro the line calls, NULL if the line is written as it is */
 };
 
 /* Represents a macro */
 struct macro {
     char name_of_macro[MAX_LENGTH_OF_MACRO + 1]; /* The name of the macro */
-    StringLinkedList *lines_of_code; /* Linked list of lines of code in the macro */
+    size_t offset_of_body; /* The offset of the lines of code of the macro in the text of the source file */
+    size_t length_of_body; /* The number of characters of the lines of code of the macro */
+    unsigned int *lines_in_source; /* The line of the source file every line of code was defined in */
+    size_t amount_of_lines; /* The number of lines of code in the macro */
+    struct macro_piece *pieces; /* The pieces of the expansion template */
+    size_t amount_of_pieces; /* The number of pieces of the expansion template */
+    struct macro_template_line *template_lines; /* The lines of the expansion template */
+    size_t amount_of_template_lines; /* The number of lines of the expansion template */
+    int amount_of_parameters; /* The number of parameters, the highest %n in the body */
+    unsigned long amount_of_expansions; /* The number of times the macro was expanded */
+    const char *source_text; /* The text of the source file the macro was defined in, the pieces point in to it */
+    int is_included; /* Set if the macro was defined in an included file, its template belongs to the cache of included files */
 };
 
 
@@ -160,7 +300,7 @@ struct macro {
  * Deletes an object file and frees associated memory.
  *
  * This function frees memory associated with an object_file structure,
- * including the linked lists of certain external symbols and symbols.
+ * including the table of extern uses, the table of relocations, the linked list of symbols, the names of the symbols and the source map.
  *
  * @param obj_file A pointer to the object_file structure to be deleted.
  */
@@ -168,29 +308,95 @@ void assembler_delete_object_file(struct object_file * obj_file);
 
 
 /*
- * Adds a new external symbol to the linked list of certain extern symbols.
+ * Adds a use of an external symbol to the table of extern uses.
+ *
+ * This function appends the id of the external symbol and the address of the use to the table.
+ *
+ * @param extern_uses A pointer to the table of extern uses.
+ * @param id_of_extern The id of the name of the external symbol.
+ * @param address_of_extern The address of the word that uses the external symbol.
+ */
+void add_external_symbol(struct extern_use_table *extern_uses, unsigned int id_of_extern, long address_of_extern);
+
+/*
+ * Groups the uses of the table of extern uses by symbol.
  *
- * This function creates a new extern symbol with the provided name and address,
- * and inserts it into the linked list of certain extern symbols. If the list does not
- * exist, a new list is created. 
+ * The uses are sorted by the id of their symbol, which is the order the symbols first appear in the file,
+ * and by their address within every symbol.
  *
- * @param extern_list A pointer to a pointer to the linked list of certain external symbols.
- * @param name_of_extern The name of the external symbol to be added.
- * @param address_of_extern The address associated with the external symbol.
+ * @param extern_uses A pointer to the table of extern uses.
  */
-void add_external_symbol(CertainExternLinkedList **extern_list, const char *name_of_extern, long address_of_extern);
+void group_extern_uses(struct extern_use_table *extern_uses);
+
+/*
+ * Adds a word that holds a relocatable address to the table of relocations.
+ *
+ * @param relocations A pointer to the table of relocations.
+ * @param offset_in_code The offset of the word in the code image.
+ */
+void add_relocation(struct relocation_table *relocations, long offset_in_code);
+
+/*
+ * Sorts the offsets of the table of relocations in ascending order.
+ *
+ * The words of the instructions are added in order, but the words that were left for symbols
+ * that weren't defined yet are added after them.
+ *
+ * @param relocations A pointer to the table of relocations.
+ */
+void sort_relocations(struct relocation_table *relocations);
 
 /*
  * Creates a new object file.
  *
  * This function initializes a new object_file structure with default values.
- * It creates an empty linked list of certain external symbols and sets the
+ * It starts with an empty table of extern uses and sets the
  * instruction counter (IC) and data counter (DC) to zero.
  *
  * @return An initialized object_file structure.
  */
 struct object_file assembler_new_object_file();
 
+/*
+ * Creates the name of a file by appending an extension to a base name.
+ *
+ * @param base_name The base name of the file (without extension).
+ * @param extension The extension to append, including the dot.
+ * @return A dynamically allocated string with the file name, or NULL on memory allocation error.
+ * @note The caller is responsible for freeing the allocated memory using `tracked_free()`.
+ */
+char *create_file_name(const char *base_name, const char *extension);
+
+/*
+ * Adds bytes to an FNV-1a hash.
+ *
+ * @param hash The hash so far, FNV1A_OFFSET_BASIS for a new hash.
+ * @param bytes The bytes to add.
+ * @param amount_of_bytes The number of bytes.
+ * @return The hash with the bytes.
+ */
+unsigned long add_to_fnv1a_hash(unsigned long hash, const unsigned char *bytes, size_t amount_of_bytes);
+
+/*
+ * Writes a number to a buffer in little endian order.
+ *
+ * @param buffer The buffer to write to.
+ * @param value The number to write.
+ * @param size The number of bytes to write.
+ */
+void put_little_endian(unsigned char *buffer, unsigned long value, int size);
+
+/*
+ * Reads a number of 4 bytes in little endian order.
+ *
+ * @param buffer The buffer to read from.
+ * @return The number.
+ */
+unsigned long get_little_endian(const unsigned char *buffer);
+
+/* The options that were given to the assembler in the command line */
+extern struct assembler_options options_of_assembler;
+
 
 
 #endif
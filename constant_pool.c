@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "constant_pool.h"
+
+/*
+ * Computes the FNV-1a hash of words of the data image.
+ *
+ * @param data_image The data image.
+ * @param first_offset The offset of the first word.
+ * @param length The number of words.
+ * @return The hash of the words.
+ */
+static unsigned long hash_of_words(const data_w *data_image, long first_offset, long length) {
+    unsigned long hash = FNV1A_OFFSET_BASIS;
+    unsigned char bytes_of_word[2];
+    long i;
+
+    for (i = first_offset; i < first_offset + length; i++) {
+        /* Every word has 12 bits, so it is hashed as two bytes */
+        bytes_of_word[0] = (unsigned char)(data_image[i].data_word & 0xFF);
+        bytes_of_word[1] = (unsigned char)(data_image[i].data_word >> 8);
+        hash = add_to_fnv1a_hash(hash, bytes_of_word, 2);
+    }
+    return hash;
+}
+
+/*
+ * Checks if two ranges of words of the data image are identical.
+ *
+ * @param data_image The data image.
+ * @param first_offset The offset of the first range.
+ * @param second_offset The offset of the second range.
+ * @param length The number of words of both ranges.
+ * @return 1 if the ranges are identical, 0 otherwise.
+ */
+static int words_are_identical(const data_w *data_image, long first_offset, long second_offset, long length) {
+    long i;
+
+    for (i = 0; i < length; i++) {
+        if (data_image[first_offset + i].data_word != data_image[second_offset + i].data_word) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Pools the constant that was just added to the end of the data image.
+ *
+ * If an identical constant is already in the data image, the new copy is removed from the data image
+ * and the offset of the existing copy is returned, so the label of the new constant can alias it.
+ * Otherwise the constant is added to the pool.
+ *
+ * @param pool A pointer to the constant pool.
+ * @param object A pointer to the object file, the constant takes the words from first_offset to DC of its data image.
+ * @param first_offset The offset of the first word of the constant in the data image.
+ * @return The offset of the constant in the data image, or -1 on memory allocation error.
+ */
+long pool_data_constant(struct constant_pool *pool, struct object_file *object, long first_offset) {
+    long length = object->DC - first_offset;
+    unsigned long hash = hash_of_words(object->data_image, first_offset, length);
+    struct pooled_constant **bucket = &pool->buckets[hash % CONSTANT_POOL_BUCKETS];
+    struct pooled_constant *constant;
+    long i;
+
+    /* Look for an identical constant */
+    for (constant = *bucket; constant != NULL; constant = constant->next) {
+        if (constant->hash == hash && constant->length == length && words_are_identical(object->data_image, constant->offset, first_offset, length)) {
+            /* Remove the new copy from the data image */
+            for (i = first_offset; i < object->DC; i++) {
+                object->data_image[i].data_word = 0;
+            }
+            object->DC = first_offset;
+            object->pooled_constants++;
+            object->words_saved_by_pool += length;
+            return constant->offset;
+        }
+    }
+
+    /* This is the first copy of the constant */
+    constant = (struct pooled_constant *)tracked_malloc(sizeof(struct pooled_constant), MEMORY_CONSTANT_POOL);
+    if (constant == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the constant pool\n");
+        return -1;
+    }
+    constant->hash = hash;
+    constant->offset = first_offset;
+    constant->length = length;
+    constant->next = *bucket;
+    *bucket = constant;
+    return first_offset;
+}
+
+/*
+ * Frees the memory of a constant pool and leaves it empty.
+ *
+ * @param pool A pointer to the constant pool.
+ */
+void free_constant_pool(struct constant_pool *pool) {
+    struct pooled_constant *constant;
+    struct pooled_constant *next;
+    int i;
+
+    for (i = 0; i < CONSTANT_POOL_BUCKETS; i++) {
+        for (constant = pool->buckets[i]; constant != NULL; constant = next) {
+            next = constant->next;
+            tracked_free(constant);
+        }
+        pool->buckets[i] = NULL;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef __CONSTANT_POOL_H_
+#define __CONSTANT_POOL_H_
+
+#include "common.h"
+
+#define CONSTANT_POOL_BUCKETS 256
+#define BYTES_OF_OBJECT_WORD 3
+
+/* Represents a constant of the data image that other constants can be pooled with */
+struct pooled_constant {
+    unsigned long hash; /* The hash of the words of the constant */
+    long offset; /* The offset of the constant in the data image */
+    long length; /* The number of words of the constant */
+    struct pooled_constant *next; /* The next constant in the same bucket */
+};
+
+/* Represents the constants of the data image by the hash of their words */
+struct constant_pool {
+    struct pooled_constant *buckets[CONSTANT_POOL_BUCKETS]; /* The constants, by their hash */
+};
+
+/*
+ * Pools the constant that was just added to the end of the data image.
+ *
+ * If an identical constant is already in the data image, the new copy is removed from the data image
+ * and the offset of the existing copy is returned, so the label of the new constant can alias it.
+ * Otherwise the constant is added to the pool.
+ *
+ * @param pool A pointer to the constant pool.
+ * @param object A pointer to the object file, the constant takes the words from first_offset to DC of its data image.
+ * @param first_offset The offset of the first word of the constant in the data image.
+ * @return The offset of the constant in the data image, or -1 on memory allocation error.
+ */
+long pool_data_constant(struct constant_pool *pool, struct object_file *object, long first_offset);
+
+/*
+ * Frees the memory of a constant pool and leaves it empty.
+ *
+ * @param pool A pointer to the constant pool.
+ */
+void free_constant_pool(struct constant_pool *pool);
+
+#endif
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dependency_file.h"
+
+/*
+ * Adds a file to the dependencies of a module, unless it is already there.
+ *
+ * @param dependencies A pointer to the dependencies of the module.
+ * @param path The path of the file.
+ * @return 1 if the file was added, 0 if it was already a dependency.
+ */
+int add_source_dependency(struct source_dependencies *dependencies, const char *path) {
+    char **bigger_paths;
+    size_t i;
+
+    for (i = 0; i < dependencies->amount_of_paths; i++) {
+        if (strcmp(dependencies->paths[i], path) == 0) {
+            return 0;
+        }
+    }
+    if (dependencies->amount_of_paths == dependencies->capacity) {
+        bigger_paths = (char **)tracked_realloc(dependencies->paths, (dependencies->capacity * 2 + 4) * sizeof(char *), MEMORY_FILE_NAMES);
+        if (bigger_paths == NULL) {
+            fprintf(stderr, "Memory allocation error.\n");
+            exit(1);
+        }
+        dependencies->paths = bigger_paths;
+        dependencies->capacity = dependencies->capacity * 2 + 4;
+    }
+    dependencies->paths[dependencies->amount_of_paths] = (char *)tracked_malloc(strlen(path) + 1, MEMORY_FILE_NAMES);
+    if (dependencies->paths[dependencies->amount_of_paths] == NULL) {
+        fprintf(stderr, "Memory allocation error.\n");
+        exit(1);
+    }
+    strcpy(dependencies->paths[dependencies->amount_of_paths++], path);
+    return 1;
+}
+
+/*
+ * Frees the memory of the dependencies of a module and leaves them empty.
+ *
+ * @param dependencies A pointer to the dependencies of the module.
+ */
+void free_source_dependencies(struct source_dependencies *dependencies) {
+    size_t i;
+
+    for (i = 0; i < dependencies->amount_of_paths; i++) {
+        tracked_free(dependencies->paths[i]);
+    }
+    tracked_free(dependencies->paths);
+    memset(dependencies, 0, sizeof(struct source_dependencies));
+}
+
+/*
+ * Appends a path to the text of a dependency file, with the characters that make treats specially escaped.
+ *
+ * @param text A pointer to the text of the dependency file.
+ * @param path The path.
+ * @return 1 if the path was appended, 0 on memory allocation error.
+ */
+static int append_escaped_path(struct output_text *text, const char *path) {
+    char piece[MAX_LENGTH_OF_PATH_PIECE + 3];
+    size_t length = 0;
+
+    for (; *path != '\0'; path++) {
+        if (*path == ' ' || *path == '#') {
+            piece[length++] = '\\';
+        } else if (*path == '$') {
+            piece[length++] = '$';
+        }
+        piece[length++] = *path;
+        /* A long path is appended in pieces, so it fits in a line of output */
+        if (length >= MAX_LENGTH_OF_PATH_PIECE) {
+            piece[length] = '\0';
+            if (!append_output_text(text, "%s", piece)) {
+                return 0;
+            }
+            length = 0;
+        }
+    }
+    piece[length] = '\0';
+    return append_output_text(text, "%s", piece);
+}
+
+/*
+ * Appends the make rule of a module to the text of a dependency file.
+ *
+ * The target depends on every file of the module, and every file after the first gets an empty rule of
+ * its own, so make doesn't stop when an included file or a library is removed.
+ *
+ * @param text A pointer to the text of the dependency file.
+ * @param target The file the rule makes.
+ * @param dependencies A pointer to the dependencies of the module.
+ * @return 1 if the rule was appended, 0 on memory allocation error.
+ */
+int append_dependency_rule(struct output_text *text, const char *target, const struct source_dependencies *dependencies) {
+    size_t i;
+
+    if (!append_escaped_path(text, target) || !append_output_text(text, ":")) {
+        return 0;
+    }
+    for (i = 0; i < dependencies->amount_of_paths; i++) {
+        if (!append_output_text(text, i == 0 ? " " : " \\\n  ") || !append_escaped_path(text, dependencies->paths[i])) {
+            return 0;
+        }
+    }
+    if (!append_output_text(text, "\n")) {
+        return 0;
+    }
+    for (i = 1; i < dependencies->amount_of_paths; i++) {
+        if (!append_output_text(text, "\n") || !append_escaped_path(text, dependencies->paths[i]) || !append_output_text(text, ":\n")) {
+            return 0;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,39 @@
+#ifndef __DEPENDENCY_FILE_H_
+#define __DEPENDENCY_FILE_H_
+
+#include "common.h"
+#include "output_unit.h"
+
+#define FILE_EXTENSION_DEPENDENCIES ".d"
+#define MAX_LENGTH_OF_PATH_PIECE 128
+
+/*
+ * Adds a file to the dependencies of a module, unless it is already there.
+ *
+ * @param dependencies A pointer to the dependencies of the module.
+ * @param path The path of the file.
+ * @return 1 if the file was added, 0 if it was already a dependency.
+ */
+int add_source_dependency(struct source_dependencies *dependencies, const char *path);
+
+/*
+ * Frees the memory of the dependencies of a module and leaves them empty.
+ *
+ * @param dependencies A pointer to the dependencies of the module.
+ */
+void free_source_dependencies(struct source_dependencies *dependencies);
+
+/*
+ * Appends the make rule of a module to the text of a dependency file.
+ *
+ * The target depends on every file of the module, and every file after the first gets an empty rule of
+ * its own, so make doesn't stop when an included file or a library is removed.
+ *
+ * @param text A pointer to the text of the dependency file.
+ * @param target The file the rule makes.
+ * @param dependencies A pointer to the dependencies of the module.
+ * @return 1 if the rule was appended, 0 on memory allocation error.
+ */
+int append_dependency_rule(struct output_text *text, const char *target, const struct source_dependencies *dependencies);
+
+#endif
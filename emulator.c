@@ -0,0 +1,357 @@
+#include <stdio.h>
+#include <string.h>
+#include "emulator.h"
+
+/*
+ * Decodes the instruction that starts at a given address of the memory.
+ *
+ * The decoding follows the words exactly as the assembler encodes them: the first word
+ * holds the source mode (bits 9-11), the opcode (bits 5-8) and the destination mode (bits 2-4),
+ * and the extra words follow in source, destination order, where two registers share a word.
+ *
+ * @param memory The memory that contains the code image.
+ * @param address The address of the first word of the instruction.
+ * @param code_end The address right after the last code word.
+ * @param instruction A pointer to the structure that receives the decoded instruction.
+ * @return 1 if the instruction was decoded successfully, 0 otherwise.
+ */
+int decode_instruction(const unsigned int *memory, unsigned int address, unsigned int code_end, struct decoded_instruction *instruction) {
+    unsigned int first_word;
+    int i;
+
+    if (address < BEGINNING_ADDRESS || address >= code_end) {
+        return 0;
+    }
+    first_word = memory[address];
+    memset(instruction, 0, sizeof(struct decoded_instruction));
+    instruction->address = address;
+    instruction->opcode = (first_word >> 5) & 0xF;
+    instruction->number_of_words = 1;
+
+    /* rts and stop have no operand words, whatever is written in their mode fields */
+    if (instruction->opcode > mmn14_ast_instruction_jsr) {
+        return 1;
+    }
+    instruction->operand_mode[0] = (first_word >> 9) & 0x7;
+    instruction->operand_mode[1] = (first_word >> 2) & 0x7;
+
+    for (i = 0; i < 2; i++) {
+        switch (instruction->operand_mode[i]) {
+            case mmn14_ast_operand_opt_no_operand:
+            case mmn14_ast_operand_opt_constant_number:
+            case mmn14_ast_operand_opt_operand_label:
+            case mmn14_ast_operand_opt_operand_register:
+                break;
+            default:
+                /* An addressing mode that the assembler never generates */
+                return 0;
+        }
+    }
+
+    if (instruction->operand_mode[0] == mmn14_ast_operand_opt_operand_register && instruction->operand_mode[1] == mmn14_ast_operand_opt_operand_register) {
+        /* Both registers share one word */
+        if (address + 1 >= code_end) {
+            return 0;
+        }
+        instruction->operand_word[0] = memory[address + 1];
+        instruction->operand_word[1] = memory[address + 1];
+        instruction->number_of_words = 2;
+        return 1;
+    }
+    for (i = 0; i < 2; i++) {
+        if (instruction->operand_mode[i] != mmn14_ast_operand_opt_no_operand) {
+            if (address + instruction->number_of_words >= code_end) {
+                return 0;
+            }
+            instruction->operand_word[i] = memory[address + instruction->number_of_words];
+            instruction->number_of_words++;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Returns the index of the single operand of a one operand instruction.
+ *
+ * @param instruction A pointer to the decoded instruction.
+ * @return 1 if the operand is in the destination field, 0 if it is in the source field.
+ */
+int single_operand_index(const struct decoded_instruction *instruction) {
+    /* The assembler places the only operand in the source field */
+    return instruction->operand_mode[1] != mmn14_ast_operand_opt_no_operand ? 1 : 0;
+}
+
+/*
+ * Returns the signed value of a 12 bit word.
+ *
+ * @param word The 12 bit word.
+ * @return The value of the word in two's complement.
+ */
+int signed_word_value(unsigned int word) {
+    word &= WORD_MASK;
+    return (word & 0x800) ? (int)word - (WORD_MASK + 1) : (int)word;
+}
+
+/*
+ * Loads an object file in to the memory of the emulated machine.
+ *
+ * The code image is loaded at BEGINNING_ADDRESS and the data image right after it,
+ * the same way the addresses were assigned by the assembler.
+ *
+ * @param machine A pointer to the machine state to initialize.
+ * @param obj_file A pointer to the object file to load.
+ * @return 1 if the object file was loaded successfully, 0 if it does not fit in the memory.
+ */
+int emulator_load(struct machine_state *machine, const struct object_file *obj_file) {
+    long i;
+    unsigned int address;
+    struct decoded_instruction instruction;
+
+    memset(machine, 0, sizeof(struct machine_state));
+    if (BEGINNING_ADDRESS + obj_file->IC + obj_file->DC > MEMORY_SIZE) {
+        return 0;
+    }
+    /* Copy the code image and then the data image */
+    for (i = 0; i < obj_file->IC; i++) {
+        machine->memory[BEGINNING_ADDRESS + i] = obj_file->code_image[i].code_word;
+    }
+    for (i = 0; i < obj_file->DC; i++) {
+        machine->memory[BEGINNING_ADDRESS + obj_file->IC + i] = obj_file->data_image[i].data_word;
+    }
+    machine->code_end = BEGINNING_ADDRESS + obj_file->IC;
+    machine->program_counter = BEGINNING_ADDRESS;
+
+    /* Mark where every instruction starts so jumps in to the middle of an instruction are caught */
+    address = BEGINNING_ADDRESS;
+    while (address < machine->code_end && decode_instruction(machine->memory, address, machine->code_end, &instruction)) {
+        machine->instruction_start[address] = 1;
+        address += instruction.number_of_words;
+    }
+    return 1;
+}
+
+/*
+ * Prints a fault message to the output of the program and remembers the address of the fault.
+ *
+ * @param machine A pointer to the machine state.
+ * @param output The output of the program.
+ * @param message The message of the fault.
+ * @param address The address the fault happened at.
+ * @return emulator_fault.
+ */
+static enum emulator_result report_fault(struct machine_state *machine, FILE *output, const char *message, unsigned int address) {
+    machine->fault_address = address;
+    fprintf(output, "fault: %s at address %u\n", message, address);
+    return emulator_fault;
+}
+
+/*
+ * Reads the value of an operand of an instruction.
+ *
+ * @param machine A pointer to the machine state.
+ * @param instruction A pointer to the decoded instruction.
+ * @param index The index of the operand (0 for source, 1 for destination).
+ * @param value A pointer to where the value is stored.
+ * @return NULL if the value was read successfully, otherwise the message of the fault.
+ */
+static const char *read_operand(const struct machine_state *machine, const struct decoded_instruction *instruction, int index, unsigned int *value) {
+    unsigned int word = instruction->operand_word[index];
+    unsigned int address;
+
+    switch (instruction->operand_mode[index]) {
+        case mmn14_ast_operand_opt_constant_number:
+            /* The constant is stored as a signed 10 bit number */
+            *value = (word >> 2) & 0x3FF;
+            if (*value & 0x200) {
+                *value |= 0xC00;
+            }
+            return NULL;
+        case mmn14_ast_operand_opt_operand_label:
+            if ((word & 3) == 1) {
+                return FAULT_EXTERNAL_SYMBOL;
+            }
+            address = word >> 2;
+            *value = machine->memory[address];
+            return NULL;
+        case mmn14_ast_operand_opt_operand_register:
+            *value = machine->registers[(word >> (index == 0 ? 7 : 2)) & 0x7];
+            return NULL;
+        default:
+            return FAULT_INVALID_OPERAND;
+    }
+}
+
+/*
+ * Writes a value to an operand of an instruction.
+ *
+ * @param machine A pointer to the machine state.
+ * @param instruction A pointer to the decoded instruction.
+ * @param index The index of the operand (0 for source, 1 for destination).
+ * @param value The value to write, only the lower 12 bits are kept.
+ * @return NULL if the value was written successfully, otherwise the message of the fault.
+ */
+static const char *write_operand(struct machine_state *machine, const struct decoded_instruction *instruction, int index, unsigned int value) {
+    unsigned int word = instruction->operand_word[index];
+    unsigned int address;
+
+    switch (instruction->operand_mode[index]) {
+        case mmn14_ast_operand_opt_operand_label:
+            if ((word & 3) == 1) {
+                return FAULT_EXTERNAL_SYMBOL;
+            }
+            address = word >> 2;
+            if (address >= BEGINNING_ADDRESS && address < machine->code_end) {
+                return FAULT_WRITE_TO_CODE;
+            }
+            machine->memory[address] = value & WORD_MASK;
+            return NULL;
+        case mmn14_ast_operand_opt_operand_register:
+            machine->registers[(word >> (index == 0 ? 7 : 2)) & 0x7] = value & WORD_MASK;
+            return NULL;
+        default:
+            return FAULT_INVALID_OPERAND;
+    }
+}
+
+/*
+ * Finds the address a jump instruction transfers the control to.
+ *
+ * @param machine A pointer to the machine state.
+ * @param instruction A pointer to the decoded instruction.
+ * @param index The index of the operand that holds the target.
+ * @param target A pointer to where the address is stored.
+ * @return NULL if the address was found successfully, otherwise the message of the fault.
+ */
+static const char *jump_target(const struct machine_state *machine, const struct decoded_instruction *instruction, int index, unsigned int *target) {
+    unsigned int word = instruction->operand_word[index];
+
+    switch (instruction->operand_mode[index]) {
+        case mmn14_ast_operand_opt_operand_label:
+            if ((word & 3) == 1) {
+                return FAULT_EXTERNAL_SYMBOL;
+            }
+            *target = word >> 2;
+            return NULL;
+        case mmn14_ast_operand_opt_operand_register:
+            *target = machine->registers[(word >> (index == 0 ? 7 : 2)) & 0x7];
+            return NULL;
+        default:
+            return FAULT_INVALID_OPERAND;
+    }
+}
+
+/*
+ * Runs the program that was loaded in to the emulated machine.
+ *
+ * The program runs until a stop instruction or a fault. The numbers that are printed by prn
+ * and the message of a fault are written to the output, characters for red are read from the input.
+ *
+ * @param machine A pointer to the loaded machine state.
+ * @param input The file red reads characters from.
+ * @param output The file prn and fault messages are written to.
+ * @param max_steps The maximum number of instructions to execute.
+ * @return The way the program run ended.
+ */
+enum emulator_result emulator_run(struct machine_state *machine, FILE *input, FILE *output, long max_steps) {
+    struct decoded_instruction instruction;
+    unsigned int source = 0;
+    unsigned int destination = 0;
+    unsigned int target = 0;
+    const char *fault;
+    int operand;
+    int character;
+
+    while (1) {
+        /* Fetch and decode the next instruction */
+        if (machine->program_counter >= MEMORY_SIZE || !machine->instruction_start[machine->program_counter] ||
+            !decode_instruction(machine->memory, machine->program_counter, machine->code_end, &instruction)) {
+            return report_fault(machine, output, FAULT_INVALID_PROGRAM_COUNTER, machine->program_counter);
+        }
+        if (++machine->steps > max_steps) {
+            return report_fault(machine, output, FAULT_STEP_LIMIT, instruction.address);
+        }
+        machine->program_counter += instruction.number_of_words;
+        operand = single_operand_index(&instruction);
+        fault = NULL;
+
+        switch (instruction.opcode) {
+            case mmn14_ast_instruction_mov:
+                if (!(fault = read_operand(machine, &instruction, 0, &source))) {
+                    fault = write_operand(machine, &instruction, 1, source);
+                }
+                break;
+            case mmn14_ast_instruction_cmp:
+                if (!(fault = read_operand(machine, &instruction, 0, &source)) && !(fault = read_operand(machine, &instruction, 1, &destination))) {
+                    machine->zero_flag = ((source - destination) & WORD_MASK) == 0;
+                }
+                break;
+            case mmn14_ast_instruction_add: case mmn14_ast_instruction_sub:
+                if (!(fault = read_operand(machine, &instruction, 0, &source)) && !(fault = read_operand(machine, &instruction, 1, &destination))) {
+                    fault = write_operand(machine, &instruction, 1, instruction.opcode == mmn14_ast_instruction_add ? destination + source : destination - source);
+                }
+                break;
+            case mmn14_ast_instruction_lea:
+                if (instruction.operand_mode[0] != mmn14_ast_operand_opt_operand_label) {
+                    fault = FAULT_INVALID_OPERAND;
+                } else if ((instruction.operand_word[0] & 3) == 1) {
+                    fault = FAULT_EXTERNAL_SYMBOL;
+                } else {
+                    fault = write_operand(machine, &instruction, 1, instruction.operand_word[0] >> 2);
+                }
+                break;
+            case mmn14_ast_instruction_not: case mmn14_ast_instruction_clr:
+            case mmn14_ast_instruction_inc: case mmn14_ast_instruction_dec:
+                if (instruction.opcode == mmn14_ast_instruction_clr) {
+                    fault = write_operand(machine, &instruction, operand, 0);
+                } else if (!(fault = read_operand(machine, &instruction, operand, &destination))) {
+                    if (instruction.opcode == mmn14_ast_instruction_not) {
+                        destination = ~destination;
+                    } else if (instruction.opcode == mmn14_ast_instruction_inc) {
+                        destination++;
+                    } else {
+                        destination--;
+                    }
+                    fault = write_operand(machine, &instruction, operand, destination);
+                }
+                break;
+            case mmn14_ast_instruction_jmp: case mmn14_ast_instruction_bne:
+                if (!(fault = jump_target(machine, &instruction, operand, &target))) {
+                    if (instruction.opcode == mmn14_ast_instruction_jmp || !machine->zero_flag) {
+                        machine->program_counter = target;
+                    }
+                }
+                break;
+            case mmn14_ast_instruction_jsr:
+                if (!(fault = jump_target(machine, &instruction, operand, &target))) {
+                    if (machine->stack_pointer == EMULATOR_STACK_SIZE) {
+                        fault = FAULT_STACK_OVERFLOW;
+                    } else {
+                        machine->stack[machine->stack_pointer++] = machine->program_counter;
+                        machine->program_counter = target;
+                    }
+                }
+                break;
+            case mmn14_ast_instruction_red:
+                character = getc(input);
+                fault = write_operand(machine, &instruction, operand, character == EOF ? WORD_MASK : (unsigned int)character);
+                break;
+            case mmn14_ast_instruction_prn:
+                if (!(fault = read_operand(machine, &instruction, operand, &source))) {
+                    fprintf(output, "%d\n", signed_word_value(source));
+                }
+                break;
+            case mmn14_ast_instruction_rts:
+                if (machine->stack_pointer == 0) {
+                    fault = FAULT_STACK_UNDERFLOW;
+                } else {
+                    machine->program_counter = machine->stack[--machine->stack_pointer];
+                }
+                break;
+            case mmn14_ast_instruction_stop:
+                return emulator_stopped;
+        }
+        if (fault) {
+            return report_fault(machine, output, fault, instruction.address);
+        }
+    }
+}
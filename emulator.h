@@ -0,0 +1,109 @@
+#ifndef __EMULATOR_H_
+#define __EMULATOR_H_
+
+#include <stdio.h>
+#include "common.h"
+#include "lexer.h"
+
+#define BEGINNING_ADDRESS 100
+#define REGISTERS_AMOUNT 8
+#define EMULATOR_STACK_SIZE 256
+#define EMULATOR_MAX_STEPS 1000000L
+#define WORD_MASK 0xFFF
+
+/* Messages of the faults that stop a program, shared with the C translation */
+#define FAULT_INVALID_PROGRAM_COUNTER "program counter is not at an instruction"
+#define FAULT_EXTERNAL_SYMBOL "access to an unresolved external symbol"
+#define FAULT_WRITE_TO_CODE "write to the code image"
+#define FAULT_INVALID_OPERAND "invalid operand"
+#define FAULT_STACK_OVERFLOW "stack overflow"
+#define FAULT_STACK_UNDERFLOW "stack underflow"
+#define FAULT_STEP_LIMIT "step limit exceeded"
+
+/* Represents an instruction that was decoded from the code image */
+struct decoded_instruction {
+    unsigned int address; /* The address of the first word of the instruction */
+    int opcode; /* The operation code of the instruction */
+    int operand_mode[2]; /* The addressing modes of the source [0] and destination [1] operands */
+    unsigned int operand_word[2]; /* The extra words that describe the source [0] and destination [1] operands */
+    int number_of_words; /* The total number of words of the instruction */
+};
+
+/* Represents the state of the emulated machine */
+struct machine_state {
+    unsigned int memory[MEMORY_SIZE]; /* The memory of the machine, one 12 bit word per cell */
+    unsigned char instruction_start[MEMORY_SIZE]; /* Marks the addresses where an instruction starts */
+    unsigned int registers[REGISTERS_AMOUNT]; /* The general purpose registers */
+    unsigned int stack[EMULATOR_STACK_SIZE]; /* The return addresses of jsr */
+    int stack_pointer; /* The number of return addresses in the stack */
+    unsigned int program_counter; /* The address of the next instruction */
+    unsigned int code_end; /* The address right after the last code word */
+    int zero_flag; /* Set by cmp when both operands are equal */
+    long steps; /* The number of instructions that were executed */
+    unsigned int fault_address; /* The address of the instruction that caused the fault, if the run ended with one */
+};
+
+/* Represents the possible ways a program run can end */
+enum emulator_result {
+    emulator_stopped, /* The program reached a stop instruction */
+    emulator_fault /* The program was stopped by a fault */
+};
+
+/*
+ * Decodes the instruction that starts at a given address of the memory.
+ *
+ * The decoding follows the words exactly as the assembler encodes them: the first word
+ * holds the source mode (bits 9-11), the opcode (bits 5-8) and the destination mode (bits 2-4),
+ * and the extra words follow in source, destination order, where two registers share a word.
+ *
+ * @param memory The memory that contains the code image.
+ * @param address The address of the first word of the instruction.
+ * @param code_end The address right after the last code word.
+ * @param instruction A pointer to the structure that receives the decoded instruction.
+ * @return 1 if the instruction was decoded successfully, 0 otherwise.
+ */
+int decode_instruction(const unsigned int *memory, unsigned int address, unsigned int code_end, struct decoded_instruction *instruction);
+
+/*
+ * Returns the index of the single operand of a one operand instruction.
+ *
+ * @param instruction A pointer to the decoded instruction.
+ * @return 1 if the operand is in the destination field, 0 if it is in the source field.
+ */
+int single_operand_index(const struct decoded_instruction *instruction);
+
+/*
+ * Returns the signed value of a 12 bit word.
+ *
+ * @param word The 12 bit word.
+ * @return The value of the word in two's complement.
+ */
+int signed_word_value(unsigned int word);
+
+/*
+ * Loads an object file in to the memory of the emulated machine.
+ *
+ * The code image is loaded at BEGINNING_ADDRESS and the data image right after it,
+ * the same way the addresses were assigned by the assembler.
+ *
+ * @param machine A pointer to the machine state to initialize.
+ * @param obj_file A pointer to the object file to load.
+ * @return 1 if the object file was loaded successfully, 0 if it does not fit in the memory.
+ */
+int emulator_load(struct machine_state *machine, const struct object_file *obj_file);
+
+/*
+ * Runs the program that was loaded in to the emulated machine.
+ *
+ * The program runs until a stop instruction or a fault. The numbers that are printed by prn
+ * and the message of a fault are written to the output, characters for red are read from the input.
+ *
+ * @param machine A pointer to the loaded machine state.
+ * @param input The file red reads characters from.
+ * @param output The file prn and fault messages are written to.
+ * @param max_steps The maximum number of instructions to execute.
+ * @return The way the program run ended.
+ */
+enum emulator_result emulator_run(struct machine_state *machine, FILE *input, FILE *output, long max_steps);
+
+#endif
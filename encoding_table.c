@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include "encoding_table.h"
+
+/* The operand modes, as the lexer numbers them */
+#define NO_OPERAND 0
+#define REGISTER_OPERAND 5
+/* The last opcode that has operands, the ones after it have none */
+#define LAST_OPCODE_WITH_OPERANDS 13
+
+/* The first word holds the source mode in bits 9-11, the opcode in bits 5-8 and the destination mode in bits 2-4 */
+#define FIRST_WORD(opcode, source, destination) (((unsigned int)(source) << 9) | ((unsigned int)(opcode) << 5) | ((unsigned int)(destination) << 2))
+#define HAS_OPERANDS(opcode) ((opcode) <= LAST_OPCODE_WITH_OPERANDS)
+/* Two register operands share one word */
+#define SHARE_WORD(source, destination) ((source) == REGISTER_OPERAND && (destination) == REGISTER_OPERAND)
+#define WORD_OF_SOURCE(opcode, source) (HAS_OPERANDS(opcode) && (source) != NO_OPERAND ? 1 : 0)
+#define WORD_OF_DESTINATION(opcode, source, destination) \
+    (HAS_OPERANDS(opcode) && (destination) != NO_OPERAND ? (SHARE_WORD(source, destination) ? 1 : 1 + ((source) != NO_OPERAND)) : 0)
+#define WORDS(opcode, source, destination) \
+    (!HAS_OPERANDS(opcode) ? 1 : SHARE_WORD(source, destination) ? 2 : 1 + ((source) != NO_OPERAND) + ((destination) != NO_OPERAND))
+
+#define ENCODING(opcode, source, destination) \
+    { FIRST_WORD(opcode, source, destination), WORDS(opcode, source, destination), \
+      { WORD_OF_SOURCE(opcode, source), WORD_OF_DESTINATION(opcode, source, destination) } }
+#define ENCODINGS_OF_SOURCE(opcode, source) \
+    { ENCODING(opcode, source, 0), ENCODING(opcode, source, 1), ENCODING(opcode, source, 2), \
+      ENCODING(opcode, source, 3), ENCODING(opcode, source, 4), ENCODING(opcode, source, 5) }
+#define ENCODINGS_OF_OPCODE(opcode) \
+    { ENCODINGS_OF_SOURCE(opcode, 0), ENCODINGS_OF_SOURCE(opcode, 1), ENCODINGS_OF_SOURCE(opcode, 2), \
+      ENCODINGS_OF_SOURCE(opcode, 3), ENCODINGS_OF_SOURCE(opcode, 4), ENCODINGS_OF_SOURCE(opcode, 5) }
+
+/* The encoding of every opcode, by the mode of its source operand and the mode of its destination operand */
+static const struct instruction_encoding table_of_encodings[AMOUNT_OF_OPCODES][AMOUNT_OF_OPERAND_MODES][AMOUNT_OF_OPERAND_MODES] = {
+    ENCODINGS_OF_OPCODE(0), ENCODINGS_OF_OPCODE(1), ENCODINGS_OF_OPCODE(2), ENCODINGS_OF_OPCODE(3),
+    ENCODINGS_OF_OPCODE(4), ENCODINGS_OF_OPCODE(5), ENCODINGS_OF_OPCODE(6), ENCODINGS_OF_OPCODE(7),
+    ENCODINGS_OF_OPCODE(8), ENCODINGS_OF_OPCODE(9), ENCODINGS_OF_OPCODE(10), ENCODINGS_OF_OPCODE(11),
+    ENCODINGS_OF_OPCODE(12), ENCODINGS_OF_OPCODE(13), ENCODINGS_OF_OPCODE(14), ENCODINGS_OF_OPCODE(15)
+};
+
+/*
+ * Looks up how an instruction is encoded.
+ *
+ * The encodings of all the opcodes and addressing modes are built at compile time, so the encoder
+ * only has to add the bits of the operands, and the number of words of a line is known without encoding it.
+ *
+ * @param opcode The opcode of the instruction.
+ * @param source_mode The addressing mode of the source operand, mmn14_ast_operand_opt_no_operand if there is none.
+ * @param destination_mode The addressing mode of the destination operand, mmn14_ast_operand_opt_no_operand if there is none.
+ * @return A pointer to the encoding of the instruction.
+ */
+const struct instruction_encoding *encoding_of_instruction(int opcode, int source_mode, int destination_mode) {
+    return &table_of_encodings[opcode][source_mode][destination_mode];
+}
+
+/*
+ * Returns the number of code words the compilation encodes a line to.
+ *
+ * @param ast A pointer to the AST of the line.
+ * @return The number of code words of the line, 0 if it isn't an instruction or has a syntax error.
+ */
+int words_of_line(const mmn14_ast *ast) {
+    if (ast->mmn14_ast_options != mmn14_ast_instruction || ast->syntax_error[0] != '\0') {
+        return 0;
+    }
+    return encoding_of_instruction(ast->directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_opt,
+                                   ast->directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_operand_opt[0],
+                                   ast->directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_operand_opt[1])->amount_of_words;
+}
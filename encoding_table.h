@@ -0,0 +1,37 @@
+#ifndef __ENCODING_TABLE_H_
+#define __ENCODING_TABLE_H_
+
+#include "lexer.h"
+
+#define AMOUNT_OF_OPCODES 16
+#define AMOUNT_OF_OPERAND_MODES 6
+
+/* Represents how an instruction with some opcode and addressing modes is encoded */
+struct instruction_encoding {
+    unsigned int first_word; /* The first word of the instruction, the opcode and both addressing modes */
+    int amount_of_words; /* The number of code words of the instruction */
+    int word_of_operand[2]; /* The word every operand is encoded in, counting from the first word, 0 if the operand has no word */
+};
+
+/*
+ * Looks up how an instruction is encoded.
+ *
+ * The encodings of all the opcodes and addressing modes are built at compile time, so the encoder
+ * only has to add the bits of the operands, and the number of words of a line is known without encoding it.
+ *
+ * @param opcode The opcode of the instruction.
+ * @param source_mode The addressing mode of the source operand, mmn14_ast_operand_opt_no_operand if there is none.
+ * @param destination_mode The addressing mode of the destination operand, mmn14_ast_operand_opt_no_operand if there is none.
+ * @return A pointer to the encoding of the instruction.
+ */
+const struct instruction_encoding *encoding_of_instruction(int opcode, int source_mode, int destination_mode);
+
+/*
+ * Returns the number of code words the compilation encodes a line to.
+ *
+ * @param ast A pointer to the AST of the line.
+ * @return The number of code words of the line, 0 if it isn't an instruction or has a syntax error.
+ */
+int words_of_line(const mmn14_ast *ast);
+
+#endif
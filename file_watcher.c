@@ -0,0 +1,203 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <libgen.h>
+#include <time.h>
+#include <sys/select.h>
+#include <sys/inotify.h>
+#include "file_watcher.h"
+
+#define SIZE_OF_EVENT_BUFFER 4096
+#define WATCHED_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE)
+
+/*
+ * Starts a file watcher without any files.
+ *
+ * @param watcher A pointer to the watcher.
+ * @return 1 if the watcher was started, 0 if inotify couldn't be started.
+ */
+int start_file_watcher(struct file_watcher *watcher) {
+    memset(watcher, 0, sizeof(struct file_watcher));
+    watcher->inotify_descriptor = inotify_init();
+    if (watcher->inotify_descriptor < 0) {
+        fprintf(stderr, "wasn't able to start watching the files\n");
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Watches a file for a module.
+ *
+ * The directory of the file is watched, so a file that an editor replaces by renaming a new file over it is seen too.
+ *
+ * @param watcher A pointer to the watcher.
+ * @param path The path of the file.
+ * @param index_of_module The module that is assembled again when the file changes.
+ * @return 1 if the file is watched, 0 if its directory couldn't be watched.
+ */
+int watch_file(struct file_watcher *watcher, const char *path, int index_of_module) {
+    struct watched_path *bigger_paths;
+    struct watched_path *watched;
+    char *copy_of_directory;
+    char *copy_of_name;
+    int watch_descriptor;
+
+    copy_of_directory = (char *)tracked_malloc(strlen(path) + 1, MEMORY_FILE_NAMES);
+    copy_of_name = (char *)tracked_malloc(strlen(path) + 1, MEMORY_FILE_NAMES);
+    if (copy_of_directory == NULL || copy_of_name == NULL) {
+        fprintf(stderr, "Memory allocation error.\n");
+        exit(1);
+    }
+    strcpy(copy_of_directory, path);
+    strcpy(copy_of_name, path);
+    /* Watching a directory twice gives the same watch */
+    watch_descriptor = inotify_add_watch(watcher->inotify_descriptor, dirname(copy_of_directory), WATCHED_EVENTS);
+    tracked_free(copy_of_directory);
+    if (watch_descriptor < 0) {
+        fprintf(stderr, "wasn't able to watch the file: %s\n", path);
+        tracked_free(copy_of_name);
+        return 0;
+    }
+    if (watcher->amount_of_paths == watcher->capacity) {
+        bigger_paths = (struct watched_path *)tracked_realloc(watcher->paths, (watcher->capacity * 2 + 8) * sizeof(struct watched_path), MEMORY_FILE_NAMES);
+        if (bigger_paths == NULL) {
+            fprintf(stderr, "Memory allocation error.\n");
+            exit(1);
+        }
+        watcher->paths = bigger_paths;
+        watcher->capacity = watcher->capacity * 2 + 8;
+    }
+    watched = &watcher->paths[watcher->amount_of_paths++];
+    watched->watch_descriptor = watch_descriptor;
+    /* basename may return a pointer in to its argument, so the name is moved to the start of the copy */
+    memmove(copy_of_name, basename(copy_of_name), strlen(basename(copy_of_name)) + 1);
+    watched->name_in_directory = copy_of_name;
+    watched->index_of_module = index_of_module;
+    return 1;
+}
+
+/*
+ * Stops watching the files of a module, before the files it was assembled from are watched again.
+ *
+ * @param watcher A pointer to the watcher.
+ * @param index_of_module The module.
+ */
+void forget_files_of_module(struct file_watcher *watcher, int index_of_module) {
+    size_t kept = 0;
+    size_t i;
+
+    /* The watches of the directories stay, other files may be in them */
+    for (i = 0; i < watcher->amount_of_paths; i++) {
+        if (watcher->paths[i].index_of_module == index_of_module) {
+            tracked_free(watcher->paths[i].name_in_directory);
+        } else {
+            watcher->paths[kept++] = watcher->paths[i];
+        }
+    }
+    watcher->amount_of_paths = kept;
+}
+
+/*
+ * Marks the modules of the files that the events in a buffer name.
+ *
+ * @param watcher A pointer to the watcher.
+ * @param events The events that were read.
+ * @param size_of_events The number of bytes that were read.
+ * @param changed_modules An array with a flag for every module.
+ * @param amount_of_modules The number of modules.
+ * @return The number of modules that were marked now.
+ */
+static int mark_changed_modules(struct file_watcher *watcher, const char *events, size_t size_of_events, int *changed_modules, int amount_of_modules) {
+    const struct inotify_event *event;
+    size_t position;
+    size_t i;
+    int marked = 0;
+
+    for (position = 0; position + sizeof(struct inotify_event) <= size_of_events; position += sizeof(struct inotify_event) + event->len) {
+        event = (const struct inotify_event *)(events + position);
+        if (event->len == 0) {
+            continue;
+        }
+        for (i = 0; i < watcher->amount_of_paths; i++) {
+            if (watcher->paths[i].watch_descriptor == event->wd && strcmp(watcher->paths[i].name_in_directory, event->name) == 0 &&
+                watcher->paths[i].index_of_module < amount_of_modules && !changed_modules[watcher->paths[i].index_of_module]) {
+                changed_modules[watcher->paths[i].index_of_module] = 1;
+                marked++;
+            }
+        }
+    }
+    return marked;
+}
+
+/*
+ * Waits until files change and marks the modules they belong to.
+ *
+ * The changes that come within MILLISECONDS_TO_COLLECT_CHANGES of each other are collected together,
+ * so a module is assembled once for all the files an editor or a build wrote.
+ *
+ * @param watcher A pointer to the watcher.
+ * @param changed_modules An array with a flag for every module, it is set for the modules that changed.
+ * @param amount_of_modules The number of modules.
+ * @return The number of modules that changed, or -1 if the watcher failed.
+ */
+int wait_for_changed_modules(struct file_watcher *watcher, int *changed_modules, int amount_of_modules) {
+    /* The buffer is aligned for the events */
+    long buffer[SIZE_OF_EVENT_BUFFER / sizeof(long)];
+    struct timeval timeout;
+    fd_set descriptors;
+    ssize_t size_of_events;
+    int changed = 0;
+    int ready;
+
+    memset(changed_modules, 0, amount_of_modules * sizeof(int));
+    for (;;) {
+        FD_ZERO(&descriptors);
+        FD_SET(watcher->inotify_descriptor, &descriptors);
+        timeout.tv_sec = 0;
+        timeout.tv_usec = MILLISECONDS_TO_COLLECT_CHANGES * 1000L;
+        /* Block until the first change, and then only while more changes keep coming */
+        ready = select(watcher->inotify_descriptor + 1, &descriptors, NULL, NULL, changed ? &timeout : NULL);
+        if (ready < 0) {
+            return -1;
+        }
+        if (ready == 0) {
+            return changed;
+        }
+        size_of_events = read(watcher->inotify_descriptor, buffer, sizeof(buffer));
+        if (size_of_events <= 0) {
+            return -1;
+        }
+        changed += mark_changed_modules(watcher, (const char *)buffer, (size_t)size_of_events, changed_modules, amount_of_modules);
+    }
+}
+
+/*
+ * Returns the time of a monotonic clock, for measuring how long an assembly took.
+ *
+ * @return The time in milliseconds.
+ */
+double milliseconds_of_clock(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+/*
+ * Stops a file watcher and frees its memory.
+ *
+ * @param watcher A pointer to the watcher.
+ */
+void stop_file_watcher(struct file_watcher *watcher) {
+    size_t i;
+
+    for (i = 0; i < watcher->amount_of_paths; i++) {
+        tracked_free(watcher->paths[i].name_in_directory);
+    }
+    tracked_free(watcher->paths);
+    close(watcher->inotify_descriptor);
+    memset(watcher, 0, sizeof(struct file_watcher));
+}
@@ -0,0 +1,78 @@
+#ifndef __FILE_WATCHER_H_
+#define __FILE_WATCHER_H_
+
+#include "common.h"
+
+#define MILLISECONDS_TO_COLLECT_CHANGES 50
+
+/* Represents a file that is watched, by the directory it is in and its name in that directory */
+struct watched_path {
+    int watch_descriptor; /* The watch of the directory of the file */
+    char *name_in_directory; /* The name of the file in its directory */
+    int index_of_module; /* The module that is assembled again when the file changes */
+};
+
+/* Represents the files the assembler watches, every module watches its source file and the files it was assembled from */
+struct file_watcher {
+    int inotify_descriptor; /* The inotify instance */
+    struct watched_path *paths; /* The watched files */
+    size_t amount_of_paths; /* The number of watched files */
+    size_t capacity; /* The number of watched files there is room for */
+};
+
+/*
+ * Starts a file watcher without any files.
+ *
+ * @param watcher A pointer to the watcher.
+ * @return 1 if the watcher was started, 0 if inotify couldn't be started.
+ */
+int start_file_watcher(struct file_watcher *watcher);
+
+/*
+ * Watches a file for a module.
+ *
+ * The directory of the file is watched, so a file that an editor replaces by renaming a new file over it is seen too.
+ *
+ * @param watcher A pointer to the watcher.
+ * @param path The path of the file.
+ * @param index_of_module The module that is assembled again when the file changes.
+ * @return 1 if the file is watched, 0 if its directory couldn't be watched.
+ */
+int watch_file(struct file_watcher *watcher, const char *path, int index_of_module);
+
+/*
+ * Stops watching the files of a module, before the files it was assembled from are watched again.
+ *
+ * @param watcher A pointer to the watcher.
+ * @param index_of_module The module.
+ */
+void forget_files_of_module(struct file_watcher *watcher, int index_of_module);
+
+/*
+ * Waits until files change and marks the modules they belong to.
+ *
+ * The changes that come within MILLISECONDS_TO_COLLECT_CHANGES of each other are collected together,
+ * so a module is assembled once for all the files an editor or a build wrote.
+ *
+ * @param watcher A pointer to the watcher.
+ * @param changed_modules An array with a flag for every module, it is set for the modules that changed.
+ * @param amount_of_modules The number of modules.
+ * @return The number of modules that changed, or -1 if the watcher failed.
+ */
+int wait_for_changed_modules(struct file_watcher *watcher, int *changed_modules, int amount_of_modules);
+
+/*
+ * Returns the time of a monotonic clock, for measuring how long an assembly took.
+ *
+ * @return The time in milliseconds.
+ */
+double milliseconds_of_clock(void);
+
+/*
+ * Stops a file watcher and frees its memory.
+ *
+ * @param watcher A pointer to the watcher.
+ */
+void stop_file_watcher(struct file_watcher *watcher);
+
+#endif
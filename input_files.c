@@ -0,0 +1,379 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <glob.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "input_files.h"
+#include "preprocessor.h"
+
+static int add_argument(struct input_list *list, const char *argument, int depth);
+
+/*
+ * Adds an argument to the end of the list.
+ *
+ * @param list A pointer to the list.
+ * @param argument The argument.
+ * @param length The number of characters of the argument to add.
+ * @return 1 if the argument was added, 0 on memory allocation error.
+ */
+static int add_input_name(struct input_list *list, const char *argument, size_t length) {
+    char **bigger_names;
+    int new_capacity;
+
+    if (list->amount_of_names == list->capacity_of_names) {
+        new_capacity = list->capacity_of_names ? list->capacity_of_names * 2 : 16;
+        bigger_names = (char **)tracked_realloc(list->names, new_capacity * sizeof(char *), MEMORY_FILE_NAMES);
+        if (bigger_names == NULL) {
+            return 0;
+        }
+        list->names = bigger_names;
+        list->capacity_of_names = new_capacity;
+    }
+    list->names[list->amount_of_names] = (char *)tracked_malloc(length + 1, MEMORY_FILE_NAMES);
+    if (list->names[list->amount_of_names] == NULL) {
+        return 0;
+    }
+    memcpy(list->names[list->amount_of_names], argument, length);
+    list->names[list->amount_of_names][length] = '\0';
+    list->amount_of_names++;
+    return 1;
+}
+
+/*
+ * Checks if a path is a directory.
+ *
+ * @param path The path.
+ * @return 1 if the path is a directory, 0 otherwise.
+ */
+static int is_directory(const char *path) {
+    struct stat status;
+
+    return stat(path, &status) == 0 && S_ISDIR(status.st_mode);
+}
+
+/*
+ * Checks if the name of a file ends with the .as extension.
+ *
+ * @param name The name of the file.
+ * @return 1 if it is a source file, 0 otherwise.
+ */
+static int is_source_file(const char *name) {
+    size_t length = strlen(name);
+
+    return length > strlen(file_extension_as) && strcmp(name + length - strlen(file_extension_as), file_extension_as) == 0;
+}
+
+/*
+ * Compares two names for qsort.
+ *
+ * @param first A pointer to the first name.
+ * @param second A pointer to the second name.
+ * @return A negative, zero or positive value, like strcmp.
+ */
+static int compare_names(const void *first, const void *second) {
+    return strcmp(*(char *const *)first, *(char *const *)second);
+}
+
+/*
+ * Adds a path that was found in a directory or by a pattern.
+ *
+ * @param list A pointer to the list.
+ * @param path The path.
+ * @param depth The number of directories and response files the path is in.
+ * @return 1 if the path was added, 0 on memory allocation error.
+ */
+static int add_found_path(struct input_list *list, const char *path, int depth);
+
+/*
+ * Adds the source files under a directory, sorted by name.
+ *
+ * @param list A pointer to the list.
+ * @param path The path of the directory.
+ * @param depth The number of directories and response files the directory is in.
+ * @return 1 if the files were added, 0 on memory allocation error.
+ */
+static int add_directory(struct input_list *list, const char *path, int depth) {
+    DIR *directory;
+    struct dirent *entry;
+    struct input_list entries = {0};
+    char *path_of_entry;
+    int success = 1;
+    int i;
+
+    if (depth > MAX_DEPTH_OF_INPUTS) {
+        fprintf(stderr, "the directory %s is nested too deep\n", path);
+        return 1;
+    }
+    directory = opendir(path);
+    if (directory == NULL) {
+        fprintf(stderr, "Unable to open directory: %s\n", path);
+        return 1;
+    }
+    /* The entries are sorted, so the files are assembled in the same order every time */
+    while (success && (entry = readdir(directory)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            success = add_input_name(&entries, entry->d_name, strlen(entry->d_name));
+        }
+    }
+    closedir(directory);
+    if (entries.amount_of_names > 1) {
+        qsort(entries.names, entries.amount_of_names, sizeof(char *), compare_names);
+    }
+    for (i = 0; success && i < entries.amount_of_names; i++) {
+        path_of_entry = (char *)tracked_malloc(strlen(path) + strlen(entries.names[i]) + 2, MEMORY_FILE_NAMES);
+        if (path_of_entry == NULL) {
+            success = 0;
+            break;
+        }
+        sprintf(path_of_entry, "%s%s%s", path, path[strlen(path) - 1] == '/' ? "" : "/", entries.names[i]);
+        success = add_found_path(list, path_of_entry, depth + 1);
+        tracked_free(path_of_entry);
+    }
+    free_input_list(&entries);
+    return success;
+}
+
+/*
+ * Adds a path that was found in a directory or by a pattern.
+ *
+ * A directory adds the source files under it, a source file adds its base name, and other files are skipped.
+ *
+ * @param list A pointer to the list.
+ * @param path The path.
+ * @param depth The number of directories and response files the path is in.
+ * @return 1 if the path was added, 0 on memory allocation error.
+ */
+static int add_found_path(struct input_list *list, const char *path, int depth) {
+    if (is_directory(path)) {
+        return add_directory(list, path, depth);
+    }
+    if (is_source_file(path)) {
+        return add_input_name(list, path, strlen(path) - strlen(file_extension_as));
+    }
+    return 1;
+}
+
+/*
+ * Adds the words of a response file as arguments.
+ *
+ * @param list A pointer to the list.
+ * @param name_of_file The name of the response file.
+ * @param depth The number of directories and response files the response file is in.
+ * @return 1 if the words were added, 0 on memory allocation error.
+ */
+static int add_response_file(struct input_list *list, const char *name_of_file, int depth) {
+    FILE *response_file;
+    char *text;
+    size_t size_of_text;
+    size_t position = 0;
+    size_t length;
+    int success = 1;
+
+    if (depth > MAX_DEPTH_OF_INPUTS) {
+        fprintf(stderr, "the response file %s is nested too deep\n", name_of_file);
+        return 1;
+    }
+    response_file = fopen(name_of_file, "r");
+    if (response_file == NULL) {
+        fprintf(stderr, "Unable to open file: %s\n", name_of_file);
+        return 1;
+    }
+    text = read_whole_file(response_file, &size_of_text);
+    fclose(response_file);
+    if (text == NULL) {
+        return 0;
+    }
+    /* Every word is an argument, the words are separated by white space */
+    while (success && position < size_of_text) {
+        position += strspn(text + position, " \t\r\n");
+        length = strcspn(text + position, " \t\r\n");
+        if (length > 0) {
+            text[position + length] = '\0';
+            success = add_argument(list, text + position, depth + 1);
+            position += length + 1;
+        }
+    }
+    tracked_free(text);
+    return success;
+}
+
+/*
+ * Adds an argument, after it was expanded.
+ *
+ * @param list A pointer to the list.
+ * @param argument The argument.
+ * @param depth The number of directories and response files the argument is in.
+ * @return 1 if the argument was added, 0 on memory allocation error.
+ */
+static int add_argument(struct input_list *list, const char *argument, int depth) {
+    glob_t matches;
+    size_t i;
+    int success = 1;
+
+    if (list->next_is_option_value) {
+        list->next_is_option_value = 0;
+        return add_input_name(list, argument, strlen(argument));
+    }
+    if (argument[0] == '@') {
+        return add_response_file(list, argument + 1, depth);
+    }
+    if (argument[0] == '-') {
+        list->next_is_option_value = strcmp(argument, "-o") == 0 || strcmp(argument, "-I") == 0 || strcmp(argument, "-L") == 0 ||
+                                     strcmp(argument, "-MF") == 0 || strcmp(argument, "--archive") == 0 || strcmp(argument, "--trace") == 0;
+        return add_input_name(list, argument, strlen(argument));
+    }
+    if (list->keep_names) {
+        return add_input_name(list, argument, strlen(argument));
+    }
+    if (strpbrk(argument, "*?[") != NULL) {
+        if (glob(argument, 0, NULL, &matches) == 0) {
+            for (i = 0; success && i < matches.gl_pathc; i++) {
+                success = add_found_path(list, matches.gl_pathv[i], depth);
+            }
+            globfree(&matches);
+        } else {
+            fprintf(stderr, "no files match: %s\n", argument);
+        }
+        return success;
+    }
+    if (is_directory(argument)) {
+        return add_directory(list, argument, depth);
+    }
+    /* A base name, as before */
+    return add_input_name(list, argument, strlen(argument));
+}
+
+/*
+ * Expands the arguments of the assembler.
+ *
+ * An argument that starts with '@' is a response file, its words are expanded as arguments as well.
+ * A directory is replaced by the .as files under it, sorted by name, and a pattern with '*', '?' or '['
+ * is replaced by the .as files and directories it matches. The .as extension of the files that were found
+ * is removed, since the assembler takes base names. Options and other arguments are kept as they are,
+ * and so are all the names when the arguments have --find or --extract, since then they are not files.
+ *
+ * @param amount_of_arguments The number of arguments.
+ * @param arguments The arguments.
+ * @param list A pointer to the list that receives the expanded arguments.
+ * @return 1 if the arguments were expanded, 0 on memory allocation error.
+ */
+int expand_input_arguments(int amount_of_arguments, char **arguments, struct input_list *list) {
+    int i;
+
+    memset(list, 0, sizeof(struct input_list));
+    /* The options can come after the names, so they are looked for first */
+    for (i = 0; i < amount_of_arguments; i++) {
+        if (strcmp(arguments[i], "--find") == 0 || strcmp(arguments[i], "--extract") == 0) {
+            list->keep_names = 1;
+        }
+    }
+    for (i = 0; i < amount_of_arguments; i++) {
+        if (!add_argument(list, arguments[i], 0)) {
+            fprintf(stderr, "wasn't able to allocate memory for the arguments\n");
+            free_input_list(list);
+            return 0;
+        }
+    }
+    list->arguments = (char **)tracked_malloc((list->amount_of_names + 1) * sizeof(char *), MEMORY_FILE_NAMES);
+    if (list->arguments == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the arguments\n");
+        free_input_list(list);
+        return 0;
+    }
+    if (list->amount_of_names > 0) {
+        memcpy(list->arguments, list->names, list->amount_of_names * sizeof(char *));
+    }
+    return 1;
+}
+
+/*
+ * Frees the memory of the expanded arguments and leaves the list empty.
+ *
+ * @param list A pointer to the list.
+ */
+void free_input_list(struct input_list *list) {
+    int i;
+
+    for (i = 0; i < list->amount_of_names; i++) {
+        tracked_free(list->names[i]);
+    }
+    tracked_free(list->names);
+    tracked_free(list->arguments);
+    memset(list, 0, sizeof(struct input_list));
+}
+
+/*
+ * Creates the directories of the name of a file that don't exist yet.
+ *
+ * @param name_of_file The name of the file, it is changed while the directories are created and restored.
+ */
+static void create_directories_of_file(char *name_of_file) {
+    char *separator;
+
+    for (separator = strchr(name_of_file + 1, '/'); separator != NULL; separator = strchr(separator + 1, '/')) {
+        *separator = '\0';
+        if (mkdir(name_of_file, 0777) != 0 && errno != EEXIST) {
+            fprintf(stderr, "wasn't able to create the directory: %s\n", name_of_file);
+        }
+        *separator = '/';
+    }
+}
+
+/*
+ * Creates the name of an output file, in the output directory if one was given with -o.
+ *
+ * In the output directory the base name keeps its path, without its leading '/' and its "." components,
+ * and a ".." component removes the directory before it, so the file always stays inside the output
+ * directory. The directories of the name are created.
+ *
+ * @param base_name The base name of the file (without extension).
+ * @param extension The extension to append, including the dot.
+ * @return A dynamically allocated string with the file name, or NULL on memory allocation error.
+ * @note The caller is responsible for freeing the allocated memory using `tracked_free()`.
+ */
+char *create_output_file_name(const char *base_name, const char *extension) {
+    const char *output_directory = options_of_assembler.output_directory;
+    char *file_name;
+    size_t start_of_path;
+    size_t length;
+    size_t length_of_component;
+
+    if (output_directory == NULL) {
+        return create_file_name(base_name, extension);
+    }
+    file_name = tracked_malloc(strlen(output_directory) + strlen(base_name) + strlen(extension) + 2, MEMORY_FILE_NAMES);
+    if (file_name == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the name of a file\n");
+        return NULL;
+    }
+    sprintf(file_name, "%s/", output_directory);
+    start_of_path = length = strlen(file_name);
+    /* Keep the file inside the output directory, a ".." can't go above the start of the path */
+    while (*base_name != '\0') {
+        length_of_component = strcspn(base_name, "/");
+        if (length_of_component == 2 && strncmp(base_name, "..", 2) == 0) {
+            if (length > start_of_path) {
+                for (length--; length > start_of_path && file_name[length - 1] != '/'; length--) {
+                }
+            }
+        } else if (length_of_component > 0 && !(length_of_component == 1 && base_name[0] == '.')) {
+            memcpy(file_name + length, base_name, length_of_component);
+            length += length_of_component;
+            /* A directory of the path ends with a '/', the last component is the name of the file */
+            if (base_name[length_of_component] == '/') {
+                file_name[length++] = '/';
+            }
+        }
+        base_name += length_of_component;
+        if (*base_name == '/') {
+            base_name++;
+        }
+    }
+    strcpy(file_name + length, extension);
+    create_directories_of_file(file_name);
+    return file_name;
+}
@@ -0,0 +1,56 @@
+#ifndef __INPUT_FILES_H_
+#define __INPUT_FILES_H_
+
+#include "common.h"
+
+#define file_extension_as ".as"
+#define MAX_DEPTH_OF_INPUTS 32
+
+/* Represents the arguments of the assembler after response files, directories and patterns were expanded */
+struct input_list {
+    char **names; /* The expanded arguments, the list owns them */
+    char **arguments; /* A copy of names that the assembler may change */
+    int amount_of_names; /* The number of expanded arguments */
+    int capacity_of_names; /* The number of arguments there is room for */
+    int next_is_option_value; /* Set after -o, -I, -L, -MF, --archive or --trace, their value is kept as it is */
+    int keep_names; /* Set with --find or --extract, the names are symbols and members of the archive and are kept as they are */
+};
+
+/*
+ * Expands the arguments of the assembler.
+ *
+ * An argument that starts with '@' is a response file, its words are expanded as arguments as well.
+ * A directory is replaced by the .as files under it, sorted by name, and a pattern with '*', '?' or '['
+ * is replaced by the .as files and directories it matches. The .as extension of the files that were found
+ * is removed, since the assembler takes base names. Options and other arguments are kept as they are,
+ * and so are all the names when the arguments have --find or --extract, since then they are not files.
+ *
+ * @param amount_of_arguments The number of arguments.
+ * @param arguments The arguments.
+ * @param list A pointer to the list that receives the expanded arguments.
+ * @return 1 if the arguments were expanded, 0 on memory allocation error.
+ */
+int expand_input_arguments(int amount_of_arguments, char **arguments, struct input_list *list);
+
+/*
+ * Frees the memory of the expanded arguments and leaves the list empty.
+ *
+ * @param list A pointer to the list.
+ */
+void free_input_list(struct input_list *list);
+
+/*
+ * Creates the name of an output file, in the output directory if one was given with -o.
+ *
+ * In the output directory the base name keeps its path, without its leading '/' and its "." components,
+ * and a ".." component removes the directory before it, so the file always stays inside the output
+ * directory. The directories of the name are created.
+ *
+ * @param base_name The base name of the file (without extension).
+ * @param extension The extension to append, including the dot.
+ * @return A dynamically allocated string with the file name, or NULL on memory allocation error.
+ * @note The caller is responsible for freeing the allocated memory using `tracked_free()`.
+ */
+char *create_output_file_name(const char *base_name, const char *extension);
+
+#endif
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "interner.h"
+
+/*
+ * Computes the FNV-1a hash of the name of a symbol.
+ *
+ * @param name_of_symbol The name of the symbol.
+ * @return The hash of the name, up to LABEL_MAX_LENGTH characters.
+ */
+static unsigned long hash_of_name(const char *name_of_symbol) {
+    size_t length = 0;
+
+    while (length < LABEL_MAX_LENGTH && name_of_symbol[length] != '\0') {
+        length++;
+    }
+    return add_to_fnv1a_hash(FNV1A_OFFSET_BASIS, (const unsigned char *)name_of_symbol, length);
+}
+
+/*
+ * Doubles the buckets of the interner when there are more ids than buckets, so the buckets stay short.
+ *
+ * @param interner A pointer to the interner.
+ * @return 1 if the buckets are ready, 0 on memory allocation error.
+ */
+static int grow_buckets(struct symbol_interner *interner) {
+    unsigned int *bigger_buckets;
+    unsigned int amount_of_buckets;
+    unsigned int *bucket;
+    unsigned int id_of_symbol;
+
+    if (interner->amount_of_buckets != 0 && interner->amount_of_ids < interner->amount_of_buckets) {
+        return 1;
+    }
+    amount_of_buckets = interner->amount_of_buckets ? interner->amount_of_buckets * 2 : FIRST_SYMBOL_INTERNER_BUCKETS;
+    bigger_buckets = (unsigned int *)tracked_calloc(amount_of_buckets, sizeof(unsigned int), MEMORY_SYMBOLS);
+    if (bigger_buckets == NULL) {
+        return 0;
+    }
+    /* Every name moves to its bucket of the new size */
+    for (id_of_symbol = NO_SYMBOL_ID + 1; id_of_symbol < interner->amount_of_ids; id_of_symbol++) {
+        bucket = &bigger_buckets[hash_of_name(interner->names[id_of_symbol]) % amount_of_buckets];
+        interner->next_in_bucket[id_of_symbol] = *bucket;
+        *bucket = id_of_symbol;
+    }
+    tracked_free(interner->buckets);
+    interner->buckets = bigger_buckets;
+    interner->amount_of_buckets = amount_of_buckets;
+    return 1;
+}
+
+/*
+ * Makes room for one more id in the interner.
+ *
+ * @param interner A pointer to the interner.
+ * @return 1 if there is room, 0 on memory allocation error.
+ */
+static int grow_interner(struct symbol_interner *interner) {
+    char (*bigger_names)[LABEL_MAX_LENGTH + 1];
+    struct symbol **bigger_symbols;
+    unsigned int *bigger_next;
+    unsigned int new_capacity;
+
+    if (interner->amount_of_ids < interner->capacity_of_ids) {
+        return 1;
+    }
+    new_capacity = interner->capacity_of_ids ? interner->capacity_of_ids * 2 : 64;
+    bigger_names = tracked_realloc(interner->names, new_capacity * sizeof(*interner->names), MEMORY_SYMBOLS);
+    if (bigger_names == NULL) {
+        return 0;
+    }
+    interner->names = bigger_names;
+    bigger_symbols = (struct symbol **)tracked_realloc(interner->symbols, new_capacity * sizeof(struct symbol *), MEMORY_SYMBOLS);
+    if (bigger_symbols == NULL) {
+        return 0;
+    }
+    interner->symbols = bigger_symbols;
+    bigger_next = (unsigned int *)tracked_realloc(interner->next_in_bucket, new_capacity * sizeof(unsigned int), MEMORY_SYMBOLS);
+    if (bigger_next == NULL) {
+        return 0;
+    }
+    interner->next_in_bucket = bigger_next;
+    interner->capacity_of_ids = new_capacity;
+    return 1;
+}
+
+/*
+ * Interns the name of a symbol and returns its id.
+ *
+ * The first time a name is interned it gets the next id, starting at 1, and its bytes are stored once.
+ * Every later call with the same name returns the same id, so symbols can be compared by their ids.
+ *
+ * @param interner A pointer to the interner of the file.
+ * @param name_of_symbol The name of the symbol, longer names are cut at LABEL_MAX_LENGTH characters.
+ * @return The id of the name, or NO_SYMBOL_ID on memory allocation error.
+ */
+unsigned int intern_symbol_name(struct symbol_interner *interner, const char *name_of_symbol) {
+    unsigned long hash = hash_of_name(name_of_symbol);
+    unsigned int *bucket;
+    unsigned int id_of_symbol;
+
+    if (!grow_buckets(interner)) {
+        fprintf(stderr, "wasn't able to allocate memory for the names of the symbols\n");
+        return NO_SYMBOL_ID;
+    }
+    /* Look for the name */
+    bucket = &interner->buckets[hash % interner->amount_of_buckets];
+    for (id_of_symbol = *bucket; id_of_symbol != NO_SYMBOL_ID; id_of_symbol = interner->next_in_bucket[id_of_symbol]) {
+        if (strncmp(interner->names[id_of_symbol], name_of_symbol, LABEL_MAX_LENGTH) == 0) {
+            return id_of_symbol;
+        }
+    }
+
+    /* The id 0 is kept for no symbol, so the first name gets the id 1 */
+    if (interner->amount_of_ids == 0) {
+        if (!grow_interner(interner)) {
+            fprintf(stderr, "wasn't able to allocate memory for the names of the symbols\n");
+            return NO_SYMBOL_ID;
+        }
+        interner->names[NO_SYMBOL_ID][0] = '\0';
+        interner->symbols[NO_SYMBOL_ID] = NULL;
+        interner->next_in_bucket[NO_SYMBOL_ID] = NO_SYMBOL_ID;
+        interner->amount_of_ids = 1;
+    }
+    if (!grow_interner(interner)) {
+        fprintf(stderr, "wasn't able to allocate memory for the names of the symbols\n");
+        return NO_SYMBOL_ID;
+    }
+    id_of_symbol = interner->amount_of_ids++;
+    strncpy(interner->names[id_of_symbol], name_of_symbol, LABEL_MAX_LENGTH);
+    interner->names[id_of_symbol][LABEL_MAX_LENGTH] = '\0';
+    interner->symbols[id_of_symbol] = NULL;
+    interner->next_in_bucket[id_of_symbol] = *bucket;
+    *bucket = id_of_symbol;
+    return id_of_symbol;
+}
+
+/*
+ * Returns the name of a symbol by its id.
+ *
+ * @param interner A pointer to the interner of the file.
+ * @param id_of_symbol The id of the symbol.
+ * @return The name of the symbol, or an empty string if the id is unknown.
+ */
+const char *name_of_symbol_id(const struct symbol_interner *interner, unsigned int id_of_symbol) {
+    if (id_of_symbol == NO_SYMBOL_ID || id_of_symbol >= interner->amount_of_ids) {
+        return "";
+    }
+    return interner->names[id_of_symbol];
+}
+
+/*
+ * Returns the symbol that was defined or declared with an id.
+ *
+ * @param interner A pointer to the interner of the file.
+ * @param id_of_symbol The id of the symbol.
+ * @return A pointer to the symbol in the symbol table, or NULL if there is none.
+ */
+struct symbol *find_symbol_by_id(const struct symbol_interner *interner, unsigned int id_of_symbol) {
+    if (id_of_symbol == NO_SYMBOL_ID || id_of_symbol >= interner->amount_of_ids) {
+        return NULL;
+    }
+    return interner->symbols[id_of_symbol];
+}
+
+/*
+ * Records the symbol of the symbol table that an id stands for.
+ *
+ * @param interner A pointer to the interner of the file.
+ * @param symbol A pointer to the symbol in the symbol table, its id is already interned.
+ */
+void set_symbol_of_id(struct symbol_interner *interner, struct symbol *symbol) {
+    if (symbol != NULL && symbol->id_of_symbol != NO_SYMBOL_ID && symbol->id_of_symbol < interner->amount_of_ids) {
+        interner->symbols[symbol->id_of_symbol] = symbol;
+    }
+}
+
+/*
+ * Frees the memory of an interner and leaves it empty.
+ *
+ * @param interner A pointer to the interner.
+ */
+void free_symbol_interner(struct symbol_interner *interner) {
+    tracked_free(interner->names);
+    tracked_free(interner->symbols);
+    tracked_free(interner->next_in_bucket);
+    tracked_free(interner->buckets);
+    memset(interner, 0, sizeof(struct symbol_interner));
+}
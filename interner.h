@@ -0,0 +1,51 @@
+#ifndef __INTERNER_H_
+#define __INTERNER_H_
+
+#include "common.h"
+
+/*
+ * Interns the name of a symbol and returns its id.
+ *
+ * The first time a name is interned it gets the next id, starting at 1, and its bytes are stored once.
+ * Every later call with the same name returns the same id, so symbols can be compared by their ids.
+ *
+ * @param interner A pointer to the interner of the file.
+ * @param name_of_symbol The name of the symbol, longer names are cut at LABEL_MAX_LENGTH characters.
+ * @return The id of the name, or NO_SYMBOL_ID on memory allocation error.
+ */
+unsigned int intern_symbol_name(struct symbol_interner *interner, const char *name_of_symbol);
+
+/*
+ * Returns the name of a symbol by its id.
+ *
+ * @param interner A pointer to the interner of the file.
+ * @param id_of_symbol The id of the symbol.
+ * @return The name of the symbol, or an empty string if the id is unknown.
+ */
+const char *name_of_symbol_id(const struct symbol_interner *interner, unsigned int id_of_symbol);
+
+/*
+ * Returns the symbol that was defined or declared with an id.
+ *
+ * @param interner A pointer to the interner of the file.
+ * @param id_of_symbol The id of the symbol.
+ * @return A pointer to the symbol in the symbol table, or NULL if there is none.
+ */
+struct symbol *find_symbol_by_id(const struct symbol_interner *interner, unsigned int id_of_symbol);
+
+/*
+ * Records the symbol of the symbol table that an id stands for.
+ *
+ * @param interner A pointer to the interner of the file.
+ * @param symbol A pointer to the symbol in the symbol table, its id is already interned.
+ */
+void set_symbol_of_id(struct symbol_interner *interner, struct symbol *symbol);
+
+/*
+ * Frees the memory of an interner and leaves it empty.
+ *
+ * @param interner A pointer to the interner.
+ */
+void free_symbol_interner(struct symbol_interner *interner);
+
+#endif
@@ -5,6 +5,7 @@
 #include <limits.h>
 #include <string.h>
 #include "lexer.h"
+#include "interner.h"
 
 
 /* Enum that defines the possible results of label validation in the lexer */
@@ -260,10 +261,11 @@ static void instructon_operands_parsing(mmn14_ast * ast, char * str_describing_o
     }
     /* Iterate through the expected operands */
     for (i = 0; i < num_operands; ++i) {
-        if (i == 0) {
-            expected_options = ins_mapping->options_of_destination_operand; 
-        } else {
+        /* The first of two operands is the source operand, the only or second operand is the destination */
+        if (i == 0 && num_operands == 2) {
             expected_options = ins_mapping->options_of_source_operand;
+        } else {
+            expected_options = ins_mapping->options_of_destination_operand;
         }
         /* Parse and validate the current operand using the handle_single_operand function */
         result = handle_single_operand(ast, str_describing_operands, i, ins_mapping);
@@ -273,7 +275,8 @@ static void instructon_operands_parsing(mmn14_ast * ast, char * str_describing_o
             return;
         } else {
             /* Check if the parsed operand matches the expected operand options */
-            if (!strchr(expected_options, result)) {
+            if (expected_options && !strchr(expected_options, result)) {
+                report_syntax_error_and_return_ins(ast, "addressing mode isn't allowed for the operand", ins_mapping->name_of_instruction);
                 return;
             }
         }
@@ -627,15 +630,48 @@ static char parse_operand(char * operand_str, char ** label, int * constant, int
     return 'U';
 }
 
+/*
+ * Interns the names of the labels of a parsed line and stores their ids in the AST.
+ *
+ * @param ast A pointer to the AST of the line, without syntax errors.
+ * @param interner The interner of the names of the symbols of the file, or NULL to leave the ids empty.
+ */
+void intern_labels_of_ast(mmn14_ast *ast, struct symbol_interner *interner) {
+    int i;
+
+    if (interner == NULL || ast->syntax_error[0] != '\0') {
+        return;
+    }
+    if (ast->name_of_label[0] != '\0') {
+        ast->id_of_label = intern_symbol_name(interner, ast->name_of_label);
+    }
+    if (ast->mmn14_ast_options == mmn14_ast_directive) {
+        if (ast->directive_or_instruction.mmn14_ast_directive.mmn14_ast_directive_opt == mmn14_ast_directive_extern ||
+            ast->directive_or_instruction.mmn14_ast_directive.mmn14_ast_directive_opt == mmn14_ast_directive_entry) {
+            ast->directive_or_instruction.mmn14_ast_directive.id_of_operand_label =
+                intern_symbol_name(interner, ast->directive_or_instruction.mmn14_ast_directive.directive_operand.name_of_label);
+        }
+        return;
+    }
+    for (i = 0; i < 2; i++) {
+        if (ast->directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_operand_opt[i] == mmn14_ast_operand_opt_operand_label) {
+            ast->directive_or_instruction.mmn14_ast_instruction.ids_of_operand_labels[i] =
+                intern_symbol_name(interner, ast->directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_operands[i].label);
+        }
+    }
+}
+
 /*
  * Generate a mmn14_ast structure to represent the parsed logical line.
  * This function processes a logical line, identifies labels, instructions, and directives,
  * and constructs a mmn14_ast structure to encapsulate the parsed information.
+ * The names of the labels are interned, so later stages compare them by their ids.
  *
  * @param logical_line The logical line being parsed.
+ * @param interner The interner of the names of the symbols of the file, or NULL to leave the ids empty.
  * @return A mmn14_ast structure capturing the parsed logical line.
  */
-mmn14_ast get_ast_lexer(char * logical_line){
+mmn14_ast get_ast_lexer(char * logical_line, struct symbol_interner *interner){
     mmn14_ast ast = {0};
     enum valid_label_lexer lable1;
     struct asm_instruction_mapping * ins_mapping = NULL;
@@ -726,6 +762,7 @@ mmn14_ast get_ast_lexer(char * logical_line){
         ast.directive_or_instruction.mmn14_ast_directive.mmn14_ast_directive_opt = dir_mapping->number_of_directive;
         /* Parse directive operands */
         directive_operands_parsing(&ast ,p1, dir_mapping);
+        intern_labels_of_ast(&ast, interner);
         return ast;
     }
     /* Find the instruction mapping */
@@ -742,6 +779,7 @@ mmn14_ast get_ast_lexer(char * logical_line){
     ast.directive_or_instruction.mmn14_ast_instruction.mmn14_ast_instruction_opt = ins_mapping->number_of_instruction;
     /* Parse instruction operands */
     instructon_operands_parsing(&ast ,p1, ins_mapping);
+    intern_labels_of_ast(&ast, interner);
 
     return ast;
 
@@ -15,6 +15,7 @@
 struct mmn14_ast {
     char syntax_error[250]; /* Error message for syntax-related issues */
     char name_of_label[LABEL_MAX_LENGTH + 1]; /* Name of the label, if present */
+    unsigned int id_of_label; /* The interned id of the label, NO_SYMBOL_ID if there is none */
     enum {
         mmn14_ast_instruction, /* Represents an instruction in the logical line */
         mmn14_ast_directive,  /* Represents a directive in the logical line */
@@ -37,6 +38,7 @@ struct mmn14_ast {
                     int num_of_numbers; /* Number of integers in the data array */
                 } data; /* Struct holding data for the .data directive */
             } directive_operand;
+            unsigned int id_of_operand_label; /* The interned id of the label of .extern and .entry */
         } mmn14_ast_directive;
         struct {
             enum {
@@ -70,6 +72,7 @@ struct mmn14_ast {
                 int register_number; /* Operand register number */
                 char *label; /* Operand label */
             } mmn14_ast_instruction_operands[2]; 
+            unsigned int ids_of_operand_labels[2]; /* The interned ids of the operand labels, NO_SYMBOL_ID for other operands */
         } mmn14_ast_instruction;
     } directive_or_instruction;
 };
@@ -84,10 +87,27 @@ typedef struct mmn14_ast mmn14_ast;
  * Generate a mmn14_ast structure to represent the parsed logical line.
  * This function processes a logical line, identifies labels, instructions, and directives,
  * and constructs a mmn14_ast structure to encapsulate the parsed information.
+ * The names of the labels are interned, so later stages compare them by their ids.
  *
  * @param logical_line The logical line being parsed.
+ * @param interner The interner of the names of the symbols of the file, or NULL to leave the ids empty.
  * @return A mmn14_ast structure capturing the parsed logical line.
  */
-mmn14_ast get_ast_lexer(char *logical_line);
+mmn14_ast get_ast_lexer(char *logical_line, struct symbol_interner *interner);
+
+/*
+ * Interns the names of the labels of a parsed line and stores their ids in the AST.
+ *
+ * @param ast A pointer to the AST of the line, without syntax errors.
+ * @param interner The interner of the names of the symbols of the file, or NULL to leave the ids empty.
+ */
+void intern_labels_of_ast(mmn14_ast *ast, struct symbol_interner *interner);
+
+/*
+ * Deallocate memory and clean up linked lists used for instruction and directive names.
+ *
+ * The lists are created again by the next line that is lexed.
+ */
+void deallocate_memory(void);
 
 #endif
@@ -9,20 +9,20 @@
  * @return A pointer to the newly created SymbolLinkedList, or NULL if memory allocation fails.
  */
 SymbolLinkedList *new_symbol_linked_list(const struct symbol *initial_symbol) {
-    SymbolLinkedList *list = (SymbolLinkedList *)malloc(sizeof(SymbolLinkedList));
+    SymbolLinkedList *list = (SymbolLinkedList *)tracked_malloc(sizeof(SymbolLinkedList), MEMORY_SYMBOLS);
     if (list == NULL) {
         fprintf(stderr, "wasn't able to allocate memory for new string list\n");
         return NULL;
     }
     /* Allocate memory for the head node */
-    list->head = (SymbolNode *)malloc(sizeof(SymbolNode));
+    list->head = (SymbolNode *)tracked_malloc(sizeof(SymbolNode), MEMORY_SYMBOLS);
     if (list->head == NULL) {
         fprintf(stderr, "wasn't able to allocate memory for new node\n");
-        free(list);
+        tracked_free(list);
         return NULL;
     }
     /* Allocate memory for the initial symbol data and copy it */
-    list->head->symbol_data = malloc(sizeof(struct symbol));
+    list->head->symbol_data = tracked_malloc(sizeof(struct symbol), MEMORY_SYMBOLS);
     memcpy(list->head->symbol_data, initial_symbol, sizeof(struct symbol));
 
     /* Set the tail to the head since there's only one node */
@@ -62,14 +62,14 @@ SymbolNode *insert_symbol_to_linked_list(SymbolLinkedList **list, struct symbol
     } else {
         /* If the linked list already exists, insert a new node with the given symbol */
         /* Allocate memory for the new node */
-        new_node = (SymbolNode *)malloc(sizeof(SymbolNode));
+        new_node = (SymbolNode *)tracked_malloc(sizeof(SymbolNode), MEMORY_SYMBOLS);
         if (!new_node) {
             return NULL;
         }
         /* Allocate memory for the symbol data in the new node and copy the data */
-        new_node->symbol_data = malloc(sizeof(struct symbol));
+        new_node->symbol_data = tracked_malloc(sizeof(struct symbol), MEMORY_SYMBOLS);
         if (!new_node->symbol_data) {
-            free(new_node);
+            tracked_free(new_node);
             return NULL;
         }
         memcpy(new_node->symbol_data, symbol, sizeof(struct symbol));
@@ -93,23 +93,23 @@ SymbolNode *insert_symbol_to_linked_list(SymbolLinkedList **list, struct symbol
  */
 SymbolsNotFoundLinkedList *new_symbols_not_found_linked_list(const SymbolsNotFoundData *initial_data) {
     /* Allocate memory for the linked list */
-    SymbolsNotFoundLinkedList *list = (SymbolsNotFoundLinkedList *)malloc(sizeof(SymbolsNotFoundLinkedList));
+    SymbolsNotFoundLinkedList *list = (SymbolsNotFoundLinkedList *)tracked_malloc(sizeof(SymbolsNotFoundLinkedList), MEMORY_FIXUPS);
     if (!list) { 
         fprintf(stderr, "wasn't able to allocate memory for new symbols_not_found list\n");
         return NULL;
     }
     /* Allocate memory for the head node */
-    list->head = (SymbolsNotFoundNode *)malloc(sizeof(SymbolsNotFoundNode));
+    list->head = (SymbolsNotFoundNode *)tracked_malloc(sizeof(SymbolsNotFoundNode), MEMORY_FIXUPS);
     if (list->head == NULL) {
         fprintf(stderr, "wasn't able to allocate memory for new node\n");
-        free(list);
+        tracked_free(list);
         return NULL;
     }
     /* Allocate memory for the initial data and copy it */
-    list->head->data = malloc(sizeof(SymbolsNotFoundData));
+    list->head->data = tracked_malloc(sizeof(SymbolsNotFoundData), MEMORY_FIXUPS);
     if (!list->head->data) {
-        free(list->head); 
-        free(list);
+        tracked_free(list->head); 
+        tracked_free(list);
         return NULL;
     }
 
@@ -150,14 +150,14 @@ SymbolsNotFoundNode *insert_symbol_not_found_to_linked_list(SymbolsNotFoundLinke
        /* If the linked list already exists, insert a new node with the given data */
 
        /* Allocate memory for the new node */
-       new_node = (SymbolsNotFoundNode *)malloc(sizeof(SymbolsNotFoundNode));
+       new_node = (SymbolsNotFoundNode *)tracked_malloc(sizeof(SymbolsNotFoundNode), MEMORY_FIXUPS);
         if (!new_node) {
             return NULL;
         }
         /* Allocate memory for the data in the new node and copy the data */
-        new_node->data = (SymbolsNotFoundData *)malloc(sizeof(SymbolsNotFoundData));
+        new_node->data = (SymbolsNotFoundData *)tracked_malloc(sizeof(SymbolsNotFoundData), MEMORY_FIXUPS);
         if (!new_node->data) {
-            free(new_node);
+            tracked_free(new_node);
             return NULL;
         }
         memcpy(new_node->data, data, sizeof(SymbolsNotFoundData));
@@ -184,24 +184,24 @@ SymbolsNotFoundNode *insert_symbol_not_found_to_linked_list(SymbolsNotFoundLinke
  */
 MacroLinkedList *new_linked_list_macro(const struct macro *initial_macro) {
     /* Allocate memory for the linked list */
-    MacroLinkedList *list = (MacroLinkedList *)malloc(sizeof(MacroLinkedList));
+    MacroLinkedList *list = (MacroLinkedList *)tracked_malloc(sizeof(MacroLinkedList), MEMORY_MACROS);
     if (list == NULL) {
         fprintf(stderr, "wasn't able to allocate memory for new macro list\n");
         return NULL;
     }
     /* Allocate memory for the head node */
-    list->head = (NodeMacro *)malloc(sizeof(NodeMacro));
+    list->head = (NodeMacro *)tracked_malloc(sizeof(NodeMacro), MEMORY_MACROS);
     if (list->head == NULL) {
         fprintf(stderr, "wasn't able to allocate memory for new node\n");
-        free(list);
+        tracked_free(list);
         return NULL;
     }
     /* Allocate memory for the initial macro data and copy it */
-    list->head->data = malloc(sizeof(struct macro));
+    list->head->data = tracked_malloc(sizeof(struct macro), MEMORY_MACROS);
     if (list->head->data == NULL) {
         fprintf(stderr, "wasn't able to allocate memory for new macro data\n");
-        free(list->head);
-        free(list);
+        tracked_free(list->head);
+        tracked_free(list);
         return NULL;
     }
 
@@ -222,14 +222,14 @@ MacroLinkedList *new_linked_list_macro(const struct macro *initial_macro) {
  * @return A pointer to the newly inserted NodeMacro, or NULL on failure.
  */
 NodeMacro *insert_macro_to_linked_list(MacroLinkedList **list, struct macro *macro) {
-    NodeMacro *new_node = (NodeMacro *)malloc(sizeof(NodeMacro));
+    NodeMacro *new_node = (NodeMacro *)tracked_malloc(sizeof(NodeMacro), MEMORY_MACROS);
     if (!new_node) {
         return NULL;
     }
     /* Allocate memory for the macro data in the new node and copy the data */
-    new_node->data = malloc(sizeof(struct macro));
+    new_node->data = tracked_malloc(sizeof(struct macro), MEMORY_MACROS);
     if (!new_node->data) {
-        free(new_node);
+        tracked_free(new_node);
         return NULL;
     }
     
@@ -238,11 +238,11 @@ NodeMacro *insert_macro_to_linked_list(MacroLinkedList **list, struct macro *mac
     new_node->next = NULL;
 
     if (!*list) {
-        /* If the linked list doesn't exist, create a new one with the given macro */
+        /* If the linked list doesn't exist, create a new one with the given macro, its head has its own copy */
+        tracked_free(new_node->data);
+        tracked_free(new_node);
         *list = new_linked_list_macro(macro);
         if (!*list) {
-            free(new_node->data);
-            free(new_node);
             return NULL;
         }
         /* Return the head of the newly created linked list */
@@ -261,97 +261,6 @@ NodeMacro *insert_macro_to_linked_list(MacroLinkedList **list, struct macro *mac
 
 
 
-/* Create a new linked list to store certain extern data.
- *
- * @param name_of_extern Name of the extern symbol.
- * @param address_of_extern Address of the extern symbol.
- * @return A pointer to the newly created CertainExternLinkedList, or NULL on failure.
- */
-CertainExternLinkedList *new_linked_list_certain_extern(const char *name_of_extern, long address_of_extern) {
-    /* Allocate memory for the linked list */
-    CertainExternLinkedList *list = (CertainExternLinkedList *)malloc(sizeof(CertainExternLinkedList));
-    if (!list) {
-        fprintf(stderr, "wasn't able to allocate memory for new certain_extern list\n");
-        return NULL;
-    }
-    /* Allocate memory for the head node */
-    list->head = (CertainExternNode *)malloc(sizeof(CertainExternNode));
-    if (!list->head) {
-        fprintf(stderr, "wasn't able to allocate memory for new node\n");
-        free(list);
-        return NULL;
-    }
-    /* Allocate memory for the initial extern data and copy it */
-    list->head->data = malloc(sizeof(struct certain_extern));
-    if (!list->head->data) {
-        fprintf(stderr, "wasn't able to allocate memory for new extern data\n");
-        free(list->head);
-        free(list);
-        return NULL;
-    }
-    /* Copy the name and address in to the new node's data */
-    strncpy(list->head->data->name_of_extern, name_of_extern, LABEL_MAX_LENGTH); 
-    list->head->data->name_of_extern[LABEL_MAX_LENGTH] = '\0';  
-    list->head->data->address_of_extern = address_of_extern; 
-    
-    list->tail = list->head; /* Set the tail to the head since there's only one node */
-    list->head->next = NULL; /* Set the next pointer of the head node to NULL */
-    list->size_of_linked_list = 1; /* Initialize the size of the linked list to 1 */
-
-    /* Return the new linked list that was created */
-    return list;
-}
-
-/* Insert certain extern data into the "CertainExternLinkedList".
- *
- * @param list A pointer to the pointer of the CertainExternLinkedList.
- * @param extern_data The certain extern data to be inserted into the linked list.
- * @return A pointer to the newly inserted CertainExternNode, or NULL on failure.
- */
-CertainExternNode *insert_certain_extern_to_linked_list(CertainExternLinkedList **list, struct certain_extern *extern_data) {
-    CertainExternNode *new_node;
-    if (!extern_data) {
-        return NULL;
-    }
-
-    if (!*list) {
-        /* If the linked list doesn't exist, create a new one with the given extern data */
-        *list = new_linked_list_certain_extern(extern_data->name_of_extern, extern_data->address_of_extern);
-        if (!*list) {
-            return NULL;
-        }
-        /* Return the head of the newly created linked list */
-        return (*list)->head;  
-    } else {
-        /* If the linked list already exists, insert a new node with the given extern data */
-
-        /* Allocate memory for the new node */
-        new_node = (CertainExternNode *)malloc(sizeof(CertainExternNode));
-        if (!new_node) {
-            return NULL;
-        }
-        /* Allocate memory for the extern data in the new node and copy the data */
-        new_node->data = malloc(sizeof(struct certain_extern));
-        if (!new_node->data) {
-            fprintf(stderr, "wasn't able to allocate memory for new extern data\n");
-            free(new_node);
-            return NULL;
-        }
-
-        memcpy(new_node->data, extern_data, sizeof(struct certain_extern));
-
-        (*list)->tail->next = new_node; /* Update next pointer of the current tail node */
-        (*list)->tail = (*list)->tail->next; /* Update the tail pointer to point to the next */
-        new_node->next = NULL; /* Set next pointer of new node to NULL */
-
-        (*list)->size_of_linked_list++; /* Increment the size of the linked list */
-        
-        /* Return the new node that was inserted */
-        return new_node;
-    }
-}
-
-
 /* Create a new linked list to store strings.
  *
  * @param initial_str The initial string to be stored in the linked list.
@@ -359,16 +268,16 @@ CertainExternNode *insert_certain_extern_to_linked_list(CertainExternLinkedList
  */
 StringLinkedList *new_linked_list_string(const char *initial_str) { 
     /* Allocate memory for the linked list */
-    StringLinkedList *list = (StringLinkedList *)malloc(sizeof(StringLinkedList));
+    StringLinkedList *list = (StringLinkedList *)tracked_malloc(sizeof(StringLinkedList), MEMORY_MACROS);
     if (!list) {
         fprintf(stderr, "wasn't able to allocate memory for new string list\n");
         return NULL;
     }
     /* Allocate memory for the head node */
-    list->head = (StringNode *)malloc(sizeof(StringNode));
+    list->head = (StringNode *)tracked_malloc(sizeof(StringNode), MEMORY_MACROS);
     if (!list->head) {
         fprintf(stderr, "wasn't able to allocate memory for the head node\n");
-        free(list);
+        tracked_free(list);
         return NULL;
     }
 
@@ -409,7 +318,7 @@ StringNode *insert_string_to_linked_list(StringLinkedList **list, const char *st
         /* If the linked list already exists, insert a new node with the given string */
 
         /* Allocate memory for the new node */
-        new_node = (StringNode *)malloc(sizeof(StringNode));
+        new_node = (StringNode *)tracked_malloc(sizeof(StringNode), MEMORY_MACROS);
         if (!new_node) {
             return NULL;
         }
@@ -431,37 +340,6 @@ StringNode *insert_string_to_linked_list(StringLinkedList **list, const char *st
 }
 
 
-/* Find a symbol in the "SymbolLinkedList".
- *
- * @param list The SymbolLinkedList to search in.
- * @param target_name The name of the symbol to search for.
- * @return A pointer to the symbol data if found, or NULL if not found or if inputs are NULL.
- */
-struct symbol* find_symbol_in_linked_list(const SymbolLinkedList *list, const char* target_name) {
-    SymbolNode *current;
-    struct symbol *symbol_data;
-
-    /* Return NULL if either the list or target_name is NULL */
-    if (!list || !target_name) return NULL;
-
-    /* Start from the head of the linked list */
-    current = list->head;
-    while (current) {
-        /* Get the symbol data of the current node */
-        symbol_data = (struct symbol*)current->symbol_data; 
-        /* Compare the name of the symbol with the target_name */
-        if (strcmp(symbol_data->name_of_symbol, target_name) == 0) {
-            /* Return the symbol data if found */
-            return symbol_data; 
-        }
-        current = current->next; /* Continue to the next node in the linked list */
-    }
-    
-    /* Return NULL if the symbol with the target_name was not found */
-    return NULL; 
-}
-
-
 /* Find a macro in the "MacroLinkedList".
  *
  * @param list The MacroLinkedList to search in.
@@ -535,43 +413,14 @@ void free_string_linked_list(StringLinkedList **list) {
         temp = current; 
         current = current->next;
         /* Free the memory allocated for the current node */
-        free(temp);        
+        tracked_free(temp);        
     }
     /* Free the memory allocated for the linked list */
-    free(*list);  
+    tracked_free(*list);  
     /* Set the input pointer to NULL to indicate that the linked list is freed */ 
     (*list) = NULL;
 }
 
-/* Free the memory of a "CertainExternLinkedList".
- *
- * @param list A pointer to the CertainExternLinkedList pointer.
- */
-
-void free_certain_extern_linked_list(CertainExternLinkedList **list) {
-    CertainExternNode *current;
-    CertainExternNode *temp;
-    if (list == NULL || *list == NULL) {
-        return;
-    }
-    /* Start from the head of the linked list */
-    current = (*list)->head;
-    while (current != NULL) {
-        /* Store the current node in a temporary variable */
-        temp = current;
-        current = current->next;
-        /* Free the memory allocated for the certain extern data */
-        free(temp->data);
-        /* Free the memory allocated for the current node */ 
-        free(temp);
-    }
-    
-    /* Free the memory allocated for the linked list */
-    free(*list);
-    /* Set the input pointer to NULL to indicate that the linked list is freed */
-    (*list) = NULL;
-}
-
 /* Free the memory of a "MacroLinkedList".
  *
  * @param list A pointer to the MacroLinkedList pointer.
@@ -588,15 +437,21 @@ void free_macro_linked_list(MacroLinkedList **list) {
         /* Store the current node in a temporary variable */
         temp = current;
         current = current->next;
-        /* Free the memory allocated for the lines_of_code linked list within the macro */
-        free_string_linked_list(&temp->data->lines_of_code); 
+        /* The template of an included macro belongs to the cache of included files */
+        if (!temp->data->is_included) {
+            /* Free the memory allocated for the lines in the source of the lines of code */
+            tracked_free(temp->data->lines_in_source);
+            /* Free the memory allocated for the expansion template */
+            tracked_free(temp->data->pieces);
+            tracked_free(temp->data->template_lines);
+        }
         /* Free the memory allocated for the macro data */
-        free(temp->data);
+        tracked_free(temp->data);
         /* Free the memory allocated for the current node */
-        free(temp);
+        tracked_free(temp);
     }
     /* Free the memory allocated for the linked list */
-    free(*list);
+    tracked_free(*list);
     /* Set the input pointer to NULL to indicate that the linked list is freed */
     (*list) = NULL;
 }
@@ -619,12 +474,12 @@ void free_symbol_linked_list(SymbolLinkedList **list) {
         temp = current;
         current = current->next;
         /* Free the memory allocated for the symbol data */
-        free(temp->symbol_data); 
+        tracked_free(temp->symbol_data); 
         /* Free the memory allocated for the current node */
-        free(temp);
+        tracked_free(temp);
     }
     /* Free the memory allocated for the linked list */
-    free(*list);
+    tracked_free(*list);
     /* Set the input pointer to NULL to indicate that the linked list is freed */
     (*list) = NULL;
 }
@@ -645,12 +500,12 @@ void free_symbols_not_found_linked_list(SymbolsNotFoundLinkedList **list) {
         temp = current;
         current = current->next;
         /* Free the memory allocated for the symbols not found data */
-        free(temp->data); 
+        tracked_free(temp->data); 
         /* Free the memory allocated for the current node */
-        free(temp);
+        tracked_free(temp);
     }
     /* Free the memory allocated for the linked list */
-    free(*list);
+    tracked_free(*list);
     /* Set the input pointer to NULL to indicate that the linked list is freed */
     (*list) = NULL;
 }
@@ -671,14 +526,6 @@ size_t get_amount_of_elements_in_macro_linked_list(const MacroLinkedList *list)
 size_t get_amount_of_elements_in_symbol_linked_list(const SymbolLinkedList *list) {
     return list->size_of_linked_list;
 }
-/* Get the amount of elements in the "CertainExternLinkedList".
- *
- * @param list A pointer to the CertainExternLinkedList.
- * @return The number of elements in the linked list.
- */
-size_t get_amount_of_elements_in_certain_extern_linked_list(const CertainExternLinkedList *list) {
-    return list->size_of_linked_list;
-}
 
 
 
@@ -35,14 +35,6 @@ void free_symbol_linked_list(SymbolLinkedList **list);
  */
 void free_macro_linked_list(MacroLinkedList **list);
 
-/* Finds a symbol in the symbol linked list by its name.
- *
- * @param list A pointer to the SymbolLinkedList.
- * @param target_name The name of the symbol to find.
- * @return A pointer to the symbol if found, NULL otherwise.
- */
-struct symbol* find_symbol_in_linked_list(const SymbolLinkedList *list, const char* target_name);
-
 /* Finds a macro in the macro linked list by its name.
  *
  * @param list A pointer to the MacroLinkedList.
@@ -65,22 +57,6 @@ size_t get_amount_of_elements_in_macro_linked_list(const MacroLinkedList *list);
  */
 size_t get_amount_of_elements_in_symbol_linked_list(const SymbolLinkedList *list);
 
-/* Creates a new linked list for certain externs.
- *
- * @param name_of_extern The name of the extern.
- * @param address_of_extern The address of the extern.
- * @return A pointer to the created CertainExternLinkedList or NULL on failure.
- */
-CertainExternLinkedList *new_linked_list_certain_extern(const char *name_of_extern, long address_of_extern);
-
-/* Inserts certain extern data into the linked list.
- *
- * @param list A pointer to the CertainExternLinkedList pointer.
- * @param extern_data A pointer to the certain extern data to be inserted.
- * @return A pointer to the inserted CertainExternNode or NULL on failure.
- */
-CertainExternNode *insert_certain_extern_to_linked_list(CertainExternLinkedList **list, struct certain_extern *extern_data);
-
 /* Creates a new linked list for symbols not found.
  *
  * @param initial_data The initial data for symbols not found.
@@ -116,19 +92,6 @@ MacroLinkedList *new_linked_list_macro(const struct macro *initial_macro);
  */
 SymbolLinkedList *new_symbol_linked_list(const struct symbol *initial_symbol);
 
-/* Frees memory allocated for a certain extern linked list and its elements.
- *
- * @param list A pointer to the CertainExternLinkedList pointer.
- */
-void free_certain_extern_linked_list(CertainExternLinkedList **list);
-
-/* Gets the number of elements in a certain extern linked list.
- *
- * @param list A pointer to the CertainExternLinkedList.
- * @return The number of elements in the linked list.
- */
-size_t get_amount_of_elements_in_certain_extern_linked_list(const CertainExternLinkedList *list);
-
 /* Creates a new linked list for strings.
  *
  * @param initial_str The initial string data.
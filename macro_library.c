@@ -0,0 +1,405 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "macro_library.h"
+#include "output_unit.h"
+#include "dependency_file.h"
+
+#define SIZE_OF_NAME_IN_LIBRARY 32
+
+/* Represents a .mlib file that was mapped in to memory */
+struct macro_library {
+    const char *name_of_file; /* The name of the .mlib file */
+    unsigned char *mapping; /* The mapping of the file */
+    size_t size_of_mapping; /* The size of the file */
+    const unsigned char *buckets; /* The buckets of the name index, in the mapping */
+    unsigned long amount_of_buckets; /* The number of buckets, a power of 2 */
+    struct macro *macros; /* The macros, their text is in the mapping */
+    unsigned long amount_of_macros; /* The number of macros */
+    struct macro_template_line *template_lines; /* The template lines of all the macros */
+    struct macro_piece *pieces; /* The pieces of all the macros */
+};
+
+/* The libraries that were loaded, they are searched in this order */
+static struct macro_library libraries[MAX_MACRO_LIBRARIES];
+static int amount_of_libraries = 0;
+
+/*
+ * Computes the FNV-1a hash of the name of a macro.
+ *
+ * @param name_of_macro The name of the macro.
+ * @return The hash of the name.
+ */
+static unsigned long hash_of_macro_name(const char *name_of_macro) {
+    return add_to_fnv1a_hash(FNV1A_OFFSET_BASIS, (const unsigned char *)name_of_macro, strlen(name_of_macro));
+}
+
+/*
+ * Finds the index of a macro in a table of macros.
+ *
+ * @param table_of_macros The macros.
+ * @param macro A pointer to the macro to find, it is compared by its name.
+ * @return The index of the macro, or -1 if it is not in the table.
+ */
+static long index_of_macro(const MacroLinkedList *table_of_macros, const struct macro *macro) {
+    const NodeMacro *current_node;
+    long index = 0;
+
+    for (current_node = table_of_macros->head; current_node != NULL; current_node = current_node->next, index++) {
+        if (strcmp(current_node->data->name_of_macro, macro->name_of_macro) == 0) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Writes the macros of a table to a .mlib file.
+ *
+ * The bodies of the macros are copied one after the other, and the calls between them are kept by their index.
+ *
+ * @param name_of_file The name of the .mlib file.
+ * @param table_of_macros The macros, with their templates compiled.
+ * @return 1 if the file was written, 0 if a macro calls a macro outside the table or the file couldn't be written.
+ */
+int write_macro_library(const char *name_of_file, const MacroLinkedList *table_of_macros) {
+    struct output_text library = {0};
+    const NodeMacro *current_node;
+    const struct macro *macro;
+    const struct macro_template_line *line;
+    const struct macro_piece *piece;
+    unsigned long amount_of_macros = 0;
+    unsigned long amount_of_lines = 0;
+    unsigned long amount_of_pieces = 0;
+    unsigned long size_of_text = 0;
+    unsigned long amount_of_buckets = 1;
+    unsigned long bucket;
+    unsigned long index = 0;
+    unsigned long first_line = 0;
+    unsigned long first_piece = 0;
+    unsigned long offset_of_body = 0;
+    unsigned char *buckets;
+    unsigned char *macros;
+    unsigned char *lines;
+    unsigned char *pieces;
+    char *text;
+    long index_of_called;
+    size_t i;
+    int written;
+
+    /* Count the parts, so the file is built in one buffer */
+    for (current_node = table_of_macros ? table_of_macros->head : NULL; current_node != NULL; current_node = current_node->next) {
+        amount_of_macros++;
+        amount_of_lines += current_node->data->amount_of_template_lines;
+        amount_of_pieces += current_node->data->amount_of_pieces;
+        size_of_text += current_node->data->length_of_body;
+    }
+    while (amount_of_buckets < amount_of_macros * 2) {
+        amount_of_buckets *= 2;
+    }
+    library.length = MACRO_LIBRARY_HEADER_SIZE + amount_of_buckets * 4 + amount_of_macros * MACRO_LIBRARY_MACRO_SIZE +
+                     amount_of_lines * MACRO_LIBRARY_LINE_SIZE + amount_of_pieces * MACRO_LIBRARY_PIECE_SIZE + size_of_text;
+    library.text = (char *)tracked_calloc(library.length + 1, 1, MEMORY_OUTPUTS);
+    if (library.text == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the macro library\n");
+        return 0;
+    }
+    library.capacity = library.length + 1;
+    buckets = (unsigned char *)library.text + MACRO_LIBRARY_HEADER_SIZE;
+    macros = buckets + amount_of_buckets * 4;
+    lines = macros + amount_of_macros * MACRO_LIBRARY_MACRO_SIZE;
+    pieces = lines + amount_of_lines * MACRO_LIBRARY_LINE_SIZE;
+    text = (char *)pieces + amount_of_pieces * MACRO_LIBRARY_PIECE_SIZE;
+
+    memcpy(library.text, MACRO_LIBRARY_MAGIC, 4);
+    put_little_endian((unsigned char *)library.text + 4, MACRO_LIBRARY_VERSION, 2);
+    put_little_endian((unsigned char *)library.text + 8, amount_of_buckets, 4);
+    put_little_endian((unsigned char *)library.text + 12, amount_of_macros, 4);
+    put_little_endian((unsigned char *)library.text + 16, amount_of_lines, 4);
+    put_little_endian((unsigned char *)library.text + 20, amount_of_pieces, 4);
+    put_little_endian((unsigned char *)library.text + 24, size_of_text, 4);
+
+    for (current_node = table_of_macros ? table_of_macros->head : NULL; current_node != NULL; current_node = current_node->next, index++) {
+        macro = current_node->data;
+        /* Add the name to the index */
+        for (bucket = hash_of_macro_name(macro->name_of_macro) & (amount_of_buckets - 1); get_little_endian(buckets + bucket * 4) != 0; bucket = (bucket + 1) & (amount_of_buckets - 1)) {
+        }
+        put_little_endian(buckets + bucket * 4, index + 1, 4);
+
+        strncpy((char *)macros, macro->name_of_macro, SIZE_OF_NAME_IN_LIBRARY - 1);
+        put_little_endian(macros + 32, macro->amount_of_parameters, 4);
+        put_little_endian(macros + 36, first_line, 4);
+        put_little_endian(macros + 40, macro->amount_of_template_lines, 4);
+        put_little_endian(macros + 44, first_piece, 4);
+        put_little_endian(macros + 48, macro->amount_of_pieces, 4);
+        macros += MACRO_LIBRARY_MACRO_SIZE;
+
+        for (i = 0; i < macro->amount_of_template_lines; i++, lines += MACRO_LIBRARY_LINE_SIZE) {
+            line = &macro->template_lines[i];
+            index_of_called = line->called_macro != NULL ? index_of_macro(table_of_macros, line->called_macro) : -1;
+            if (line->called_macro != NULL && index_of_called < 0) {
+                fprintf(stderr, "the macro '%s' calls the macro '%s', which is not in the library\n", macro->name_of_macro, line->called_macro->name_of_macro);
+                free_output_text(&library);
+                return 0;
+            }
+            put_little_endian(lines, line->first_piece, 4);
+            put_little_endian(lines + 4, line->amount_of_pieces, 4);
+            put_little_endian(lines + 8, index_of_called + 1, 4);
+            put_little_endian(lines + 12, line->line_in_source, 4);
+            put_little_endian(lines + 16, line->ends_line, 4);
+        }
+        /* The pieces point in to the body, which is copied after the bodies before it */
+        for (i = 0; i < macro->amount_of_pieces; i++, pieces += MACRO_LIBRARY_PIECE_SIZE) {
+            piece = &macro->pieces[i];
+            put_little_endian(pieces, piece->index_of_parameter >= 0 ? 0 : offset_of_body + piece->offset_in_source - macro->offset_of_body, 4);
+            put_little_endian(pieces + 4, piece->length, 4);
+            put_little_endian(pieces + 8, piece->index_of_parameter + 1, 4);
+        }
+        memcpy(text + offset_of_body, macro->source_text + macro->offset_of_body, macro->length_of_body);
+        first_line += macro->amount_of_template_lines;
+        first_piece += macro->amount_of_pieces;
+        offset_of_body += macro->length_of_body;
+    }
+    written = write_output_if_changed(name_of_file, &library);
+    free_output_text(&library);
+    return written;
+}
+
+/*
+ * Turns the records of a mapped library in to macros, and checks that they point inside the file.
+ *
+ * @param library A pointer to the library, its mapping and the numbers of its parts are set.
+ * @param macros The records of the macros.
+ * @param lines The records of the template lines.
+ * @param pieces The records of the pieces.
+ * @param amount_of_lines The number of template lines.
+ * @param amount_of_pieces The number of pieces.
+ * @param text The text of the bodies.
+ * @param size_of_text The size of the text.
+ * @return 1 if the records are valid, 0 otherwise.
+ */
+static int read_library_records(struct macro_library *library, const unsigned char *macros, const unsigned char *lines, const unsigned char *pieces,
+                                unsigned long amount_of_lines, unsigned long amount_of_pieces, const char *text, unsigned long size_of_text) {
+    struct macro *macro;
+    struct macro_template_line *line;
+    struct macro_piece *piece;
+    unsigned long first_line;
+    unsigned long first_piece;
+    unsigned long index_of_called;
+    unsigned long i;
+    size_t j;
+
+    for (i = 0; i < library->amount_of_buckets; i++) {
+        if (get_little_endian(library->buckets + i * 4) > library->amount_of_macros) {
+            return 0;
+        }
+    }
+    for (i = 0; i < amount_of_pieces; i++, pieces += MACRO_LIBRARY_PIECE_SIZE) {
+        piece = &library->pieces[i];
+        piece->offset_in_source = get_little_endian(pieces);
+        piece->length = get_little_endian(pieces + 4);
+        piece->index_of_parameter = (int)get_little_endian(pieces + 8) - 1;
+        if (piece->offset_in_source > size_of_text || piece->length > size_of_text - piece->offset_in_source ||
+            piece->index_of_parameter >= MAX_MACRO_PARAMETERS) {
+            return 0;
+        }
+    }
+    for (i = 0; i < amount_of_lines; i++, lines += MACRO_LIBRARY_LINE_SIZE) {
+        line = &library->template_lines[i];
+        line->first_piece = get_little_endian(lines);
+        line->amount_of_pieces = get_little_endian(lines + 4);
+        index_of_called = get_little_endian(lines + 8);
+        line->line_in_source = (unsigned int)get_little_endian(lines + 12);
+        line->ends_line = get_little_endian(lines + 16) != 0;
+        if (index_of_called > library->amount_of_macros) {
+            return 0;
+        }
+        line->called_macro = index_of_called > 0 ? &library->macros[index_of_called - 1] : NULL;
+    }
+    for (i = 0; i < library->amount_of_macros; i++, macros += MACRO_LIBRARY_MACRO_SIZE) {
+        macro = &library->macros[i];
+        if (memchr(macros, '\0', SIZE_OF_NAME_IN_LIBRARY) == NULL || strlen((const char *)macros) > MAX_LENGTH_OF_MACRO) {
+            return 0;
+        }
+        strcpy(macro->name_of_macro, (const char *)macros);
+        macro->amount_of_parameters = (int)get_little_endian(macros + 32);
+        first_line = get_little_endian(macros + 36);
+        macro->amount_of_template_lines = get_little_endian(macros + 40);
+        first_piece = get_little_endian(macros + 44);
+        macro->amount_of_pieces = get_little_endian(macros + 48);
+        if (macro->amount_of_parameters > MAX_MACRO_PARAMETERS || first_line > amount_of_lines || macro->amount_of_template_lines > amount_of_lines - first_line ||
+            first_piece > amount_of_pieces || macro->amount_of_pieces > amount_of_pieces - first_piece) {
+            return 0;
+        }
+        macro->template_lines = library->template_lines + first_line;
+        macro->pieces = library->pieces + first_piece;
+        macro->source_text = text;
+        macro->is_included = 1;
+        for (j = 0; j < macro->amount_of_template_lines; j++) {
+            if (macro->template_lines[j].first_piece > macro->amount_of_pieces ||
+                macro->template_lines[j].amount_of_pieces > macro->amount_of_pieces - macro->template_lines[j].first_piece) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/*
+ * Maps a .mlib file in to memory and adds its macros to the macros that every file can call.
+ *
+ * The name index and the text of the bodies are used from the mapping, only the templates are turned in to
+ * their structures, once for all the files that are assembled.
+ *
+ * @param name_of_file The name of the .mlib file.
+ * @return 1 if the library was loaded, 0 if it couldn't be read or is not a valid library.
+ */
+int load_macro_library(const char *name_of_file) {
+    struct macro_library *library;
+    struct stat status;
+    const unsigned char *header;
+    unsigned long amount_of_lines;
+    unsigned long amount_of_pieces;
+    unsigned long size_of_text;
+    unsigned long expected_size;
+    int file_descriptor;
+    void *mapping;
+
+    if (amount_of_libraries == MAX_MACRO_LIBRARIES) {
+        fprintf(stderr, "there can be at most %d macro libraries\n", MAX_MACRO_LIBRARIES);
+        return 0;
+    }
+    file_descriptor = open(name_of_file, O_RDONLY);
+    if (file_descriptor < 0) {
+        fprintf(stderr, "Unable to open file: %s\n", name_of_file);
+        return 0;
+    }
+    if (fstat(file_descriptor, &status) != 0 || status.st_size < MACRO_LIBRARY_HEADER_SIZE) {
+        fprintf(stderr, "the file %s is not a macro library\n", name_of_file);
+        close(file_descriptor);
+        return 0;
+    }
+    mapping = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    close(file_descriptor);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "wasn't able to map the file: %s\n", name_of_file);
+        return 0;
+    }
+    library = &libraries[amount_of_libraries];
+    memset(library, 0, sizeof(struct macro_library));
+    library->name_of_file = name_of_file;
+    library->mapping = (unsigned char *)mapping;
+    library->size_of_mapping = (size_t)status.st_size;
+
+    header = library->mapping;
+    library->amount_of_buckets = get_little_endian(header + 8);
+    library->amount_of_macros = get_little_endian(header + 12);
+    amount_of_lines = get_little_endian(header + 16);
+    amount_of_pieces = get_little_endian(header + 20);
+    size_of_text = get_little_endian(header + 24);
+    /* The parts must fill the file exactly, the numbers are small enough that the sum can't overflow */
+    expected_size = MACRO_LIBRARY_HEADER_SIZE + library->amount_of_buckets * 4 + library->amount_of_macros * MACRO_LIBRARY_MACRO_SIZE +
+                    amount_of_lines * MACRO_LIBRARY_LINE_SIZE + amount_of_pieces * MACRO_LIBRARY_PIECE_SIZE + size_of_text;
+    if (memcmp(header, MACRO_LIBRARY_MAGIC, 4) != 0 || header[4] != MACRO_LIBRARY_VERSION || header[5] != 0 ||
+        library->amount_of_buckets == 0 || (library->amount_of_buckets & (library->amount_of_buckets - 1)) != 0 ||
+        library->amount_of_macros >= library->amount_of_buckets || library->amount_of_buckets > library->size_of_mapping ||
+        library->amount_of_macros > library->size_of_mapping || amount_of_lines > library->size_of_mapping ||
+        amount_of_pieces > library->size_of_mapping || expected_size != library->size_of_mapping) {
+        fprintf(stderr, "the file %s is not a valid macro library\n", name_of_file);
+        munmap(mapping, library->size_of_mapping);
+        return 0;
+    }
+    library->buckets = header + MACRO_LIBRARY_HEADER_SIZE;
+    library->macros = (struct macro *)tracked_calloc(library->amount_of_macros + 1, sizeof(struct macro), MEMORY_MACROS);
+    library->template_lines = (struct macro_template_line *)tracked_calloc(amount_of_lines + 1, sizeof(struct macro_template_line), MEMORY_MACRO_LINES);
+    library->pieces = (struct macro_piece *)tracked_calloc(amount_of_pieces + 1, sizeof(struct macro_piece), MEMORY_MACRO_LINES);
+    if (library->macros == NULL || library->template_lines == NULL || library->pieces == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the macro library\n");
+    } else if (read_library_records(library, library->buckets + library->amount_of_buckets * 4,
+                                    library->buckets + library->amount_of_buckets * 4 + library->amount_of_macros * MACRO_LIBRARY_MACRO_SIZE,
+                                    library->mapping + expected_size - size_of_text - amount_of_pieces * MACRO_LIBRARY_PIECE_SIZE,
+                                    amount_of_lines, amount_of_pieces, (const char *)library->mapping + expected_size - size_of_text, size_of_text)) {
+        amount_of_libraries++;
+        return 1;
+    } else {
+        fprintf(stderr, "the file %s is not a valid macro library\n", name_of_file);
+    }
+    tracked_free(library->macros);
+    tracked_free(library->template_lines);
+    tracked_free(library->pieces);
+    munmap(mapping, library->size_of_mapping);
+    return 0;
+}
+
+/*
+ * Finds a macro in the loaded libraries, in the order they were loaded.
+ *
+ * @param name_of_macro The name of the macro.
+ * @return A pointer to the macro, or NULL if no library has it.
+ */
+struct macro *find_library_macro(const char *name_of_macro) {
+    const struct macro_library *library;
+    unsigned long hash;
+    unsigned long bucket;
+    unsigned long index;
+    int i;
+
+    if (amount_of_libraries == 0) {
+        return NULL;
+    }
+    hash = hash_of_macro_name(name_of_macro);
+    for (i = 0; i < amount_of_libraries; i++) {
+        library = &libraries[i];
+        /* There is always an empty bucket, so the probing ends */
+        for (bucket = hash & (library->amount_of_buckets - 1); (index = get_little_endian(library->buckets + bucket * 4)) != 0;
+             bucket = (bucket + 1) & (library->amount_of_buckets - 1)) {
+            if (strcmp(library->macros[index - 1].name_of_macro, name_of_macro) == 0) {
+                return &library->macros[index - 1];
+            }
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Checks if any macro library was loaded.
+ *
+ * @return 1 if a library was loaded, 0 otherwise.
+ */
+int macro_libraries_are_loaded(void) {
+    return amount_of_libraries > 0;
+}
+
+/*
+ * Adds the loaded libraries to the dependencies of a module, every module can call their macros.
+ *
+ * @param dependencies A pointer to the dependencies of the module.
+ */
+void add_macro_library_dependencies(struct source_dependencies *dependencies) {
+    int i;
+
+    for (i = 0; i < amount_of_libraries; i++) {
+        add_source_dependency(dependencies, libraries[i].name_of_file);
+    }
+}
+
+/*
+ * Unmaps the loaded libraries and frees their macros.
+ */
+void free_macro_libraries(void) {
+    int i;
+
+    for (i = 0; i < amount_of_libraries; i++) {
+        tracked_free(libraries[i].macros);
+        tracked_free(libraries[i].template_lines);
+        tracked_free(libraries[i].pieces);
+        munmap(libraries[i].mapping, libraries[i].size_of_mapping);
+    }
+    amount_of_libraries = 0;
+}
@@ -0,0 +1,83 @@
+#ifndef __MACRO_LIBRARY_H_
+#define __MACRO_LIBRARY_H_
+
+#include "common.h"
+#include "linked_list.h"
+
+#define FILE_EXTENSION_MLIB ".mlib"
+#define MAX_MACRO_PARAMETERS 9
+#define MAX_MACRO_LIBRARIES 16
+
+/*
+ * The .mlib file is little endian and made of six parts:
+ * a header of MACRO_LIBRARY_HEADER_SIZE bytes - the magic "MLIB", the version (2 bytes), 2 reserved bytes,
+ *     the number of buckets, macros, template lines and pieces, and the size of the text (4 bytes each),
+ * the buckets of the name index, 4 bytes each - the index of a macro plus one, 0 for an empty bucket.
+ *     A name is looked for from the bucket of its FNV-1a hash, modulo the number of buckets, which is a power of 2,
+ *     and in the buckets after it until an empty bucket,
+ * the macros, MACRO_LIBRARY_MACRO_SIZE bytes each - the name (32 bytes, null padded), the number of parameters,
+ *     the index of the first template line, the number of template lines, the index of the first piece and the number of pieces (4 bytes each),
+ * the template lines, MACRO_LIBRARY_LINE_SIZE bytes each - the index of the first piece among the pieces of its macro,
+ *     the number of pieces, the index of the called macro plus one (0 if the line doesn't call a macro), the line in the source file,
+ *     and 1 if the line ends with a new line (4 bytes each),
+ * the pieces, MACRO_LIBRARY_PIECE_SIZE bytes each - the offset of the text in the text of the bodies,
+ *     the number of characters, and the parameter plus one (0 for text) (4 bytes each),
+ * and the text of the bodies of the macros, one after the other.
+ */
+#define MACRO_LIBRARY_MAGIC "MLIB"
+#define MACRO_LIBRARY_VERSION 1
+#define MACRO_LIBRARY_HEADER_SIZE 28
+#define MACRO_LIBRARY_MACRO_SIZE 52
+#define MACRO_LIBRARY_LINE_SIZE 20
+#define MACRO_LIBRARY_PIECE_SIZE 12
+
+/*
+ * Writes the macros of a table to a .mlib file.
+ *
+ * The bodies of the macros are copied one after the other, and the calls between them are kept by their index.
+ *
+ * @param name_of_file The name of the .mlib file.
+ * @param table_of_macros The macros, with their templates compiled.
+ * @return 1 if the file was written, 0 if a macro calls a macro outside the table or the file couldn't be written.
+ */
+int write_macro_library(const char *name_of_file, const MacroLinkedList *table_of_macros);
+
+/*
+ * Maps a .mlib file in to memory and adds its macros to the macros that every file can call.
+ *
+ * The name index and the text of the bodies are used from the mapping, only the templates are turned in to
+ * their structures, once for all the files that are assembled.
+ *
+ * @param name_of_file The name of the .mlib file.
+ * @return 1 if the library was loaded, 0 if it couldn't be read or is not a valid library.
+ */
+int load_macro_library(const char *name_of_file);
+
+/*
+ * Finds a macro in the loaded libraries, in the order they were loaded.
+ *
+ * @param name_of_macro The name of the macro.
+ * @return A pointer to the macro, or NULL if no library has it.
+ */
+struct macro *find_library_macro(const char *name_of_macro);
+
+/*
+ * Checks if any macro library was loaded.
+ *
+ * @return 1 if a library was loaded, 0 otherwise.
+ */
+int macro_libraries_are_loaded(void);
+
+/*
+ * Adds the loaded libraries to the dependencies of a module, every module can call their macros.
+ *
+ * @param dependencies A pointer to the dependencies of the module.
+ */
+void add_macro_library_dependencies(struct source_dependencies *dependencies);
+
+/*
+ * Unmaps the loaded libraries and frees their macros.
+ */
+void free_macro_libraries(void);
+
+#endif
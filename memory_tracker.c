@@ -0,0 +1,324 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "memory_tracker.h"
+
+/* Represents the header that comes before every tracked block */
+struct allocation_header {
+    size_t size; /* The size of the block, without the header */
+    int tag; /* The owner of the block */
+    int is_counted; /* Set if the block is in the counters, the blocks from before the counting started are not */
+    int is_listed; /* Set if the block is in the list of the leak tracking */
+    const char *name_of_source; /* The source file the block was allocated in */
+    int line_in_source; /* The line the block was allocated in */
+    struct allocation_header *previous; /* The block before it in the list of the leak tracking */
+    struct allocation_header *next; /* The block after it in the list of the leak tracking */
+};
+
+/* The header is padded to the strictest alignment, so the block after it is aligned like one from malloc */
+union aligned_header {
+    struct allocation_header header;
+    long double for_alignment_of_long_double;
+    void *for_alignment_of_pointer;
+    long for_alignment_of_long;
+};
+
+/* Represents the counters of an owner */
+struct memory_counters {
+    long allocations; /* The number of blocks that were allocated */
+    long live_blocks; /* The number of blocks that are allocated now */
+    size_t live_bytes; /* The bytes of the blocks that are allocated now */
+    size_t peak_bytes; /* The most bytes that were allocated at once */
+};
+
+static const char *names_of_memory_tags[AMOUNT_OF_MEMORY_TAGS] = {
+    "symbols", /* [MEMORY_SYMBOLS] */
+    "fixups", /* [MEMORY_FIXUPS] */
+    "externs", /* [MEMORY_EXTERNS] */
+    "macros", /* [MEMORY_MACROS] */
+    "macro lines", /* [MEMORY_MACRO_LINES] */
+    "file names", /* [MEMORY_FILE_NAMES] */
+    "sources", /* [MEMORY_SOURCES] */
+    "lexed lines", /* [MEMORY_LEXED_LINES] */
+    "code", /* [MEMORY_CODE] */
+    "outputs", /* [MEMORY_OUTPUTS] */
+    "constant pool", /* [MEMORY_CONSTANT_POOL] */
+    "optimizer", /* [MEMORY_OPTIMIZER] */
+    "source map" /* [MEMORY_SOURCE_MAP] */
+};
+
+/* The counters of every owner and of all of them, the helper threads allocate too, so they are changed under the lock */
+static struct memory_counters counters_of_tags[AMOUNT_OF_MEMORY_TAGS];
+static struct memory_counters counters_of_all;
+static pthread_mutex_t lock_of_memory = PTHREAD_MUTEX_INITIALIZER;
+/* The blocks that were allocated since the leak tracking started, the newest first */
+static struct allocation_header *listed_blocks = NULL;
+/* Set once by the main thread before the helper threads start, a run without them doesn't take the lock */
+static int counting_memory = 0;
+static int tracking_leaks = 0;
+
+/*
+ * Counts a block that was allocated or freed.
+ *
+ * The lock of the memory is held by the caller.
+ *
+ * @param counters A pointer to the counters.
+ * @param size The size of the block.
+ * @param allocated 1 if the block was allocated, 0 if it was freed.
+ */
+static void count_block(struct memory_counters *counters, size_t size, int allocated) {
+    if (allocated) {
+        counters->allocations++;
+        counters->live_blocks++;
+        counters->live_bytes += size;
+        if (counters->live_bytes > counters->peak_bytes) {
+            counters->peak_bytes = counters->live_bytes;
+        }
+    } else {
+        counters->live_blocks--;
+        counters->live_bytes -= size;
+    }
+}
+
+/*
+ * Adds a block to the counters and to the list of the leak tracking, if it is on.
+ *
+ * The lock of the memory is held by the caller.
+ *
+ * @param header A pointer to the header of the block, its size and owner are set.
+ */
+static void add_block(struct allocation_header *header) {
+    header->is_counted = 1;
+    count_block(&counters_of_tags[header->tag], header->size, 1);
+    count_block(&counters_of_all, header->size, 1);
+    header->is_listed = tracking_leaks;
+    header->previous = NULL;
+    header->next = NULL;
+    if (tracking_leaks) {
+        header->next = listed_blocks;
+        if (listed_blocks != NULL) {
+            listed_blocks->previous = header;
+        }
+        listed_blocks = header;
+    }
+}
+
+/*
+ * Removes a block from the counters and from the list of the leak tracking.
+ *
+ * The lock of the memory is held by the caller.
+ *
+ * @param header A pointer to the header of the block.
+ */
+static void remove_block(struct allocation_header *header) {
+    count_block(&counters_of_tags[header->tag], header->size, 0);
+    count_block(&counters_of_all, header->size, 0);
+    if (header->is_listed) {
+        if (header->previous != NULL) {
+            header->previous->next = header->next;
+        } else {
+            listed_blocks = header->next;
+        }
+        if (header->next != NULL) {
+            header->next->previous = header->previous;
+        }
+    }
+}
+
+/*
+ * Allocates a block of memory and counts it for its owner.
+ *
+ * The block starts after a header that keeps its size and owner, so it must be freed with tracked_free.
+ *
+ * @param size The size of the block.
+ * @param tag The owner of the block, one of the MEMORY_ tags.
+ * @param name_of_source The source file of the call.
+ * @param line_in_source The line of the call.
+ * @return A pointer to the block, or NULL on memory allocation error.
+ */
+void *track_malloc(size_t size, int tag, const char *name_of_source, int line_in_source) {
+    union aligned_header *block;
+
+    block = (union aligned_header *)malloc(sizeof(union aligned_header) + size);
+    if (block == NULL) {
+        return NULL;
+    }
+    block->header.size = size;
+    block->header.tag = tag;
+    block->header.name_of_source = name_of_source;
+    block->header.line_in_source = line_in_source;
+    block->header.is_counted = 0;
+    block->header.is_listed = 0;
+    if (counting_memory) {
+        pthread_mutex_lock(&lock_of_memory);
+        add_block(&block->header);
+        pthread_mutex_unlock(&lock_of_memory);
+    }
+    return block + 1;
+}
+
+/*
+ * Allocates a block of memory that is filled with zeros and counts it for its owner.
+ *
+ * @param amount The number of elements.
+ * @param size The size of an element.
+ * @param tag The owner of the block, one of the MEMORY_ tags.
+ * @param name_of_source The source file of the call.
+ * @param line_in_source The line of the call.
+ * @return A pointer to the block, or NULL on memory allocation error.
+ */
+void *track_calloc(size_t amount, size_t size, int tag, const char *name_of_source, int line_in_source) {
+    void *block;
+
+    /* The product must not wrap around, like in calloc */
+    if (size != 0 && amount > ((size_t)-1 - sizeof(union aligned_header)) / size) {
+        return NULL;
+    }
+    block = track_malloc(amount * size, tag, name_of_source, line_in_source);
+    if (block != NULL) {
+        memset(block, 0, amount * size);
+    }
+    return block;
+}
+
+/*
+ * Changes the size of a block of memory, like realloc.
+ *
+ * @param block The block, from one of the tracked allocations, or NULL to allocate a new one.
+ * @param size The new size of the block.
+ * @param tag The owner of a new block, a block that exists keeps its owner.
+ * @param name_of_source The source file of the call.
+ * @param line_in_source The line of the call.
+ * @return A pointer to the block, or NULL on memory allocation error, the old block is kept then.
+ */
+void *track_realloc(void *block, size_t size, int tag, const char *name_of_source, int line_in_source) {
+    union aligned_header *old_block;
+    union aligned_header *new_block;
+
+    if (block == NULL) {
+        return track_malloc(size, tag, name_of_source, line_in_source);
+    }
+    old_block = (union aligned_header *)block - 1;
+    if (!old_block->header.is_counted) {
+        new_block = (union aligned_header *)realloc(old_block, sizeof(union aligned_header) + size);
+        if (new_block == NULL) {
+            return NULL;
+        }
+        new_block->header.size = size;
+        return new_block + 1;
+    }
+    /* The block may move, so it leaves the list while realloc runs */
+    pthread_mutex_lock(&lock_of_memory);
+    remove_block(&old_block->header);
+    new_block = (union aligned_header *)realloc(old_block, sizeof(union aligned_header) + size);
+    if (new_block == NULL) {
+        add_block(&old_block->header);
+        pthread_mutex_unlock(&lock_of_memory);
+        return NULL;
+    }
+    new_block->header.size = size;
+    new_block->header.name_of_source = name_of_source;
+    new_block->header.line_in_source = line_in_source;
+    add_block(&new_block->header);
+    pthread_mutex_unlock(&lock_of_memory);
+    return new_block + 1;
+}
+
+/*
+ * Allocates a copy of a string and counts it for its owner.
+ *
+ * @param str The null terminated string to copy.
+ * @param tag The owner of the copy, one of the MEMORY_ tags.
+ * @param name_of_source The source file of the call.
+ * @param line_in_source The line of the call.
+ * @return A pointer to the copy, or NULL on memory allocation error.
+ */
+char *track_strdup(const char *str, int tag, const char *name_of_source, int line_in_source) {
+    char *copy = (char *)track_malloc(strlen(str) + 1, tag, name_of_source, line_in_source);
+
+    if (copy != NULL) {
+        strcpy(copy, str);
+    }
+    return copy;
+}
+
+/*
+ * Frees a block of memory from one of the tracked allocations.
+ *
+ * @param block The block, or NULL.
+ */
+void tracked_free(void *block) {
+    union aligned_header *freed_block;
+
+    if (block == NULL) {
+        return;
+    }
+    freed_block = (union aligned_header *)block - 1;
+    if (freed_block->header.is_counted) {
+        pthread_mutex_lock(&lock_of_memory);
+        remove_block(&freed_block->header);
+        pthread_mutex_unlock(&lock_of_memory);
+    }
+    free(freed_block);
+}
+
+/*
+ * Starts to count the blocks that are allocated from now on for their owners (--mem-stats).
+ *
+ * It is called before the helper threads start, the blocks from before it are not counted.
+ */
+void start_memory_statistics(void) {
+    pthread_mutex_lock(&lock_of_memory);
+    counting_memory = 1;
+    pthread_mutex_unlock(&lock_of_memory);
+}
+
+/*
+ * Starts to keep a list of the blocks that are allocated from now on, so the blocks that are
+ * never freed can be reported with their place in the source (--mem-leaks). The blocks are counted too.
+ */
+void start_memory_leak_tracking(void) {
+    pthread_mutex_lock(&lock_of_memory);
+    counting_memory = 1;
+    tracking_leaks = 1;
+    pthread_mutex_unlock(&lock_of_memory);
+}
+
+/*
+ * Prints the allocations, the live blocks and bytes and the peak of bytes of every owner (--mem-stats).
+ */
+void print_memory_statistics(void) {
+    const struct memory_counters *counters;
+    int i;
+
+    pthread_mutex_lock(&lock_of_memory);
+    printf("memory: %-13s %12s %12s %12s %12s\n", "owner", "allocations", "live blocks", "live bytes", "peak bytes");
+    for (i = 0; i <= AMOUNT_OF_MEMORY_TAGS; i++) {
+        counters = i < AMOUNT_OF_MEMORY_TAGS ? &counters_of_tags[i] : &counters_of_all;
+        printf("memory: %-13s %12ld %12ld %12lu %12lu\n", i < AMOUNT_OF_MEMORY_TAGS ? names_of_memory_tags[i] : "all", counters->allocations,
+               counters->live_blocks, (unsigned long)counters->live_bytes, (unsigned long)counters->peak_bytes);
+    }
+    pthread_mutex_unlock(&lock_of_memory);
+}
+
+/*
+ * Prints every block that is still allocated and was allocated after start_memory_leak_tracking.
+ *
+ * @return The number of blocks that are still allocated.
+ */
+long print_memory_leaks(void) {
+    const struct allocation_header *header;
+    long amount_of_leaks = 0;
+
+    pthread_mutex_lock(&lock_of_memory);
+    /* The list is newest first, so it is printed from its end */
+    for (header = listed_blocks; header != NULL && header->next != NULL; header = header->next) {
+    }
+    for (; header != NULL; header = header->previous, amount_of_leaks++) {
+        fprintf(stderr, "leak: %lu bytes of %s allocated at %s:%d\n", (unsigned long)header->size,
+                names_of_memory_tags[header->tag], header->name_of_source, header->line_in_source);
+    }
+    pthread_mutex_unlock(&lock_of_memory);
+    return amount_of_leaks;
+}
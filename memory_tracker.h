@@ -0,0 +1,112 @@
+#ifndef __MEMORY_TRACKER_H_
+#define __MEMORY_TRACKER_H_
+
+#include <stddef.h>
+
+/* The owners that every block of memory is counted for */
+#define MEMORY_SYMBOLS 0
+#define MEMORY_FIXUPS 1
+#define MEMORY_EXTERNS 2
+#define MEMORY_MACROS 3
+#define MEMORY_MACRO_LINES 4
+#define MEMORY_FILE_NAMES 5
+#define MEMORY_SOURCES 6
+#define MEMORY_LEXED_LINES 7
+#define MEMORY_CODE 8
+#define MEMORY_OUTPUTS 9
+#define MEMORY_CONSTANT_POOL 10
+#define MEMORY_OPTIMIZER 11
+#define MEMORY_SOURCE_MAP 12
+#define AMOUNT_OF_MEMORY_TAGS 13
+
+/*
+ * Every block of the assembler is allocated through these macros and freed with tracked_free,
+ * they record the place of the call for the report of the leaks. Until the counting starts,
+ * a block only costs its header.
+ */
+#define tracked_malloc(size, tag) track_malloc((size), (tag), __FILE__, __LINE__)
+#define tracked_calloc(amount, size, tag) track_calloc((amount), (size), (tag), __FILE__, __LINE__)
+#define tracked_realloc(block, size, tag) track_realloc((block), (size), (tag), __FILE__, __LINE__)
+#define tracked_strdup(str, tag) track_strdup((str), (tag), __FILE__, __LINE__)
+
+/*
+ * Allocates a block of memory and counts it for its owner.
+ *
+ * The block starts after a header that keeps its size and owner, so it must be freed with tracked_free.
+ *
+ * @param size The size of the block.
+ * @param tag The owner of the block, one of the MEMORY_ tags.
+ * @param name_of_source The source file of the call.
+ * @param line_in_source The line of the call.
+ * @return A pointer to the block, or NULL on memory allocation error.
+ */
+void *track_malloc(size_t size, int tag, const char *name_of_source, int line_in_source);
+
+/*
+ * Allocates a block of memory that is filled with zeros and counts it for its owner.
+ *
+ * @param amount The number of elements.
+ * @param size The size of an element.
+ * @param tag The owner of the block, one of the MEMORY_ tags.
+ * @param name_of_source The source file of the call.
+ * @param line_in_source The line of the call.
+ * @return A pointer to the block, or NULL on memory allocation error.
+ */
+void *track_calloc(size_t amount, size_t size, int tag, const char *name_of_source, int line_in_source);
+
+/*
+ * Changes the size of a block of memory, like realloc.
+ *
+ * @param block The block, from one of the tracked allocations, or NULL to allocate a new one.
+ * @param size The new size of the block.
+ * @param tag The owner of a new block, a block that exists keeps its owner.
+ * @param name_of_source The source file of the call.
+ * @param line_in_source The line of the call.
+ * @return A pointer to the block, or NULL on memory allocation error, the old block is kept then.
+ */
+void *track_realloc(void *block, size_t size, int tag, const char *name_of_source, int line_in_source);
+
+/*
+ * Allocates a copy of a string and counts it for its owner.
+ *
+ * @param str The null terminated string to copy.
+ * @param tag The owner of the copy, one of the MEMORY_ tags.
+ * @param name_of_source The source file of the call.
+ * @param line_in_source The line of the call.
+ * @return A pointer to the copy, or NULL on memory allocation error.
+ */
+char *track_strdup(const char *str, int tag, const char *name_of_source, int line_in_source);
+
+/*
+ * Frees a block of memory from one of the tracked allocations.
+ *
+ * @param block The block, or NULL.
+ */
+void tracked_free(void *block);
+
+/*
+ * Starts to count the blocks that are allocated from now on for their owners (--mem-stats).
+ *
+ * It is called before the helper threads start, the blocks from before it are not counted.
+ */
+void start_memory_statistics(void);
+
+/*
+ * Starts to keep a list of the blocks that are allocated from now on, so the blocks that are
+ * never freed can be reported with their place in the source (--mem-leaks). The blocks are counted too.
+ */
+void start_memory_leak_tracking(void);
+
+/*
+ * Prints the allocations, the live blocks and bytes and the peak of bytes of every owner (--mem-stats).
+ */
+void print_memory_statistics(void);
+
+/*
+ * Prints every block that is still allocated and was allocated after start_memory_leak_tracking.
+ *
+ * @return The number of blocks that are still allocated.
+ */
+long print_memory_leaks(void);
+
+#endif
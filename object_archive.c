@@ -0,0 +1,567 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "object_archive.h"
+#include "input_files.h"
+
+/* The extensions of the files of a member, in the order of their records */
+static const char *extensions_of_member_files[AMOUNT_OF_MEMBER_FILES] = {
+    FILE_EXTENSION_OB, FILE_EXTENSION_ENT, FILE_EXTENSION_EXT, FILE_EXTENSION_REL
+};
+
+/* Represents an archive file that was mapped in to memory */
+struct mapped_archive {
+    unsigned char *mapping; /* The mapping of the file */
+    size_t size_of_mapping; /* The size of the file */
+    const unsigned char *buckets; /* The buckets of the export index, in the mapping */
+    unsigned long amount_of_buckets; /* The number of buckets, a power of 2 */
+    const unsigned char *members; /* The records of the members */
+    unsigned long amount_of_members; /* The number of members */
+    const unsigned char *exports; /* The records of the exports */
+    unsigned long amount_of_exports; /* The number of exports */
+    const char *names; /* The names, the last one ends at the end of the names */
+    unsigned long size_of_names; /* The size of the names */
+    const char *contents; /* The files of the members */
+    unsigned long size_of_contents; /* The size of the files */
+};
+
+/*
+ * Computes the FNV-1a hash of the name of a symbol.
+ *
+ * @param name_of_symbol The name of the symbol.
+ * @return The hash of the name.
+ */
+static unsigned long hash_of_symbol_name(const char *name_of_symbol) {
+    return add_to_fnv1a_hash(FNV1A_OFFSET_BASIS, (const unsigned char *)name_of_symbol, strlen(name_of_symbol));
+}
+
+/*
+ * Appends bytes to a text that is built in memory, and keeps it null terminated.
+ *
+ * @param text A pointer to the text.
+ * @param bytes The bytes to append.
+ * @param amount_of_bytes The number of bytes.
+ * @return 1 if the bytes were appended, 0 on memory allocation error.
+ */
+static int append_bytes(struct output_text *text, const char *bytes, size_t amount_of_bytes) {
+    char *bigger_text;
+    size_t new_capacity;
+
+    if (text->length + amount_of_bytes + 1 > text->capacity) {
+        new_capacity = text->capacity ? text->capacity * 2 : 4096;
+        while (new_capacity < text->length + amount_of_bytes + 1) {
+            new_capacity *= 2;
+        }
+        bigger_text = (char *)tracked_realloc(text->text, new_capacity, MEMORY_OUTPUTS);
+        if (bigger_text == NULL) {
+            fprintf(stderr, "wasn't able to allocate memory for the archive\n");
+            return 0;
+        }
+        text->text = bigger_text;
+        text->capacity = new_capacity;
+    }
+    memcpy(text->text + text->length, bytes, amount_of_bytes);
+    text->length += amount_of_bytes;
+    text->text[text->length] = '\0';
+    return 1;
+}
+
+/*
+ * Appends a name and its null terminator to the names of an archive.
+ *
+ * @param names A pointer to the names.
+ * @param name The name.
+ * @param length_of_name The number of characters of the name.
+ * @param offset_of_name Receives the offset of the name in the names.
+ * @return 1 if the name was appended, 0 on memory allocation error.
+ */
+static int append_name(struct output_text *names, const char *name, size_t length_of_name, unsigned long *offset_of_name) {
+    *offset_of_name = (unsigned long)names->length;
+    return append_bytes(names, name, length_of_name) && append_bytes(names, "", 1);
+}
+
+/*
+ * Appends the whole content of a file to a text.
+ *
+ * @param text A pointer to the text.
+ * @param name_of_file The name of the file.
+ * @return 1 if the file was appended, 0 if it doesn't exist, -1 if it couldn't be read or on memory allocation error.
+ */
+static int append_file(struct output_text *text, const char *name_of_file) {
+    char chunk[4096];
+    FILE *file;
+    size_t amount_read;
+    int appended = 1;
+
+    file = fopen(name_of_file, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    while (appended == 1 && (amount_read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        appended = append_bytes(text, chunk, amount_read) ? 1 : -1;
+    }
+    if (ferror(file)) {
+        fprintf(stderr, "wasn't able to read file: %s\n", name_of_file);
+        appended = -1;
+    }
+    fclose(file);
+    return appended;
+}
+
+/*
+ * Adds the entries of the .ent file of a member to the exports of an archive.
+ *
+ * Every line of the .ent file is the name of a symbol and its address, separated by a tab.
+ *
+ * @param archive A pointer to the archive, the .ent file is already in its contents.
+ * @param index_of_member The index of the member.
+ * @return 1 if the entries were added, 0 on memory allocation error.
+ */
+static int add_member_exports(struct object_archive *archive, size_t index_of_member) {
+    const struct archive_member *member = &archive->members[index_of_member];
+    struct archive_export *bigger_exports;
+    struct archive_export *export;
+    const char *line;
+    const char *end_of_ent;
+    const char *tab;
+    const char *end_of_line;
+    size_t new_capacity;
+
+    line = archive->contents.text + member->offsets_of_files[1];
+    end_of_ent = line + member->sizes_of_files[1];
+    for (; line < end_of_ent; line = end_of_line + 1) {
+        end_of_line = (const char *)memchr(line, '\n', end_of_ent - line);
+        if (end_of_line == NULL) {
+            end_of_line = end_of_ent;
+        }
+        tab = (const char *)memchr(line, '\t', end_of_line - line);
+        if (tab == NULL || tab == line) {
+            continue;
+        }
+        if (archive->amount_of_exports == archive->capacity_of_exports) {
+            new_capacity = archive->capacity_of_exports ? archive->capacity_of_exports * 2 : 64;
+            bigger_exports = (struct archive_export *)tracked_realloc(archive->exports, new_capacity * sizeof(struct archive_export), MEMORY_OUTPUTS);
+            if (bigger_exports == NULL) {
+                fprintf(stderr, "wasn't able to allocate memory for the exports of the archive\n");
+                return 0;
+            }
+            archive->exports = bigger_exports;
+            archive->capacity_of_exports = new_capacity;
+        }
+        export = &archive->exports[archive->amount_of_exports];
+        if (!append_name(&archive->names, line, tab - line, &export->offset_of_name)) {
+            return 0;
+        }
+        export->index_of_member = (unsigned long)index_of_member;
+        /* The contents stay null terminated, so the address ends at the new line at the latest */
+        export->address = strtoul(tab + 1, NULL, 10);
+        archive->amount_of_exports++;
+    }
+    return 1;
+}
+
+/*
+ * Adds the output files of a module to an archive.
+ *
+ * The .ob file of the module must exist, its .ent, .ext and .rel files are added if they exist,
+ * and every entry of the .ent file is added to the exports.
+ *
+ * @param archive A pointer to the archive.
+ * @param name_of_module The base name of the module, its files are looked for where the assembler writes them.
+ * @return 1 if the module was added, 0 if its .ob file couldn't be read or on memory allocation error.
+ */
+int add_archive_member(struct object_archive *archive, const char *name_of_module) {
+    struct archive_member *bigger_members;
+    struct archive_member *member;
+    size_t new_capacity;
+    char *name_of_file;
+    int appended;
+    int i;
+
+    if (archive->amount_of_members == archive->capacity_of_members) {
+        new_capacity = archive->capacity_of_members ? archive->capacity_of_members * 2 : 16;
+        bigger_members = (struct archive_member *)tracked_realloc(archive->members, new_capacity * sizeof(struct archive_member), MEMORY_OUTPUTS);
+        if (bigger_members == NULL) {
+            fprintf(stderr, "wasn't able to allocate memory for the members of the archive\n");
+            return 0;
+        }
+        archive->members = bigger_members;
+        archive->capacity_of_members = new_capacity;
+    }
+    member = &archive->members[archive->amount_of_members];
+    memset(member, 0, sizeof(struct archive_member));
+    for (i = 0; i < AMOUNT_OF_MEMBER_FILES; i++) {
+        name_of_file = create_output_file_name(name_of_module, extensions_of_member_files[i]);
+        if (name_of_file == NULL) {
+            fprintf(stderr, "wasn't able to allocate memory for the name of the %s file\n", extensions_of_member_files[i]);
+            return 0;
+        }
+        member->offsets_of_files[i] = (unsigned long)archive->contents.length;
+        appended = append_file(&archive->contents, name_of_file);
+        if (appended == 0 && i == 0) {
+            fprintf(stderr, "Unable to open file: %s\n", name_of_file);
+        }
+        tracked_free(name_of_file);
+        if (appended < 0 || (appended == 0 && i == 0)) {
+            /* The files of the member that were already added are dropped with it */
+            archive->contents.length = member->offsets_of_files[0];
+            return 0;
+        }
+        member->present_files |= (unsigned long)appended << i;
+        member->sizes_of_files[i] = (unsigned long)archive->contents.length - member->offsets_of_files[i];
+    }
+    if (!append_name(&archive->names, name_of_module, strlen(name_of_module), &member->offset_of_name) ||
+        !add_member_exports(archive, archive->amount_of_members)) {
+        return 0;
+    }
+    archive->amount_of_members++;
+    return 1;
+}
+
+/*
+ * Writes an archive to a file, with the index of its exports.
+ *
+ * A symbol that more than one module exports is reported, and the index finds the first module.
+ *
+ * @param name_of_file The name of the archive file.
+ * @param archive A pointer to the archive.
+ * @return 1 if the file was written, 0 if it couldn't be written.
+ */
+int write_object_archive(const char *name_of_file, const struct object_archive *archive) {
+    struct output_text file = {0};
+    const struct archive_member *member;
+    const struct archive_export *export;
+    unsigned long amount_of_buckets = 1;
+    unsigned long bucket;
+    unsigned long index_in_bucket;
+    unsigned char *buckets;
+    unsigned char *members;
+    unsigned char *exports;
+    const char *name_of_export;
+    size_t i;
+    int j;
+    int written;
+
+    while (amount_of_buckets < archive->amount_of_exports * 2) {
+        amount_of_buckets *= 2;
+    }
+    file.length = OBJECT_ARCHIVE_HEADER_SIZE + amount_of_buckets * 4 + archive->amount_of_members * OBJECT_ARCHIVE_MEMBER_SIZE +
+                  archive->amount_of_exports * OBJECT_ARCHIVE_EXPORT_SIZE + archive->names.length + archive->contents.length;
+    file.text = (char *)tracked_calloc(file.length + 1, 1, MEMORY_OUTPUTS);
+    if (file.text == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the archive\n");
+        return 0;
+    }
+    file.capacity = file.length + 1;
+    buckets = (unsigned char *)file.text + OBJECT_ARCHIVE_HEADER_SIZE;
+    members = buckets + amount_of_buckets * 4;
+    exports = members + archive->amount_of_members * OBJECT_ARCHIVE_MEMBER_SIZE;
+
+    memcpy(file.text, OBJECT_ARCHIVE_MAGIC, 4);
+    put_little_endian((unsigned char *)file.text + 4, OBJECT_ARCHIVE_VERSION, 2);
+    put_little_endian((unsigned char *)file.text + 8, amount_of_buckets, 4);
+    put_little_endian((unsigned char *)file.text + 12, archive->amount_of_members, 4);
+    put_little_endian((unsigned char *)file.text + 16, archive->amount_of_exports, 4);
+    put_little_endian((unsigned char *)file.text + 20, archive->names.length, 4);
+    put_little_endian((unsigned char *)file.text + 24, archive->contents.length, 4);
+
+    for (i = 0; i < archive->amount_of_members; i++, members += OBJECT_ARCHIVE_MEMBER_SIZE) {
+        member = &archive->members[i];
+        put_little_endian(members, member->offset_of_name, 4);
+        put_little_endian(members + 4, member->present_files, 4);
+        for (j = 0; j < AMOUNT_OF_MEMBER_FILES; j++) {
+            put_little_endian(members + 8 + j * 8, member->offsets_of_files[j], 4);
+            put_little_endian(members + 12 + j * 8, member->sizes_of_files[j], 4);
+        }
+    }
+    for (i = 0; i < archive->amount_of_exports; i++, exports += OBJECT_ARCHIVE_EXPORT_SIZE) {
+        export = &archive->exports[i];
+        put_little_endian(exports, export->offset_of_name, 4);
+        put_little_endian(exports + 4, export->index_of_member, 4);
+        put_little_endian(exports + 8, export->address, 4);
+        /* Add the name to the index, unless a module before it exports the same name */
+        name_of_export = archive->names.text + export->offset_of_name;
+        for (bucket = hash_of_symbol_name(name_of_export) & (amount_of_buckets - 1); (index_in_bucket = get_little_endian(buckets + bucket * 4)) != 0;
+             bucket = (bucket + 1) & (amount_of_buckets - 1)) {
+            if (strcmp(archive->names.text + archive->exports[index_in_bucket - 1].offset_of_name, name_of_export) == 0) {
+                break;
+            }
+        }
+        if (index_in_bucket != 0) {
+            fprintf(stderr, "the symbol '%s' is exported by both %s and %s, the archive finds it in %s\n", name_of_export,
+                    archive->names.text + archive->members[archive->exports[index_in_bucket - 1].index_of_member].offset_of_name,
+                    archive->names.text + archive->members[export->index_of_member].offset_of_name,
+                    archive->names.text + archive->members[archive->exports[index_in_bucket - 1].index_of_member].offset_of_name);
+            continue;
+        }
+        put_little_endian(buckets + bucket * 4, i + 1, 4);
+    }
+    if (archive->names.length > 0) {
+        memcpy(exports, archive->names.text, archive->names.length);
+    }
+    if (archive->contents.length > 0) {
+        memcpy(exports + archive->names.length, archive->contents.text, archive->contents.length);
+    }
+    written = write_output_if_changed(name_of_file, &file);
+    free_output_text(&file);
+    return written;
+}
+
+/*
+ * Frees the memory of an archive and leaves it empty.
+ *
+ * @param archive A pointer to the archive.
+ */
+void free_object_archive(struct object_archive *archive) {
+    tracked_free(archive->members);
+    tracked_free(archive->exports);
+    free_output_text(&archive->names);
+    free_output_text(&archive->contents);
+    memset(archive, 0, sizeof(struct object_archive));
+}
+
+/*
+ * Maps an archive file in to memory and checks its header.
+ *
+ * The records are checked when they are used, so a lookup only reads the pages it needs.
+ *
+ * @param name_of_file The name of the archive file.
+ * @param archive A pointer to the structure that receives the mapping.
+ * @return 1 if the archive was mapped, 0 if it couldn't be read or is not a valid archive.
+ */
+static int map_object_archive(const char *name_of_file, struct mapped_archive *archive) {
+    struct stat status;
+    const unsigned char *header;
+    unsigned long expected_size;
+    int file_descriptor;
+    void *mapping;
+
+    memset(archive, 0, sizeof(struct mapped_archive));
+    file_descriptor = open(name_of_file, O_RDONLY);
+    if (file_descriptor < 0) {
+        fprintf(stderr, "Unable to open file: %s\n", name_of_file);
+        return 0;
+    }
+    if (fstat(file_descriptor, &status) != 0 || status.st_size < OBJECT_ARCHIVE_HEADER_SIZE) {
+        fprintf(stderr, "the file %s is not an object archive\n", name_of_file);
+        close(file_descriptor);
+        return 0;
+    }
+    mapping = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    close(file_descriptor);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "wasn't able to map the file: %s\n", name_of_file);
+        return 0;
+    }
+    archive->mapping = (unsigned char *)mapping;
+    archive->size_of_mapping = (size_t)status.st_size;
+
+    header = archive->mapping;
+    archive->amount_of_buckets = get_little_endian(header + 8);
+    archive->amount_of_members = get_little_endian(header + 12);
+    archive->amount_of_exports = get_little_endian(header + 16);
+    archive->size_of_names = get_little_endian(header + 20);
+    archive->size_of_contents = get_little_endian(header + 24);
+    /* The parts must fill the file exactly, every number is checked against the size before the sum */
+    expected_size = OBJECT_ARCHIVE_HEADER_SIZE + archive->amount_of_buckets * 4 + archive->amount_of_members * OBJECT_ARCHIVE_MEMBER_SIZE +
+                    archive->amount_of_exports * OBJECT_ARCHIVE_EXPORT_SIZE + archive->size_of_names + archive->size_of_contents;
+    if (memcmp(header, OBJECT_ARCHIVE_MAGIC, 4) != 0 || header[4] != OBJECT_ARCHIVE_VERSION || header[5] != 0 ||
+        archive->amount_of_buckets == 0 || (archive->amount_of_buckets & (archive->amount_of_buckets - 1)) != 0 ||
+        archive->amount_of_exports >= archive->amount_of_buckets || archive->amount_of_buckets > archive->size_of_mapping ||
+        archive->amount_of_members > archive->size_of_mapping || archive->size_of_names > archive->size_of_mapping ||
+        archive->size_of_contents > archive->size_of_mapping || expected_size != archive->size_of_mapping ||
+        (archive->size_of_names > 0 && archive->mapping[expected_size - archive->size_of_contents - 1] != '\0')) {
+        fprintf(stderr, "the file %s is not a valid object archive\n", name_of_file);
+        munmap(mapping, archive->size_of_mapping);
+        return 0;
+    }
+    archive->buckets = header + OBJECT_ARCHIVE_HEADER_SIZE;
+    archive->members = archive->buckets + archive->amount_of_buckets * 4;
+    archive->exports = archive->members + archive->amount_of_members * OBJECT_ARCHIVE_MEMBER_SIZE;
+    archive->names = (const char *)archive->exports + archive->amount_of_exports * OBJECT_ARCHIVE_EXPORT_SIZE;
+    archive->contents = archive->names + archive->size_of_names;
+    return 1;
+}
+
+/*
+ * Finds a name in the names of a mapped archive.
+ *
+ * @param archive A pointer to the mapped archive.
+ * @param offset_of_name The offset of the name, from a record.
+ * @return A pointer to the name, or NULL if the offset is outside the names.
+ */
+static const char *name_in_archive(const struct mapped_archive *archive, unsigned long offset_of_name) {
+    /* The names end with a null character, so every name that starts inside them ends inside them */
+    return offset_of_name < archive->size_of_names ? archive->names + offset_of_name : NULL;
+}
+
+/*
+ * Maps an archive file and prints the module and the address of every given symbol.
+ *
+ * Every symbol is printed on its own line as its name, the base name of the module and the address, separated by tabs.
+ *
+ * @param name_of_file The name of the archive file.
+ * @param names_of_symbols The names of the symbols, NULL names are skipped.
+ * @param amount_of_names The number of names.
+ * @return 1 if every symbol was found, 0 if one wasn't or the archive is not valid.
+ */
+int find_archive_exports(const char *name_of_file, char **names_of_symbols, int amount_of_names) {
+    struct mapped_archive archive;
+    const unsigned char *export;
+    const char *name_of_export;
+    const char *name_of_member;
+    unsigned long bucket;
+    unsigned long index_of_export;
+    unsigned long index_of_member;
+    int all_found = 1;
+    int i;
+
+    if (!map_object_archive(name_of_file, &archive)) {
+        return 0;
+    }
+    for (i = 0; i < amount_of_names; i++) {
+        if (names_of_symbols[i] == NULL) {
+            continue;
+        }
+        name_of_member = NULL;
+        /* There is always an empty bucket, so the probing ends */
+        for (bucket = hash_of_symbol_name(names_of_symbols[i]) & (archive.amount_of_buckets - 1);
+             (index_of_export = get_little_endian(archive.buckets + bucket * 4)) != 0;
+             bucket = (bucket + 1) & (archive.amount_of_buckets - 1)) {
+            export = archive.exports + (index_of_export - 1) * OBJECT_ARCHIVE_EXPORT_SIZE;
+            if (index_of_export > archive.amount_of_exports || (name_of_export = name_in_archive(&archive, get_little_endian(export))) == NULL ||
+                (index_of_member = get_little_endian(export + 4)) >= archive.amount_of_members ||
+                (name_of_member = name_in_archive(&archive, get_little_endian(archive.members + index_of_member * OBJECT_ARCHIVE_MEMBER_SIZE))) == NULL) {
+                fprintf(stderr, "the file %s is not a valid object archive\n", name_of_file);
+                munmap(archive.mapping, archive.size_of_mapping);
+                return 0;
+            }
+            if (strcmp(name_of_export, names_of_symbols[i]) == 0) {
+                printf("%s\t%s\t%lu\n", names_of_symbols[i], name_of_member, get_little_endian(export + 8));
+                break;
+            }
+            name_of_member = NULL;
+        }
+        if (name_of_member == NULL) {
+            fprintf(stderr, "the symbol '%s' is not exported by any module of %s\n", names_of_symbols[i], name_of_file);
+            all_found = 0;
+        }
+    }
+    munmap(archive.mapping, archive.size_of_mapping);
+    return all_found;
+}
+
+/*
+ * Writes the files of one member of a mapped archive where the assembler would write them.
+ *
+ * @param archive A pointer to the mapped archive.
+ * @param member The record of the member.
+ * @param name_of_member The base name of the member.
+ * @return 1 if the files were written, 0 if the record is not valid or a file couldn't be written.
+ */
+static int extract_member(const struct mapped_archive *archive, const unsigned char *member, const char *name_of_member) {
+    struct output_text text;
+    unsigned long present_files = get_little_endian(member + 4);
+    unsigned long offset_of_file;
+    unsigned long size_of_file;
+    char *name_of_file;
+    int written = 1;
+    int i;
+
+    for (i = 0; written && i < AMOUNT_OF_MEMBER_FILES; i++) {
+        offset_of_file = get_little_endian(member + 8 + i * 8);
+        size_of_file = get_little_endian(member + 12 + i * 8);
+        if (offset_of_file > archive->size_of_contents || size_of_file > archive->size_of_contents - offset_of_file) {
+            return 0;
+        }
+        name_of_file = create_output_file_name(name_of_member, extensions_of_member_files[i]);
+        if (name_of_file == NULL) {
+            fprintf(stderr, "wasn't able to allocate memory for the name of the %s file\n", extensions_of_member_files[i]);
+            return 0;
+        }
+        if (present_files & (1UL << i)) {
+            /* The file is written straight from the mapping */
+            text.text = (char *)archive->contents + offset_of_file;
+            text.length = size_of_file;
+            text.capacity = size_of_file;
+            written = write_output_if_changed(name_of_file, &text);
+        } else {
+            /* A file that is left from an earlier version of the module would look like it belongs to this one */
+            remove(name_of_file);
+        }
+        tracked_free(name_of_file);
+    }
+    return written;
+}
+
+/*
+ * Maps an archive file and writes the files of its members where the assembler would write them.
+ *
+ * A file that the member doesn't have is removed, like when the module is assembled.
+ *
+ * @param name_of_file The name of the archive file.
+ * @param names_of_members The base names of the members to extract, NULL names are skipped.
+ * @param amount_of_names The number of names, 0 to extract every member.
+ * @return 1 if every member was extracted, 0 if one wasn't found or written or the archive is not valid.
+ */
+int extract_archive_members(const char *name_of_file, char **names_of_members, int amount_of_names) {
+    struct mapped_archive archive;
+    const unsigned char *member;
+    const char *name_of_member;
+    char *extracted;
+    unsigned long i;
+    int amount_of_given_names = 0;
+    int all_extracted = 1;
+    int j;
+
+    if (!map_object_archive(name_of_file, &archive)) {
+        return 0;
+    }
+    for (j = 0; j < amount_of_names; j++) {
+        amount_of_given_names += names_of_members[j] != NULL;
+    }
+    /* Marks the names that were found, so the missing ones can be reported */
+    extracted = (char *)tracked_calloc(amount_of_names + 1, 1, MEMORY_OUTPUTS);
+    if (extracted == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the members of the archive\n");
+        munmap(archive.mapping, archive.size_of_mapping);
+        return 0;
+    }
+    for (i = 0, member = archive.members; i < archive.amount_of_members; i++, member += OBJECT_ARCHIVE_MEMBER_SIZE) {
+        name_of_member = name_in_archive(&archive, get_little_endian(member));
+        if (name_of_member == NULL) {
+            fprintf(stderr, "the file %s is not a valid object archive\n", name_of_file);
+            all_extracted = 0;
+            break;
+        }
+        for (j = 0; j < amount_of_names && (names_of_members[j] == NULL || strcmp(names_of_members[j], name_of_member) != 0); j++) {
+        }
+        if (amount_of_given_names > 0 && j == amount_of_names) {
+            continue;
+        }
+        if (!extract_member(&archive, member, name_of_member)) {
+            fprintf(stderr, "wasn't able to extract the member %s of %s\n", name_of_member, name_of_file);
+            all_extracted = 0;
+        }
+        for (; j < amount_of_names; j++) {
+            if (names_of_members[j] != NULL && strcmp(names_of_members[j], name_of_member) == 0) {
+                extracted[j] = 1;
+            }
+        }
+    }
+    for (j = 0; i == archive.amount_of_members && j < amount_of_names; j++) {
+        if (names_of_members[j] != NULL && !extracted[j]) {
+            fprintf(stderr, "the archive %s has no member %s\n", name_of_file, names_of_members[j]);
+            all_extracted = 0;
+        }
+    }
+    tracked_free(extracted);
+    munmap(archive.mapping, archive.size_of_mapping);
+    return all_extracted;
+}
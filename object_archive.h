@@ -0,0 +1,113 @@
+#ifndef __OBJECT_ARCHIVE_H_
+#define __OBJECT_ARCHIVE_H_
+
+#include "common.h"
+#include "output_unit.h"
+
+#define ARCHIVE_FIND 1
+#define ARCHIVE_EXTRACT 2
+
+/*
+ * The archive file is little endian and made of six parts:
+ * a header of OBJECT_ARCHIVE_HEADER_SIZE bytes - the magic "OARC", the version (2 bytes), 2 reserved bytes,
+ *     the number of buckets, members and exports, the size of the names and the size of the contents (4 bytes each),
+ * the buckets of the export index, 4 bytes each - the index of an export plus one, 0 for an empty bucket.
+ *     A symbol is looked for from the bucket of its FNV-1a hash, modulo the number of buckets, which is a power of 2,
+ *     and in the buckets after it until an empty bucket,
+ * the members, OBJECT_ARCHIVE_MEMBER_SIZE bytes each - the offset of the base name of the module in the names,
+ *     a mask of the files the member has (bit i for file i), and the offset in the contents and the size of every file,
+ *     in the order .ob, .ent, .ext, .rel (4 bytes each),
+ * the exports, OBJECT_ARCHIVE_EXPORT_SIZE bytes each - the offset of the name of the symbol in the names,
+ *     the index of the member that exports it and its address (4 bytes each),
+ * the names, every name null terminated,
+ * and the contents of the files of the members, one after the other.
+ */
+#define OBJECT_ARCHIVE_MAGIC "OARC"
+#define OBJECT_ARCHIVE_VERSION 1
+#define OBJECT_ARCHIVE_HEADER_SIZE 28
+#define OBJECT_ARCHIVE_MEMBER_SIZE 40
+#define OBJECT_ARCHIVE_EXPORT_SIZE 12
+#define AMOUNT_OF_MEMBER_FILES 4
+
+/* Represents a module of an archive while the archive is built */
+struct archive_member {
+    unsigned long offset_of_name; /* The offset of the base name of the module in the names */
+    unsigned long present_files; /* Bit i is set if the module has file i */
+    unsigned long offsets_of_files[AMOUNT_OF_MEMBER_FILES]; /* The offset of every file in the contents */
+    unsigned long sizes_of_files[AMOUNT_OF_MEMBER_FILES]; /* The size of every file */
+};
+
+/* Represents a symbol that a member of an archive exports, from its .ent file */
+struct archive_export {
+    unsigned long offset_of_name; /* The offset of the name of the symbol in the names */
+    unsigned long index_of_member; /* The member that exports the symbol */
+    unsigned long address; /* The address of the symbol */
+};
+
+/* Represents an archive while the outputs of the modules are added to it */
+struct object_archive {
+    struct archive_member *members; /* The modules, in the order they were added */
+    size_t amount_of_members; /* The number of modules */
+    size_t capacity_of_members; /* The number of modules there is room for */
+    struct archive_export *exports; /* The symbols the modules export, in the order they were added */
+    size_t amount_of_exports; /* The number of exports */
+    size_t capacity_of_exports; /* The number of exports there is room for */
+    struct output_text names; /* The names of the modules and the symbols, every one null terminated */
+    struct output_text contents; /* The files of the modules, one after the other */
+};
+
+/*
+ * Adds the output files of a module to an archive.
+ *
+ * The .ob file of the module must exist, its .ent, .ext and .rel files are added if they exist,
+ * and every entry of the .ent file is added to the exports.
+ *
+ * @param archive A pointer to the archive.
+ * @param name_of_module The base name of the module, its files are looked for where the assembler writes them.
+ * @return 1 if the module was added, 0 if its .ob file couldn't be read or on memory allocation error.
+ */
+int add_archive_member(struct object_archive *archive, const char *name_of_module);
+
+/*
+ * Writes an archive to a file, with the index of its exports.
+ *
+ * A symbol that more than one module exports is reported, and the index finds the first module.
+ *
+ * @param name_of_file The name of the archive file.
+ * @param archive A pointer to the archive.
+ * @return 1 if the file was written, 0 if it couldn't be written.
+ */
+int write_object_archive(const char *name_of_file, const struct object_archive *archive);
+
+/*
+ * Frees the memory of an archive and leaves it empty.
+ *
+ * @param archive A pointer to the archive.
+ */
+void free_object_archive(struct object_archive *archive);
+
+/*
+ * Maps an archive file and prints the module and the address of every given symbol.
+ *
+ * Every symbol is printed on its own line as its name, the base name of the module and the address, separated by tabs.
+ *
+ * @param name_of_file The name of the archive file.
+ * @param names_of_symbols The names of the symbols, NULL names are skipped.
+ * @param amount_of_names The number of names.
+ * @return 1 if every symbol was found, 0 if one wasn't or the archive is not valid.
+ */
+int find_archive_exports(const char *name_of_file, char **names_of_symbols, int amount_of_names);
+
+/*
+ * Maps an archive file and writes the files of its members where the assembler would write them.
+ *
+ * A file that the member doesn't have is removed, like when the module is assembled.
+ *
+ * @param name_of_file The name of the archive file.
+ * @param names_of_members The base names of the members to extract, NULL names are skipped.
+ * @param amount_of_names The number of names, 0 to extract every member.
+ * @return 1 if every member was extracted, 0 if one wasn't found or written or the archive is not valid.
+ */
+int extract_archive_members(const char *name_of_file, char **names_of_members, int amount_of_names);
+
+#endif
@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "optimizer.h"
+
+#define INSTRUCTION_OF(line) ((line)->ast.directive_or_instruction.mmn14_ast_instruction)
+
+/* Represents a line of the am file while it is optimized */
+struct optimizer_line {
+    char text[MAX_LENGTH_OF_LINE + 1]; /* The text of the line, the AST points in to it */
+    mmn14_ast ast; /* The AST of the line */
+};
+
+/*
+ * Checks if a line of the am file is an instruction.
+ *
+ * @param line A pointer to the line.
+ * @return 1 if the line is an instruction without syntax errors, 0 otherwise.
+ */
+static int is_instruction(const struct optimizer_line *line) {
+    return line->ast.mmn14_ast_options == mmn14_ast_instruction && line->ast.syntax_error[0] == '\0' && line->text[0] != '\0';
+}
+
+/*
+ * Checks if a line of the am file is an instruction with a label.
+ *
+ * @param line A pointer to the line.
+ * @return 1 if the line is an instruction with a label, 0 otherwise.
+ */
+static int is_labeled_instruction(const struct optimizer_line *line) {
+    return is_instruction(line) && line->ast.name_of_label[0] != '\0';
+}
+
+/*
+ * Checks if an instruction is a jmp, bne or jsr through a register.
+ *
+ * @param line A pointer to the line of the instruction.
+ * @return 1 if the target of the jump is in a register, 0 otherwise.
+ */
+static int is_jump_through_register(const struct optimizer_line *line) {
+    switch (INSTRUCTION_OF(line).mmn14_ast_instruction_opt) {
+        case mmn14_ast_instruction_jmp: case mmn14_ast_instruction_bne: case mmn14_ast_instruction_jsr:
+            return INSTRUCTION_OF(line).mmn14_ast_instruction_operand_opt[0] == mmn14_ast_operand_opt_operand_register;
+        default:
+            return 0;
+    }
+}
+
+/*
+ * Finds the next instruction that was not removed.
+ *
+ * @param lines The lines of the am file.
+ * @param result A pointer to the result of the optimizer.
+ * @param index The index of the line to start after.
+ * @return The index of the next instruction that was not removed, or the number of lines if there is none.
+ */
+static size_t next_instruction(const struct optimizer_line *lines, const struct peephole_result *result, size_t index) {
+    for (index++; index < result->amount_of_lines; index++) {
+        if (is_instruction(&lines[index]) && !result->removed_lines[index]) {
+            break;
+        }
+    }
+    return index;
+}
+
+/*
+ * Checks if there is a labeled instruction after a line and up to another one, so the other line can be reached by a jump.
+ *
+ * Removed instructions count as well, since their labels move to the next instruction.
+ *
+ * @param lines The lines of the am file.
+ * @param first The index of the first line, it is not checked.
+ * @param last The index of the last line, it is checked.
+ * @return 1 if one of the instructions has a label, 0 otherwise.
+ */
+static int has_label_between(const struct optimizer_line *lines, size_t first, size_t last) {
+    for (first++; first <= last; first++) {
+        if (is_labeled_instruction(&lines[first])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Checks if two operands of instructions are the same register or the same label.
+ *
+ * @param first A pointer to the line of the first instruction.
+ * @param first_index The index of the operand in the first instruction.
+ * @param second A pointer to the line of the second instruction.
+ * @param second_index The index of the operand in the second instruction.
+ * @return 1 if the operands are the same, 0 otherwise.
+ */
+static int same_operand(const struct optimizer_line *first, int first_index, const struct optimizer_line *second, int second_index) {
+    if (INSTRUCTION_OF(first).mmn14_ast_instruction_operand_opt[first_index] != INSTRUCTION_OF(second).mmn14_ast_instruction_operand_opt[second_index]) {
+        return 0;
+    }
+    switch (INSTRUCTION_OF(first).mmn14_ast_instruction_operand_opt[first_index]) {
+        case mmn14_ast_operand_opt_operand_register:
+            return INSTRUCTION_OF(first).mmn14_ast_instruction_operands[first_index].register_number ==
+                   INSTRUCTION_OF(second).mmn14_ast_instruction_operands[second_index].register_number;
+        case mmn14_ast_operand_opt_operand_label:
+            return INSTRUCTION_OF(first).ids_of_operand_labels[first_index] == INSTRUCTION_OF(second).ids_of_operand_labels[second_index];
+        default:
+            return 0;
+    }
+}
+
+/*
+ * Removes the instruction of a line.
+ *
+ * @param lines The lines of the am file.
+ * @param result A pointer to the result of the optimizer.
+ * @param index The index of the line.
+ */
+static void remove_instruction(const struct optimizer_line *lines, struct peephole_result *result, size_t index) {
+    result->removed_lines[index] = 1;
+    result->removed_instructions++;
+    result->removed_words += words_of_line(&lines[index].ast);
+}
+
+/*
+ * Applies the peephole rules to one instruction.
+ *
+ * @param lines The lines of the am file.
+ * @param result A pointer to the result of the optimizer.
+ * @param index The index of the line of the instruction, it was not removed.
+ * @return 1 if an instruction was removed, 0 otherwise.
+ */
+static int apply_peephole_rules(const struct optimizer_line *lines, struct peephole_result *result, size_t index) {
+    const struct optimizer_line *line = &lines[index];
+    const struct optimizer_line *next_line;
+    size_t next = next_instruction(lines, result, index);
+    size_t i;
+    int opcode = INSTRUCTION_OF(line).mmn14_ast_instruction_opt;
+    int next_opcode;
+    int changed = 0;
+
+    /* Instructions after stop, rts or jmp can only be reached through a label, unless a jump goes through a register */
+    if (!result->jumps_through_register && (opcode == mmn14_ast_instruction_stop || opcode == mmn14_ast_instruction_rts || opcode == mmn14_ast_instruction_jmp)) {
+        for (i = index + 1; i < result->amount_of_lines && !is_labeled_instruction(&lines[i]); i++) {
+            if (is_instruction(&lines[i]) && !result->removed_lines[i]) {
+                remove_instruction(lines, result, i);
+                changed = 1;
+            }
+        }
+        next = next_instruction(lines, result, index);
+    }
+
+    /* A jmp to the instruction right after it */
+    if (opcode == mmn14_ast_instruction_jmp && INSTRUCTION_OF(line).mmn14_ast_instruction_operand_opt[0] == mmn14_ast_operand_opt_operand_label) {
+        for (i = index + 1; i < result->amount_of_lines && i <= next; i++) {
+            if (is_labeled_instruction(&lines[i]) && lines[i].ast.id_of_label == INSTRUCTION_OF(line).ids_of_operand_labels[0]) {
+                remove_instruction(lines, result, index);
+                return 1;
+            }
+        }
+    }
+
+    if (next >= result->amount_of_lines) {
+        return changed;
+    }
+    next_line = &lines[next];
+    next_opcode = INSTRUCTION_OF(next_line).mmn14_ast_instruction_opt;
+
+    /* An inc and a dec of the same operand cancel each other, if the second one can't be reached by a jump */
+    if (!result->jumps_through_register &&
+        ((opcode == mmn14_ast_instruction_inc && next_opcode == mmn14_ast_instruction_dec) ||
+         (opcode == mmn14_ast_instruction_dec && next_opcode == mmn14_ast_instruction_inc)) &&
+        same_operand(line, 0, next_line, 0) && !has_label_between(lines, index, next)) {
+        remove_instruction(lines, result, index);
+        remove_instruction(lines, result, next);
+        return 1;
+    }
+
+    /* A mov to a register that the next mov overwrites without reading it */
+    if (opcode == mmn14_ast_instruction_mov && next_opcode == mmn14_ast_instruction_mov &&
+        INSTRUCTION_OF(line).mmn14_ast_instruction_operand_opt[1] == mmn14_ast_operand_opt_operand_register &&
+        same_operand(line, 1, next_line, 1) && !same_operand(line, 1, next_line, 0)) {
+        remove_instruction(lines, result, index);
+        return 1;
+    }
+    return changed;
+}
+
+/*
+ * Runs the peephole optimizer over the instructions of an am file.
+ *
+ * The whole file is read and lexed, and these rules are applied until none of them changes anything:
+ * a mov to a register that the next instruction overwrites with another mov is removed,
+ * an inc that is followed by a dec of the same operand (or the other way around) is removed with it,
+ * a jmp to the instruction right after it is removed,
+ * and instructions after stop, rts or jmp are removed until the next labeled instruction.
+ * When a jmp, bne or jsr goes through a register, any instruction may be its target, so the
+ * instructions after stop, rts or jmp and the inc and dec pairs are kept.
+ * The lines are only marked, so the labels of removed instructions still get the address of the
+ * next instruction that is encoded. The file is rewound when the function returns.
+ *
+ * @param am_file The am file, opened for reading.
+ * @param interner The interner of the names of the symbols of the file, labels are compared by their ids.
+ * @param result A pointer to the structure that receives the removed lines.
+ * @return 1 if the optimizer ran successfully, 0 on memory allocation error.
+ */
+int optimize_am_file(FILE *am_file, struct symbol_interner *interner, struct peephole_result *result) {
+    struct optimizer_line *lines = NULL;
+    struct optimizer_line *bigger_lines;
+    size_t capacity = 0;
+    size_t i;
+    int changed = 1;
+
+    memset(result, 0, sizeof(struct peephole_result));
+    /* Read the lines the same way the compilation reads them */
+    for (;;) {
+        if (result->amount_of_lines == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            bigger_lines = (struct optimizer_line *)tracked_realloc(lines, capacity * sizeof(struct optimizer_line), MEMORY_OPTIMIZER);
+            if (bigger_lines == NULL) {
+                fprintf(stderr, "wasn't able to allocate memory for the optimizer\n");
+                tracked_free(lines);
+                rewind(am_file);
+                return 0;
+            }
+            lines = bigger_lines;
+        }
+        if (!fgets(lines[result->amount_of_lines].text, sizeof(lines[result->amount_of_lines].text), am_file)) {
+            break;
+        }
+        result->amount_of_lines++;
+    }
+    rewind(am_file);
+
+    result->removed_lines = (unsigned char *)tracked_calloc(result->amount_of_lines + 1, 1, MEMORY_OPTIMIZER);
+    if (result->removed_lines == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the optimizer\n");
+        tracked_free(lines);
+        return 0;
+    }
+    /* The lines don't move anymore, so the ASTs can point in to them */
+    for (i = 0; i < result->amount_of_lines; i++) {
+        lines[i].ast = get_ast_lexer(lines[i].text, interner);
+        /* A register may hold the address of any instruction */
+        if (is_instruction(&lines[i]) && is_jump_through_register(&lines[i])) {
+            result->jumps_through_register = 1;
+        }
+    }
+
+    while (changed) {
+        changed = 0;
+        for (i = 0; i < result->amount_of_lines; i++) {
+            if (is_instruction(&lines[i]) && !result->removed_lines[i] && apply_peephole_rules(lines, result, i)) {
+                changed = 1;
+            }
+        }
+    }
+    tracked_free(lines);
+    return 1;
+}
+
+/*
+ * Checks if the peephole optimizer removed the instruction of a line of the am file.
+ *
+ * @param result A pointer to the result of the optimizer, or NULL if it didn't run.
+ * @param index_of_read The index of the line in the order the lines are read, starting at 0.
+ * @return 1 if the instruction of the line was removed, 0 otherwise.
+ */
+int line_was_optimized_out(const struct peephole_result *result, size_t index_of_read) {
+    return result != NULL && result->removed_lines != NULL && index_of_read < result->amount_of_lines && result->removed_lines[index_of_read];
+}
+
+/*
+ * Frees the memory of the result of the peephole optimizer and leaves it empty.
+ *
+ * @param result A pointer to the result of the optimizer.
+ */
+void free_peephole_result(struct peephole_result *result) {
+    tracked_free(result->removed_lines);
+    memset(result, 0, sizeof(struct peephole_result));
+}
@@ -0,0 +1,56 @@
+#ifndef __OPTIMIZER_H_
+#define __OPTIMIZER_H_
+
+#include <stdio.h>
+#include "common.h"
+#include "lexer.h"
+#include "encoding_table.h"
+
+#define MAX_LENGTH_OF_LINE 81
+
+/* Represents the instructions of an am file that the peephole optimizer removed */
+struct peephole_result {
+    unsigned char *removed_lines; /* For every line that is read from the am file, 1 if its instruction is removed */
+    size_t amount_of_lines; /* The number of lines that were read from the am file */
+    long removed_instructions; /* The number of instructions that were removed */
+    long removed_words; /* The number of code words the removed instructions would have taken */
+    int jumps_through_register; /* Set if a jmp, bne or jsr goes through a register, so any instruction may be reached */
+};
+
+/*
+ * Runs the peephole optimizer over the instructions of an am file.
+ *
+ * The whole file is read and lexed, and these rules are applied until none of them changes anything:
+ * a mov to a register that the next instruction overwrites with another mov is removed,
+ * an inc that is followed by a dec of the same operand (or the other way around) is removed with it,
+ * a jmp to the instruction right after it is removed,
+ * and instructions after stop, rts or jmp are removed until the next labeled instruction.
+ * When a jmp, bne or jsr goes through a register, any instruction may be its target, so the
+ * instructions after stop, rts or jmp and the inc and dec pairs are kept.
+ * The lines are only marked, so the labels of removed instructions still get the address of the
+ * next instruction that is encoded. The file is rewound when the function returns.
+ *
+ * @param am_file The am file, opened for reading.
+ * @param interner The interner of the names of the symbols of the file, labels are compared by their ids.
+ * @param result A pointer to the structure that receives the removed lines.
+ * @return 1 if the optimizer ran successfully, 0 on memory allocation error.
+ */
+int optimize_am_file(FILE *am_file, struct symbol_interner *interner, struct peephole_result *result);
+
+/*
+ * Checks if the peephole optimizer removed the instruction of a line of the am file.
+ *
+ * @param result A pointer to the result of the optimizer, or NULL if it didn't run.
+ * @param index_of_read The index of the line in the order the lines are read, starting at 0.
+ * @return 1 if the instruction of the line was removed, 0 otherwise.
+ */
+int line_was_optimized_out(const struct peephole_result *result, size_t index_of_read);
+
+/*
+ * Frees the memory of the result of the peephole optimizer and leaves it empty.
+ *
+ * @param result A pointer to the result of the optimizer.
+ */
+void free_peephole_result(struct peephole_result *result);
+
+#endif
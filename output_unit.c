@@ -1,188 +1,327 @@
 #include <stdio.h> 
 #include <stdlib.h> 
+#include <stdarg.h>
 #include <string.h>
 #include <libgen.h>
 #include "output_unit.h"
 #include "linked_list.h"
+#include "interner.h"
+#include "input_files.h"
 
 /*
- * Outputs a section of memory in Base64 format to a given file.
+ * Appends formatted text to the text of an output file.
+ *
+ * @param text A pointer to the text of the output file.
+ * @param format The format of the text, as in printf, it must fit in MAX_LENGTH_OF_OUTPUT_LINE characters.
+ * @return 1 if the text was appended, 0 on memory allocation error.
+ */
+int append_output_text(struct output_text *text, const char *format, ...) {
+    char line[MAX_LENGTH_OF_OUTPUT_LINE + 1];
+    char *bigger_text;
+    size_t new_capacity;
+    int length;
+    va_list arguments;
+
+    va_start(arguments, format);
+    length = vsprintf(line, format, arguments);
+    va_end(arguments);
+    if (length < 0) {
+        return 0;
+    }
+    if (text->length + length + 1 > text->capacity) {
+        new_capacity = text->capacity ? text->capacity * 2 : 256;
+        while (new_capacity < text->length + length + 1) {
+            new_capacity *= 2;
+        }
+        bigger_text = (char *)tracked_realloc(text->text, new_capacity, MEMORY_OUTPUTS);
+        if (bigger_text == NULL) {
+            fprintf(stderr, "wasn't able to allocate memory for the text of an output file\n");
+            return 0;
+        }
+        text->text = bigger_text;
+        text->capacity = new_capacity;
+    }
+    memcpy(text->text + text->length, line, length + 1);
+    text->length += length;
+    return 1;
+}
+
+/*
+ * Frees the memory of the text of an output file and leaves it empty.
+ *
+ * @param text A pointer to the text of the output file.
+ */
+void free_output_text(struct output_text *text) {
+    tracked_free(text->text);
+    memset(text, 0, sizeof(struct output_text));
+}
+
+/*
+ * Checks if a file already holds exactly the given bytes.
+ *
+ * The sizes are compared first, so a file of another size is not read at all.
+ *
+ * @param name_of_file The name of the file.
+ * @param text A pointer to the text to compare with.
+ * @return 1 if the file exists and holds the text, 0 otherwise.
+ */
+static int file_has_text(const char *name_of_file, const struct output_text *text) {
+    char chunk[4096];
+    FILE *existing_file;
+    size_t position = 0;
+    size_t amount_read;
+    int same = 0;
+
+    existing_file = fopen(name_of_file, "rb");
+    if (existing_file == NULL) {
+        return 0;
+    }
+    if (fseek(existing_file, 0, SEEK_END) == 0 && ftell(existing_file) == (long)text->length && fseek(existing_file, 0, SEEK_SET) == 0) {
+        same = 1;
+        while (same && (amount_read = fread(chunk, 1, sizeof(chunk), existing_file)) > 0) {
+            same = position + amount_read <= text->length && memcmp(chunk, text->text + position, amount_read) == 0;
+            position += amount_read;
+        }
+        same = same && position == text->length;
+    }
+    fclose(existing_file);
+    return same;
+}
+
+/*
+ * Writes the text of an output file, unless the file already holds the same bytes.
+ *
+ * An unchanged file is not touched, so its modification time stays the same. A changed file is
+ * written to a temporary file next to it that is then renamed over it, so a reader sees either
+ * the old file or the new one.
+ *
+ * @param name_of_file The name of the output file.
+ * @param text A pointer to the text of the output file.
+ * @return 1 if the file holds the text, 0 if it couldn't be written.
+ */
+int write_output_if_changed(const char *name_of_file, const struct output_text *text) {
+    FILE *temporary_file;
+    char *temporary_name_of_file;
+    int written;
+
+    if (file_has_text(name_of_file, text)) {
+        return 1;
+    }
+    temporary_name_of_file = create_file_name(name_of_file, FILE_EXTENSION_TEMPORARY);
+    if (temporary_name_of_file == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the name of a temporary file\n");
+        return 0;
+    }
+    temporary_file = fopen(temporary_name_of_file, "wb");
+    if (temporary_file == NULL) {
+        fprintf(stderr, "wasn't able to open file: %s\n", temporary_name_of_file);
+        tracked_free(temporary_name_of_file);
+        return 0;
+    }
+    written = fwrite(text->text, 1, text->length, temporary_file) == text->length;
+    written = fclose(temporary_file) == 0 && written;
+    if (!written || rename(temporary_name_of_file, name_of_file) != 0) {
+        fprintf(stderr, "wasn't able to write file: %s\n", name_of_file);
+        remove(temporary_name_of_file);
+        written = 0;
+    }
+    tracked_free(temporary_name_of_file);
+    return written;
+}
+
+/*
+ * Outputs a section of memory in Base64 format to the text of the .ob file.
  *
  * This function takes a section of memory represented as an array of unsigned integers,
- * converts the data into Base64 format, and writes it to the specified output file.
+ * converts the data into Base64 format, and appends it to the text of the .ob file.
  *
- * @param obj_file A pointer to the FILE object where the Base64-encoded data will be written.
+ * @param ob_text A pointer to the text of the .ob file.
  * @param section_of_memory A pointer to the start of the memory section to be encoded.
  * @param size The size of the memory section in number of unsigned integers.
+ * @return 1 if the section was appended, 0 on memory allocation error.
  */
-static void output_section_memory(FILE *obj_file, const unsigned int *section_of_memory, long size) {
-    size_t i;
+static int output_section_memory(struct output_text *ob_text, const unsigned int *section_of_memory, long size) {
+    long i;
     const char *const chars_b64 = BASE64;
 
     for (i = 0; i < size; i++) {
         unsigned int most_significant_6_bits = (section_of_memory[i] >> 6) & 0x3F;
         unsigned int least_significant_6_bits = section_of_memory[i] & 0x3F;
 
-        if (most_significant_6_bits >= 0 && most_significant_6_bits < 64 &&
-            least_significant_6_bits >= 0 && least_significant_6_bits < 64) {
-            /* Write the Base64-encoded characters to the output file */
-            fprintf(obj_file, "%c%c", chars_b64[most_significant_6_bits], chars_b64[least_significant_6_bits]);
-            fprintf(obj_file, "\n");
-        } else {
-            fprintf(stderr, "Invalid index for chars_b64 array: %u %u\n", most_significant_6_bits, least_significant_6_bits);
-            
+        /* Append the Base64-encoded characters to the text of the .ob file */
+        if (!append_output_text(ob_text, "%c%c\n", chars_b64[most_significant_6_bits], chars_b64[least_significant_6_bits])) {
+            return 0;
         }
     }
+    return 1;
 }
 
 /*
- * Outputs symbol entries to an .ent file.
+ * Outputs symbol entries to the text of an .ent file.
  *
- * This function takes the name of the .ent file and a linked list of symbols.
- * It iterates through the symbol linked list and writes
- * symbols marked as entry code or entry data to the specified .ent file.
+ * This function iterates through the symbol linked list and appends
+ * symbols marked as entry code or entry data to the text of the .ent file.
  *
- * @param ent_name_of_file The name of the .ent file to be created.
+ * @param ent_text A pointer to the text of the .ent file.
  * @param table_of_symbols A pointer to the linked list containing the symbols.
+ * @param interner A pointer to the names of the symbols.
+ * @return 1 if the entries were appended, 0 on memory allocation error.
  */
-static void output_ent_file(const char * ent_name_of_file, SymbolLinkedList *table_of_symbols) {
-   FILE * ent_file;
-   SymbolNode *current_node;
-   struct symbol *current_symbol;
-
-   /* Open the .ent file for writing */
-   ent_file = fopen(ent_name_of_file, "w");
-   if (ent_file) {
-      
-      
-      current_node = table_of_symbols->head; 
-        while(current_node != NULL) {  
-            current_symbol = (struct symbol *)current_node->symbol_data; 
-            if(current_symbol) {
-                /* Check if the symbol is of type symbol_entry_code or symbol_entry_data */
-                if(current_symbol->type_of_symbol == symbol_entry_code || current_symbol->type_of_symbol == symbol_entry_data){
-                    /* Write the symbol name and address to the .ent file */
-                    fprintf(ent_file, "%s\t%u\n", current_symbol->name_of_symbol, current_symbol->address_of_symbol);
+static int output_ent_file(struct output_text *ent_text, SymbolLinkedList *table_of_symbols, const struct symbol_interner *interner) {
+    SymbolNode *current_node;
+    struct symbol *current_symbol;
+
+    current_node = table_of_symbols->head;
+    while (current_node != NULL) {
+        current_symbol = (struct symbol *)current_node->symbol_data;
+        if (current_symbol) {
+            /* Check if the symbol is of type symbol_entry_code or symbol_entry_data */
+            if (current_symbol->type_of_symbol == symbol_entry_code || current_symbol->type_of_symbol == symbol_entry_data) {
+                /* Append the symbol name and address to the text of the .ent file */
+                if (!append_output_text(ent_text, "%s\t%u\n", name_of_symbol_id(interner, current_symbol->id_of_symbol), current_symbol->address_of_symbol)) {
+                    return 0;
                 }
             }
-            current_node = current_node->next;  
         }
-        fclose(ent_file);
-   }
+        current_node = current_node->next;
+    }
+    return 1;
 }
 
 /*
- * Outputs certain externs to an .ext file.
+ * Outputs the uses of external symbols to the text of an .ext file.
  *
- * This function takes the name of the .ext file and a linked list of certain externs.
- * It iterates through the certain extern linked list and writes the names and addresses
- * of certain externs to the specified .ext file.
+ * This function takes the table of extern uses, which is grouped by symbol.
+ * It appends every use as the name of the symbol and its address on its own line, or, with --ext-grouped,
+ * the name of every symbol followed by all the addresses it is used in on one line.
  *
- * @param ext_name_of_file The name of the .ext file to be created.
- * @param name_and_addresses_certain_extern A pointer to the linked list containing certain externs.
+ * @param ext_text A pointer to the text of the .ext file.
+ * @param extern_uses A pointer to the table of extern uses.
+ * @param interner A pointer to the names of the symbols.
+ * @return 1 if the uses were appended, 0 on memory allocation error.
  */
-static void output_ext_file(const char *ext_name_of_file, CertainExternLinkedList *name_and_addresses_certain_extern) {
-    FILE *ext_file;
-    struct certain_extern *current_extern;
-    CertainExternNode *current_node_ext;
-    
-   
-    if (name_and_addresses_certain_extern->head->next == NULL)
-    {
-        return;
-    }
-    /* Open the .ext file for writing */
-    ext_file = fopen(ext_name_of_file, "w");
-    if (ext_file) {
-        current_node_ext = name_and_addresses_certain_extern->head;
-
-        while (current_node_ext != NULL) {
-            current_extern = (struct certain_extern *)current_node_ext->data;
-            if (current_extern) {
-                /* Write the certain extern name and address to the .ext file */
-                fprintf(ext_file, "%s\t%ld\n", current_extern->name_of_extern, current_extern->address_of_extern);
-            }
-            current_node_ext = current_node_ext->next; 
+static int output_ext_file(struct output_text *ext_text, const struct extern_use_table *extern_uses, const struct symbol_interner *interner) {
+    const struct extern_use *current_use;
+    size_t i;
+    int appended = 1;
+
+    for (i = 0; appended && i < extern_uses->amount_of_uses; i++) {
+        current_use = &extern_uses->uses[i];
+        if (!options_of_assembler.group_extern_output) {
+            /* Append the name of the extern and the address of the use to the text of the .ext file */
+            appended = append_output_text(ext_text, "%s\t%u\n", name_of_symbol_id(interner, current_use->id_of_symbol), current_use->address);
+            continue;
+        }
+        /* The name of the extern starts its group of addresses */
+        if (i == 0 || extern_uses->uses[i - 1].id_of_symbol != current_use->id_of_symbol) {
+            appended = append_output_text(ext_text, "%s", name_of_symbol_id(interner, current_use->id_of_symbol));
+        }
+        appended = appended && append_output_text(ext_text, "\t%u", current_use->address);
+        if (i + 1 == extern_uses->amount_of_uses || extern_uses->uses[i + 1].id_of_symbol != current_use->id_of_symbol) {
+            appended = appended && append_output_text(ext_text, "\n");
         }
+    }
+    return appended;
+}
+
+/*
+ * Outputs the offsets of the relocatable words of the code image to the text of a .rel file.
+ *
+ * Every offset is on its own line, in ascending order. A loader that places the code image at BASE
+ * instead of at address 100 adds (BASE - 100) << 2 to every word that is listed.
+ *
+ * @param rel_text A pointer to the text of the .rel file.
+ * @param relocations A pointer to the table of relocations, sorted.
+ * @return 1 if the offsets were appended, 0 on memory allocation error.
+ */
+static int output_rel_file(struct output_text *rel_text, const struct relocation_table *relocations) {
+    size_t i;
+    int appended = 1;
 
-        fclose(ext_file);
+    for (i = 0; appended && i < relocations->amount_of_offsets; i++) {
+        appended = append_output_text(rel_text, "%u\n", relocations->offsets[i]);
     }
+    return appended;
 }
 
+/*
+ * Writes one of the output files of a module, or removes it when the module doesn't have it anymore.
+ *
+ * @param name_of_were_to_output The base name of the output files.
+ * @param extension The extension of the output file.
+ * @param text A pointer to the text of the output file, or NULL if the module doesn't have the file.
+ */
+static void output_file_of_module(const char *name_of_were_to_output, const char *extension, const struct output_text *text) {
+    char *name_of_file = create_output_file_name(name_of_were_to_output, extension);
+
+    if (name_of_file == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the name of the %s file\n", extension);
+        exit(1);
+    }
+    if (text != NULL) {
+        if (!write_output_if_changed(name_of_file, text)) {
+            exit(1);
+        }
+    } else {
+        /* A file that is left from an earlier version of the module would look like it belongs to this one */
+        remove(name_of_file);
+    }
+    tracked_free(name_of_file);
+}
 
 /*
  * Outputs the object file data to relevent files.
  *
  * This function takes the name of the output files and a pointer to the object file data.
  * It generates and outputs the code and data sections to the .ob file, certain externs
- * to the .ext file, and entry symbols to the .ent file if necessary.
+ * to the .ext file, entry symbols to the .ent file if necessary, and with --reloc the relocatable words to the .rel file. Every file is built in memory
+ * first and written only if it changed, and an .ent or .ext file the module doesn't have anymore is removed.
  *
  * @param name_of_were_to_output The base name of the output files.
  * @param obj_file A pointer to the object file data.
  */
 void output(char * name_of_were_to_output, const struct object_file * obj_file){
-    FILE * ob_file;
-    char * ob_name_of_file;
-    char * ext_name_of_file;
-    char * ent_name_of_file;
-    size_t length_name_of_were_to_output;
-
-    length_name_of_were_to_output = strlen(name_of_were_to_output);
+    struct output_text text = {0};
 
     if (obj_file->number_of_entries >= 1) {
-        ent_name_of_file = malloc(length_name_of_were_to_output + strlen(FILE_EXTENSION_ENT) + 1);
-        if (ent_name_of_file == NULL) {
-            fprintf(stderr, "wasn't able to allocate memory for ent_name_of_file\n"); 
+        if (!output_ent_file(&text, obj_file->table_of_symbols, &obj_file->interned_symbols)) {
             exit(1);
         }
-
-        ent_name_of_file = strcat(strcpy(ent_name_of_file, name_of_were_to_output), FILE_EXTENSION_ENT);
-        output_ent_file(ent_name_of_file , obj_file->table_of_symbols);
-        free(ent_name_of_file);
+        output_file_of_module(name_of_were_to_output, FILE_EXTENSION_ENT, &text);
+    } else {
+        output_file_of_module(name_of_were_to_output, FILE_EXTENSION_ENT, NULL);
     }
 
-    if (get_amount_of_elements_in_certain_extern_linked_list(obj_file->name_and_addresses_certain_extern) >= 1) { 
-        ext_name_of_file = malloc(length_name_of_were_to_output + strlen(FILE_EXTENSION_EXT) + 1);
-        if (ext_name_of_file == NULL) {
-            fprintf(stderr, "wasn't able to allocate memory for ext_name_of_file\n");
+    text.length = 0;
+    if (obj_file->extern_uses.amount_of_uses >= 1) { 
+        if (!output_ext_file(&text, &obj_file->extern_uses, &obj_file->interned_symbols)) {
             exit(1);
         }
-
-        ext_name_of_file = strcat(strcpy(ext_name_of_file, name_of_were_to_output), FILE_EXTENSION_EXT);
-        output_ext_file(ext_name_of_file, obj_file->name_and_addresses_certain_extern);
-        free(ext_name_of_file);
+        output_file_of_module(name_of_were_to_output, FILE_EXTENSION_EXT, &text);
+    } else {
+        output_file_of_module(name_of_were_to_output, FILE_EXTENSION_EXT, NULL);
     }
 
-    ob_name_of_file = malloc(length_name_of_were_to_output + strlen(FILE_EXTENSION_OB) + 1);
-    if (ob_name_of_file == NULL) {
-        fprintf(stderr, "wasn't able to allocate memory for ob_name_of_file\n");
-        exit(1);
-        
+    if (options_of_assembler.output_relocations) {
+        text.length = 0;
+        if (!output_rel_file(&text, &obj_file->relocations)) {
+            exit(1);
+        }
+        output_file_of_module(name_of_were_to_output, FILE_EXTENSION_REL, &text);
     }
 
-    ob_name_of_file = strcat(strcpy(ob_name_of_file, name_of_were_to_output), FILE_EXTENSION_OB);
-    ob_file = fopen(ob_name_of_file, "w");
-
-    if (ob_file == NULL) {
-        fprintf(stderr, "wasn't able to open file: %s\n", ob_name_of_file);
+    if (obj_file->IC > MEMORY_SIZE || obj_file->DC > MEMORY_SIZE) {
+        fprintf(stderr, "Invalid size for code_image or data_image\n");
         exit(1);
     }
-
-    fprintf(ob_file, "%lu %lu\n", (unsigned long)obj_file->IC, (unsigned long)obj_file->DC);
-    if (obj_file->IC <= MEMORY_SIZE && obj_file->DC <= MEMORY_SIZE) {
-           output_section_memory(ob_file, (const unsigned int*)obj_file->code_image, obj_file->IC);
-           output_section_memory(ob_file, (const unsigned int*)obj_file->data_image, obj_file->DC);
-
-        
-    } else {
-          fprintf(stderr, "Invalid size for code_image or data_image\n");
-          exit(1);
+    text.length = 0;
+    if (!append_output_text(&text, "%lu %lu\n", (unsigned long)obj_file->IC, (unsigned long)obj_file->DC) ||
+        !output_section_memory(&text, (const unsigned int*)obj_file->code_image, obj_file->IC) ||
+        !output_section_memory(&text, (const unsigned int*)obj_file->data_image, obj_file->DC)) {
+        exit(1);
     }
-
-    fclose(ob_file);
-    free(ob_name_of_file);
-    
-    
+    output_file_of_module(name_of_were_to_output, FILE_EXTENSION_OB, &text);
+    free_output_text(&text);
 }
 
 
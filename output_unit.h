@@ -7,14 +7,54 @@
 #define FILE_EXTENSION_EXT ".ext"
 #define FILE_EXTENSION_ENT ".ent"
 #define FILE_EXTENSION_OB ".ob"
+#define FILE_EXTENSION_REL ".rel"
+#define FILE_EXTENSION_TEMPORARY ".tmp"
 #define BASE64 "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"
+#define MAX_LENGTH_OF_OUTPUT_LINE 255
+
+/* Represents the text of an output file while it is built in memory */
+struct output_text {
+    char *text; /* The characters of the file, null terminated */
+    size_t length; /* The number of characters of the file */
+    size_t capacity; /* The number of characters there is room for */
+};
+
+/*
+ * Appends formatted text to the text of an output file.
+ *
+ * @param text A pointer to the text of the output file.
+ * @param format The format of the text, as in printf, it must fit in MAX_LENGTH_OF_OUTPUT_LINE characters.
+ * @return 1 if the text was appended, 0 on memory allocation error.
+ */
+int append_output_text(struct output_text *text, const char *format, ...);
+
+/*
+ * Frees the memory of the text of an output file and leaves it empty.
+ *
+ * @param text A pointer to the text of the output file.
+ */
+void free_output_text(struct output_text *text);
+
+/*
+ * Writes the text of an output file, unless the file already holds the same bytes.
+ *
+ * An unchanged file is not touched, so its modification time stays the same. A changed file is
+ * written to a temporary file next to it that is then renamed over it, so a reader sees either
+ * the old file or the new one.
+ *
+ * @param name_of_file The name of the output file.
+ * @param text A pointer to the text of the output file.
+ * @return 1 if the file holds the text, 0 if it couldn't be written.
+ */
+int write_output_if_changed(const char *name_of_file, const struct output_text *text);
 
 /*
  * Outputs the object file data to relevent files.
  *
  * This function takes the name of the output files and a pointer to the object file data.
  * It generates and outputs the code and data sections to the .ob file, certain externs
- * to the .ext file, and entry symbols to the .ent file if necessary.
+ * to the .ext file, and entry symbols to the .ent file if necessary. Every file is built in memory
+ * first and written only if it changed, and an .ent or .ext file the module doesn't have anymore is removed.
  *
  * @param name_of_were_to_output The base name of the output files.
  * @param obj_file A pointer to the object file data.
@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "parallel_lexer.h"
+
+/* Represents the chunk of the lines of a lexed file that one thread works on */
+struct lexer_job {
+    struct lexed_file *file; /* The lexed file */
+    size_t first_line; /* The index of the first line of the chunk */
+    size_t end_line; /* The index right after the last line of the chunk */
+};
+
+/*
+ * The thread that lexes a chunk of the lines.
+ *
+ * @param argument A pointer to the job of the chunk.
+ * @return NULL.
+ */
+static void *lex_chunk(void *argument) {
+    struct lexer_job *job = (struct lexer_job *)argument;
+    struct lexed_file *file = job->file;
+    size_t i;
+
+    for (i = job->first_line; i < job->end_line; i++) {
+        file->lines[i].ast = get_ast_lexer(file->lines[i].text, NULL);
+    }
+    return NULL;
+}
+
+/*
+ * Runs a function on every job, every job but the first in its own thread.
+ *
+ * A job whose thread can't be started runs on the calling thread instead.
+ *
+ * @param jobs The jobs.
+ * @param amount_of_jobs The number of jobs.
+ * @param function The function to run on every job.
+ */
+static void run_jobs(struct lexer_job *jobs, int amount_of_jobs, void *(*function)(void *)) {
+    pthread_t threads[MAX_AMOUNT_OF_JOBS];
+    int started[MAX_AMOUNT_OF_JOBS];
+    int i;
+
+    for (i = 1; i < amount_of_jobs; i++) {
+        started[i] = pthread_create(&threads[i], NULL, function, &jobs[i]) == 0;
+        if (!started[i]) {
+            function(&jobs[i]);
+        }
+    }
+    function(&jobs[0]);
+    for (i = 1; i < amount_of_jobs; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+}
+
+/*
+ * Reads an am file and lexes its lines in parallel.
+ *
+ * The lines are split in to one chunk for every job, and every chunk is lexed by its own thread.
+ * The names of the labels are not interned, the compilation interns them and assigns the IC and DC
+ * in the order of the lines. The file is rewound when the function returns.
+ *
+ * @param am_file The am file, opened for reading.
+ * @param amount_of_jobs The number of threads to lex with, up to MAX_AMOUNT_OF_JOBS.
+ * @param file A pointer to the structure that receives the lexed lines.
+ * @return 1 if the lines were lexed, 0 on memory allocation error.
+ */
+int lex_am_file_in_parallel(FILE *am_file, int amount_of_jobs, struct lexed_file *file) {
+    struct lexer_job jobs[MAX_AMOUNT_OF_JOBS];
+    char empty_line[] = "\n";
+    struct lexed_line *bigger_lines;
+    size_t capacity = 0;
+    size_t size_of_chunk;
+    int i;
+
+    memset(file, 0, sizeof(struct lexed_file));
+    /* Read the lines the same way the compilation reads them */
+    for (;;) {
+        if (file->amount_of_lines == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            bigger_lines = (struct lexed_line *)tracked_realloc(file->lines, capacity * sizeof(struct lexed_line), MEMORY_LEXED_LINES);
+            if (bigger_lines == NULL) {
+                fprintf(stderr, "wasn't able to allocate memory for the lexed lines\n");
+                free_lexed_file(file);
+                rewind(am_file);
+                return 0;
+            }
+            file->lines = bigger_lines;
+        }
+        if (!fgets(file->lines[file->amount_of_lines].text, MAX_LENGTH_OF_LINE + 1, am_file)) {
+            break;
+        }
+        file->lines[file->amount_of_lines].has_origin = 0;
+        file->lines[file->amount_of_lines].ends_line = strchr(file->lines[file->amount_of_lines].text, '\n') != NULL;
+        file->amount_of_lines++;
+    }
+    rewind(am_file);
+
+    if (file->amount_of_lines == 0) {
+        return 1;
+    }
+
+    /* Every job gets at least one line */
+    if (amount_of_jobs > MAX_AMOUNT_OF_JOBS) {
+        amount_of_jobs = MAX_AMOUNT_OF_JOBS;
+    }
+    if (amount_of_jobs < 1) {
+        amount_of_jobs = 1;
+    }
+    if ((size_t)amount_of_jobs > file->amount_of_lines) {
+        amount_of_jobs = (int)file->amount_of_lines;
+    }
+    size_of_chunk = (file->amount_of_lines + amount_of_jobs - 1) / amount_of_jobs;
+    for (i = 0; i < amount_of_jobs; i++) {
+        jobs[i].file = file;
+        jobs[i].first_line = i * size_of_chunk;
+        jobs[i].end_line = jobs[i].first_line + size_of_chunk;
+        if (jobs[i].first_line > file->amount_of_lines) {
+            jobs[i].first_line = file->amount_of_lines;
+        }
+        if (jobs[i].end_line > file->amount_of_lines) {
+            jobs[i].end_line = file->amount_of_lines;
+        }
+    }
+
+    /* The lexer builds its tables on its first call, so it lexes an empty line before the threads start */
+    get_ast_lexer(empty_line, NULL);
+    run_jobs(jobs, amount_of_jobs, lex_chunk);
+    return 1;
+}
+
+/*
+ * Reads the pieces of the lines of an am file, the same way the compilation reads them.
+ *
+ * @param am_file The am file, opened for reading, it is rewound.
+ * @param amount_of_lines A pointer that receives the number of pieces.
+ * @return The pieces, dynamically allocated, or NULL on memory allocation error.
+ */
+static char (*read_pieces_of_lines(FILE *am_file, size_t *amount_of_lines))[MAX_LENGTH_OF_LINE + 1] {
+    char (*lines)[MAX_LENGTH_OF_LINE + 1] = NULL;
+    char (*bigger_lines)[MAX_LENGTH_OF_LINE + 1];
+    size_t capacity = 0;
+
+    *amount_of_lines = 0;
+    for (;;) {
+        if (*amount_of_lines == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            bigger_lines = (char (*)[MAX_LENGTH_OF_LINE + 1])tracked_realloc(lines, capacity * sizeof(*lines), MEMORY_LEXED_LINES);
+            if (bigger_lines == NULL) {
+                tracked_free(lines);
+                rewind(am_file);
+                return NULL;
+            }
+            lines = bigger_lines;
+        }
+        if (!fgets(lines[*amount_of_lines], MAX_LENGTH_OF_LINE + 1, am_file)) {
+            break;
+        }
+        (*amount_of_lines)++;
+    }
+    rewind(am_file);
+    return lines;
+}
+
+/*
+ * Reads an am file again and lexes only the lines that changed since the file was lexed last.
+ *
+ * The lines at the start and at the end of the file that are the same as before keep their ASTs,
+ * and only the lines between them are lexed. The lines after the change keep their place in memory.
+ * The compilation still defines the symbols and encodes the words of every line. A file that was never lexed is lexed whole.
+ * The file is rewound when the function returns.
+ *
+ * @param am_file The am file, opened for reading.
+ * @param file A pointer to the lexed file, empty or from the last call.
+ * @return 1 if the lines were lexed, 0 on memory allocation error, the lexed file is empty then.
+ */
+int relex_am_file(FILE *am_file, struct lexed_file *file) {
+    struct lexed_file relexed = {0};
+    size_t same_at_start = 0;
+    size_t same_at_end = 0;
+    size_t old_line;
+    size_t i;
+
+    relexed.read_lines = read_pieces_of_lines(am_file, &relexed.amount_of_lines);
+    if (relexed.read_lines != NULL) {
+        relexed.kept_lines = (struct lexed_line **)tracked_calloc(relexed.amount_of_lines + 1, sizeof(struct lexed_line *), MEMORY_LEXED_LINES);
+    }
+    if (relexed.read_lines == NULL || relexed.kept_lines == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the lexed lines\n");
+        free_lexed_file(&relexed);
+        free_lexed_file(file);
+        return 0;
+    }
+
+    /* Find the lines that didn't change, from the start and from the end */
+    if (file->kept_lines != NULL) {
+        while (same_at_start < file->amount_of_lines && same_at_start < relexed.amount_of_lines &&
+               strcmp(file->read_lines[same_at_start], relexed.read_lines[same_at_start]) == 0) {
+            same_at_start++;
+        }
+        while (same_at_end < file->amount_of_lines - same_at_start && same_at_end < relexed.amount_of_lines - same_at_start &&
+               strcmp(file->read_lines[file->amount_of_lines - 1 - same_at_end], relexed.read_lines[relexed.amount_of_lines - 1 - same_at_end]) == 0) {
+            same_at_end++;
+        }
+    }
+
+    for (i = 0; i < relexed.amount_of_lines; i++) {
+        if (i < same_at_start || i >= relexed.amount_of_lines - same_at_end) {
+            /* The line keeps its place in memory, so its AST still points in to its text */
+            old_line = i < same_at_start ? i : i - relexed.amount_of_lines + file->amount_of_lines;
+            relexed.kept_lines[i] = file->kept_lines[old_line];
+            file->kept_lines[old_line] = NULL;
+            continue;
+        }
+        relexed.kept_lines[i] = (struct lexed_line *)tracked_malloc(sizeof(struct lexed_line), MEMORY_LEXED_LINES);
+        if (relexed.kept_lines[i] == NULL) {
+            fprintf(stderr, "wasn't able to allocate memory for the lexed lines\n");
+            free_lexed_file(&relexed);
+            free_lexed_file(file);
+            return 0;
+        }
+        strcpy(relexed.kept_lines[i]->text, relexed.read_lines[i]);
+        relexed.kept_lines[i]->has_origin = 0;
+        relexed.kept_lines[i]->ends_line = strchr(relexed.kept_lines[i]->text, '\n') != NULL;
+        relexed.kept_lines[i]->ast = get_ast_lexer(relexed.kept_lines[i]->text, NULL);
+        relexed.amount_of_relexed_lines++;
+    }
+    /* Only the lines that changed are freed with the old file */
+    free_lexed_file(file);
+    *file = relexed;
+    return 1;
+}
+
+/*
+ * Frees the memory of a lexed file and leaves it empty.
+ *
+ * @param file A pointer to the lexed file.
+ */
+void free_lexed_file(struct lexed_file *file) {
+    size_t i;
+
+    for (i = 0; file->kept_lines != NULL && i < file->amount_of_lines; i++) {
+        tracked_free(file->kept_lines[i]);
+    }
+    tracked_free(file->kept_lines);
+    tracked_free(file->lines);
+    tracked_free(file->read_lines);
+    memset(file, 0, sizeof(struct lexed_file));
+}
@@ -0,0 +1,57 @@
+#ifndef __PARALLEL_LEXER_H_
+#define __PARALLEL_LEXER_H_
+
+#include <stdio.h>
+#include "common.h"
+#include "lexer.h"
+#include "pipeline.h"
+#include "encoding_table.h"
+
+#define MAX_LENGTH_OF_LINE 81
+#define MAX_AMOUNT_OF_JOBS 64
+
+/* Represents the lines of an am file after they were lexed */
+struct lexed_file {
+    struct lexed_line *lines; /* The pieces of the lines, in the pieces the compilation reads them in */
+    struct lexed_line **kept_lines; /* With relex_am_file every piece is allocated on its own, so it keeps its place when lines are added, and lines is NULL */
+    size_t amount_of_lines; /* The number of pieces */
+    char (*read_lines)[MAX_LENGTH_OF_LINE + 1]; /* The pieces as they were read, before they were lexed, kept by relex_am_file */
+    size_t amount_of_relexed_lines; /* The number of pieces relex_am_file lexed the last time */
+};
+
+/*
+ * Reads an am file and lexes its lines in parallel.
+ *
+ * The lines are split in to one chunk for every job, and every chunk is lexed by its own thread.
+ * The names of the labels are not interned, the compilation interns them and assigns the IC and DC
+ * in the order of the lines. The file is rewound when the function returns.
+ *
+ * @param am_file The am file, opened for reading.
+ * @param amount_of_jobs The number of threads to lex with, up to MAX_AMOUNT_OF_JOBS.
+ * @param file A pointer to the structure that receives the lexed lines.
+ * @return 1 if the lines were lexed, 0 on memory allocation error.
+ */
+int lex_am_file_in_parallel(FILE *am_file, int amount_of_jobs, struct lexed_file *file);
+
+/*
+ * Reads an am file again and lexes only the lines that changed since the file was lexed last.
+ *
+ * The lines at the start and at the end of the file that are the same as before keep their ASTs,
+ * and only the lines between them are lexed. The lines after the change keep their place in memory.
+ * The compilation still defines the symbols and encodes the words of every line. A file that was never lexed is lexed whole.
+ * The file is rewound when the function returns.
+ *
+ * @param am_file The am file, opened for reading.
+ * @param file A pointer to the lexed file, empty or from the last call.
+ * @return 1 if the lines were lexed, 0 on memory allocation error, the lexed file is empty then.
+ */
+int relex_am_file(FILE *am_file, struct lexed_file *file);
+
+/*
+ * Frees the memory of a lexed file and leaves it empty.
+ *
+ * @param file A pointer to the lexed file.
+ */
+void free_lexed_file(struct lexed_file *file);
+
+#endif
@@ -0,0 +1,264 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pipeline.h"
+#include "preprocessor.h"
+#include "trace_events.h"
+
+/*
+ * Initializes an empty ring.
+ *
+ * @param ring A pointer to the ring.
+ * @param size_of_slot The size of every slot.
+ * @return 1 if the ring was initialized, 0 on memory allocation error.
+ */
+int init_line_ring(struct line_ring *ring, size_t size_of_slot) {
+    memset(ring, 0, sizeof(struct line_ring));
+    ring->slots = (unsigned char *)tracked_malloc(SLOTS_OF_LINE_RING * size_of_slot, MEMORY_LEXED_LINES);
+    if (ring->slots == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the pipeline\n");
+        return 0;
+    }
+    ring->size_of_slot = size_of_slot;
+    pthread_mutex_init(&ring->lock, NULL);
+    pthread_cond_init(&ring->not_full, NULL);
+    pthread_cond_init(&ring->not_empty, NULL);
+    return 1;
+}
+
+/*
+ * Waits for a free slot of a ring that the producer can fill.
+ *
+ * @param ring A pointer to the ring.
+ * @return A pointer to the slot, or NULL if the consumer closed the ring.
+ */
+void *begin_push_to_ring(struct line_ring *ring) {
+    int closed = 0;
+
+    if (ring->pushes_of_producer - ring->popped_seen_by_producer == SLOTS_OF_LINE_RING) {
+        pthread_mutex_lock(&ring->lock);
+        /* The consumer may be waiting for the slots that weren't published yet */
+        ring->pushed = ring->pushes_of_producer;
+        pthread_cond_signal(&ring->not_empty);
+        while (ring->pushes_of_producer - ring->popped == SLOTS_OF_LINE_RING && !ring->closed) {
+            pthread_cond_wait(&ring->not_full, &ring->lock);
+        }
+        ring->popped_seen_by_producer = ring->popped;
+        closed = ring->closed;
+        pthread_mutex_unlock(&ring->lock);
+    }
+    if (closed) {
+        return NULL;
+    }
+    /* Only the producer writes the slots the consumer already popped */
+    return ring->slots + (ring->pushes_of_producer % SLOTS_OF_LINE_RING) * ring->size_of_slot;
+}
+
+/*
+ * Pushes the slot that the producer filled to the consumer.
+ *
+ * @param ring A pointer to the ring.
+ */
+void end_push_to_ring(struct line_ring *ring) {
+    ring->pushes_of_producer++;
+    if (ring->pushes_of_producer % SLOTS_OF_RING_BATCH == 0) {
+        pthread_mutex_lock(&ring->lock);
+        ring->pushed = ring->pushes_of_producer;
+        ring->popped_seen_by_producer = ring->popped;
+        pthread_cond_signal(&ring->not_empty);
+        pthread_mutex_unlock(&ring->lock);
+    }
+}
+
+/*
+ * Tells the consumer of a ring that no more slots will be pushed.
+ *
+ * @param ring A pointer to the ring.
+ */
+void finish_pushing_to_ring(struct line_ring *ring) {
+    pthread_mutex_lock(&ring->lock);
+    ring->pushed = ring->pushes_of_producer;
+    ring->finished = 1;
+    pthread_cond_broadcast(&ring->not_empty);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+/*
+ * Waits for the oldest slot of a ring that was pushed, it stays valid until end_pop_from_ring.
+ *
+ * @param ring A pointer to the ring.
+ * @return A pointer to the slot, or NULL if the producer finished and all the slots were popped.
+ */
+void *begin_pop_from_ring(struct line_ring *ring) {
+    if (ring->pops_of_consumer == ring->pushed_seen_by_consumer) {
+        pthread_mutex_lock(&ring->lock);
+        /* The producer may be waiting for the slots that weren't published yet */
+        ring->popped = ring->pops_of_consumer;
+        pthread_cond_signal(&ring->not_full);
+        while (ring->pushed == ring->pops_of_consumer && !ring->finished) {
+            pthread_cond_wait(&ring->not_empty, &ring->lock);
+        }
+        ring->pushed_seen_by_consumer = ring->pushed;
+        pthread_mutex_unlock(&ring->lock);
+        if (ring->pops_of_consumer == ring->pushed_seen_by_consumer) {
+            return NULL;
+        }
+    }
+    return ring->slots + (ring->pops_of_consumer % SLOTS_OF_LINE_RING) * ring->size_of_slot;
+}
+
+/*
+ * Frees the slot that the consumer popped.
+ *
+ * @param ring A pointer to the ring.
+ */
+void end_pop_from_ring(struct line_ring *ring) {
+    ring->pops_of_consumer++;
+    if (ring->pops_of_consumer % SLOTS_OF_RING_BATCH == 0) {
+        pthread_mutex_lock(&ring->lock);
+        ring->popped = ring->pops_of_consumer;
+        ring->pushed_seen_by_consumer = ring->pushed;
+        pthread_cond_signal(&ring->not_full);
+        pthread_mutex_unlock(&ring->lock);
+    }
+}
+
+/*
+ * Tells the producer of a ring that no more slots will be popped, so it stops waiting.
+ *
+ * @param ring A pointer to the ring.
+ */
+void close_ring(struct line_ring *ring) {
+    pthread_mutex_lock(&ring->lock);
+    ring->closed = 1;
+    pthread_cond_broadcast(&ring->not_full);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+/*
+ * Frees the memory of a ring.
+ *
+ * @param ring A pointer to the ring.
+ */
+void destroy_line_ring(struct line_ring *ring) {
+    pthread_mutex_destroy(&ring->lock);
+    pthread_cond_destroy(&ring->not_full);
+    pthread_cond_destroy(&ring->not_empty);
+    tracked_free(ring->slots);
+    memset(ring, 0, sizeof(struct line_ring));
+}
+
+/*
+ * The thread that preprocesses the file of a pipeline.
+ *
+ * @param argument A pointer to the pipeline.
+ * @return NULL.
+ */
+static void *preprocessor_thread(void *argument) {
+    struct pipeline *pipeline = (struct pipeline *)argument;
+    double start_of_preprocessor;
+
+    name_trace_thread("preprocessor");
+    start_of_preprocessor = trace_clock();
+    pipeline->am_name_of_file = file_preprocessor(pipeline->name_of_file, &pipeline->origins_of_preprocessor, &pipeline->expanded_lines, pipeline->preloaded, pipeline->dependencies);
+    add_trace_span("file_preprocessor", pipeline->name_of_file, start_of_preprocessor);
+    finish_pushing_to_ring(&pipeline->expanded_lines);
+    return NULL;
+}
+
+/*
+ * The thread that lexes the lines of the am file of a pipeline.
+ *
+ * @param argument A pointer to the pipeline.
+ * @return NULL.
+ */
+static void *lexer_thread(void *argument) {
+    struct pipeline *pipeline = (struct pipeline *)argument;
+    struct expanded_line *expanded;
+    struct lexed_line *lexed;
+    double start_of_lexer;
+
+    name_trace_thread("lexer");
+    start_of_lexer = trace_clock();
+    while ((expanded = (struct expanded_line *)begin_pop_from_ring(&pipeline->expanded_lines)) != NULL) {
+        lexed = (struct lexed_line *)begin_push_to_ring(&pipeline->lexed_lines);
+        if (lexed == NULL) {
+            /* The compilation stopped, so the preprocessor only has to finish the am file */
+            end_pop_from_ring(&pipeline->expanded_lines);
+            close_ring(&pipeline->expanded_lines);
+            break;
+        }
+        memcpy(lexed->text, expanded->text, sizeof(lexed->text));
+        lexed->has_origin = expanded->has_origin;
+        lexed->origin = expanded->origin;
+        end_pop_from_ring(&pipeline->expanded_lines);
+        lexed->ends_line = strchr(lexed->text, '\n') != NULL;
+        /* The names of the labels are interned by the compilation, which owns the interner */
+        lexed->ast = get_ast_lexer(lexed->text, NULL);
+        end_push_to_ring(&pipeline->lexed_lines);
+    }
+    finish_pushing_to_ring(&pipeline->lexed_lines);
+    add_trace_span("lex", pipeline->name_of_file, start_of_lexer);
+    return NULL;
+}
+
+/*
+ * Starts the threads that preprocess and lex a file.
+ *
+ * The preprocessor thread writes the am file as usual and sends its lines to the lexer thread,
+ * which sends the lexed lines to the compilation through pipeline->lexed_lines.
+ *
+ * @param pipeline A pointer to the pipeline.
+ * @param name_of_file The base name of the file.
+ * @param preloaded The source file that was read ahead of time, or NULL. The preprocessor thread takes it.
+ * @param dependencies A pointer that receives the files the preprocessor read, or NULL. It is complete once the pipeline is finished.
+ * @return 1 if the threads were started, 0 otherwise.
+ */
+int start_pipeline(struct pipeline *pipeline, char *name_of_file, struct preloaded_source *preloaded, struct source_dependencies *dependencies) {
+    memset(pipeline, 0, sizeof(struct pipeline));
+    pipeline->name_of_file = name_of_file;
+    pipeline->preloaded = preloaded;
+    pipeline->dependencies = dependencies;
+    if (!init_line_ring(&pipeline->expanded_lines, sizeof(struct expanded_line))) {
+        return 0;
+    }
+    if (!init_line_ring(&pipeline->lexed_lines, sizeof(struct lexed_line))) {
+        destroy_line_ring(&pipeline->expanded_lines);
+        return 0;
+    }
+    if (pthread_create(&pipeline->preprocessor_thread, NULL, preprocessor_thread, pipeline) != 0) {
+        fprintf(stderr, "wasn't able to start the preprocessor thread\n");
+        destroy_line_ring(&pipeline->expanded_lines);
+        destroy_line_ring(&pipeline->lexed_lines);
+        return 0;
+    }
+    if (pthread_create(&pipeline->lexer_thread, NULL, lexer_thread, pipeline) != 0) {
+        fprintf(stderr, "wasn't able to start the lexer thread\n");
+        /* Nobody lexes the lines, so the preprocessor only writes the am file */
+        close_ring(&pipeline->expanded_lines);
+        pthread_join(pipeline->preprocessor_thread, NULL);
+        tracked_free((char *)pipeline->am_name_of_file);
+        free_line_origin_table(&pipeline->origins_of_preprocessor);
+        destroy_line_ring(&pipeline->expanded_lines);
+        destroy_line_ring(&pipeline->lexed_lines);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Waits for the threads of a pipeline to end and frees its memory.
+ *
+ * @param pipeline A pointer to the pipeline.
+ * @return The name of the am file, or NULL if the preprocessing failed. The caller frees it.
+ */
+const char *finish_pipeline(struct pipeline *pipeline) {
+    /* The compilation may have stopped before the end of the file */
+    close_ring(&pipeline->lexed_lines);
+    pthread_join(pipeline->lexer_thread, NULL);
+    pthread_join(pipeline->preprocessor_thread, NULL);
+    free_line_origin_table(&pipeline->origins_of_preprocessor);
+    destroy_line_ring(&pipeline->expanded_lines);
+    destroy_line_ring(&pipeline->lexed_lines);
+    return pipeline->am_name_of_file;
+}
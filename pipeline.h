@@ -0,0 +1,147 @@
+#ifndef __PIPELINE_H_
+#define __PIPELINE_H_
+
+#include <pthread.h>
+#include "common.h"
+#include "lexer.h"
+#include "read_ahead.h"
+
+#define MAX_LENGTH_OF_LINE 81
+#define SLOTS_OF_LINE_RING 256
+#define SLOTS_OF_RING_BATCH 32
+
+/*
+ * Represents a bounded ring of slots between one producer thread and one consumer thread.
+ *
+ * The counters only grow, and slot n is at index n % SLOTS_OF_LINE_RING. Every side publishes its
+ * counter under the lock once every SLOTS_OF_RING_BATCH slots, or before it waits, and keeps a copy
+ * of the counter of the other side, so most pushes and pops don't take the lock.
+ */
+struct line_ring {
+    unsigned char *slots; /* The slots of the ring */
+    size_t size_of_slot; /* The size of every slot */
+    unsigned long pushed; /* The number of slots the producer published, under the lock */
+    unsigned long popped; /* The number of slots the consumer published, under the lock */
+    int finished; /* Set when the producer won't push any more slots, under the lock */
+    int closed; /* Set when the consumer won't pop any more slots, under the lock */
+    unsigned long pushes_of_producer; /* The number of slots the producer pushed, only the producer uses it */
+    unsigned long popped_seen_by_producer; /* The last popped the producer saw, only the producer uses it */
+    unsigned long pops_of_consumer; /* The number of slots the consumer popped, only the consumer uses it */
+    unsigned long pushed_seen_by_consumer; /* The last pushed the consumer saw, only the consumer uses it */
+    pthread_mutex_t lock; /* Protects the fields of the ring */
+    pthread_cond_t not_full; /* Signaled when a slot is popped or the ring is closed */
+    pthread_cond_t not_empty; /* Signaled when a slot is pushed or the ring is finished */
+};
+
+/* Represents a line of the am file, in the pieces the compilation reads it in, that the preprocessor wrote */
+struct expanded_line {
+    char text[MAX_LENGTH_OF_LINE + 1]; /* The text of the piece of the line */
+    int has_origin; /* 1 if the piece is the first of a line of the am file that has an origin */
+    struct line_origin origin; /* The origin of the line */
+};
+
+/* Represents a piece of a line of the am file after it was lexed */
+struct lexed_line {
+    char text[MAX_LENGTH_OF_LINE + 1]; /* The text of the piece of the line, the AST points in to it */
+    int has_origin; /* 1 if the piece is the first of a line of the am file that has an origin */
+    struct line_origin origin; /* The origin of the line */
+    int ends_line; /* 1 if the piece ends the line */
+    mmn14_ast ast; /* The AST of the piece, the names of its labels are not interned yet */
+};
+
+/* Represents the threads that preprocess and lex one file while it is compiled */
+struct pipeline {
+    char *name_of_file; /* The base name of the file */
+    struct line_ring expanded_lines; /* The lines from the preprocessor to the lexer */
+    struct line_ring lexed_lines; /* The lines from the lexer to the compilation */
+    struct line_origin_table origins_of_preprocessor; /* The origins the preprocessor adds, the compilation gets them with the lines */
+    struct preloaded_source *preloaded; /* The source file that was read ahead of time, or NULL */
+    struct source_dependencies *dependencies; /* Receives the files the preprocessor read, or NULL */
+    const char *am_name_of_file; /* The name of the am file, NULL if the preprocessing failed */
+    pthread_t preprocessor_thread; /* The thread that preprocesses the file */
+    pthread_t lexer_thread; /* The thread that lexes the lines of the am file */
+};
+
+/*
+ * Initializes an empty ring.
+ *
+ * @param ring A pointer to the ring.
+ * @param size_of_slot The size of every slot.
+ * @return 1 if the ring was initialized, 0 on memory allocation error.
+ */
+int init_line_ring(struct line_ring *ring, size_t size_of_slot);
+
+/*
+ * Waits for a free slot of a ring that the producer can fill.
+ *
+ * @param ring A pointer to the ring.
+ * @return A pointer to the slot, or NULL if the consumer closed the ring.
+ */
+void *begin_push_to_ring(struct line_ring *ring);
+
+/*
+ * Pushes the slot that the producer filled to the consumer.
+ *
+ * @param ring A pointer to the ring.
+ */
+void end_push_to_ring(struct line_ring *ring);
+
+/*
+ * Tells the consumer of a ring that no more slots will be pushed.
+ *
+ * @param ring A pointer to the ring.
+ */
+void finish_pushing_to_ring(struct line_ring *ring);
+
+/*
+ * Waits for the oldest slot of a ring that was pushed, it stays valid until end_pop_from_ring.
+ *
+ * @param ring A pointer to the ring.
+ * @return A pointer to the slot, or NULL if the producer finished and all the slots were popped.
+ */
+void *begin_pop_from_ring(struct line_ring *ring);
+
+/*
+ * Frees the slot that the consumer popped.
+ *
+ * @param ring A pointer to the ring.
+ */
+void end_pop_from_ring(struct line_ring *ring);
+
+/*
+ * Tells the producer of a ring that no more slots will be popped, so it stops waiting.
+ *
+ * @param ring A pointer to the ring.
+ */
+void close_ring(struct line_ring *ring);
+
+/*
+ * Frees the memory of a ring.
+ *
+ * @param ring A pointer to the ring.
+ */
+void destroy_line_ring(struct line_ring *ring);
+
+/*
+ * Starts the threads that preprocess and lex a file.
+ *
+ * The preprocessor thread writes the am file as usual and sends its lines to the lexer thread,
+ * which sends the lexed lines to the compilation through pipeline->lexed_lines.
+ *
+ * @param pipeline A pointer to the pipeline.
+ * @param name_of_file The base name of the file.
+ * @param preloaded The source file that was read ahead of time, or NULL. The preprocessor thread takes it.
+ * @param dependencies A pointer that receives the files the preprocessor read, or NULL. It is complete once the pipeline is finished.
+ * @return 1 if the threads were started, 0 otherwise.
+ */
+int start_pipeline(struct pipeline *pipeline, char *name_of_file, struct preloaded_source *preloaded, struct source_dependencies *dependencies);
+
+/*
+ * Waits for the threads of a pipeline to end and frees its memory.
+ *
+ * @param pipeline A pointer to the pipeline.
+ * @return The name of the am file, or NULL if the preprocessing failed. The caller frees it.
+ */
+const char *finish_pipeline(struct pipeline *pipeline);
+
+#endif
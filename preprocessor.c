@@ -1,15 +1,28 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <stdarg.h>
 #include <libgen.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include "preprocessor.h"
+#include "input_files.h"
+#include "macro_library.h"
+#include "dependency_file.h"
 
 
 #define file_extension_as ".as"
 #define file_extension_am ".am"
 #define MAX_LENGTH_OF_MACRO 31
 #define MAX_LENGTH_OF_LINE 81
+#define MAX_MACRO_PARAMETERS 9
+#define MAX_DEPTH_OF_MACROS 16
+#define MAX_LINES_OF_EXPANSION 1024
+#define MAX_DEPTH_OF_INCLUDES 16
+#define ANSI_COLOR_RED "\x1b[31m"
+#define ANSI_COLOR_RESET "\x1b[0m"
 #define SPACE_CHARS " \t\n\f\r\v"
 #define SKIP_SPACE(str) while(*str && isspace(*str)) str++
 #define SKIP_SPACE_REVERSE(str,end) while(*str && isspace(*str) && end != str) str++
@@ -20,14 +33,14 @@ typedef char* line_of_code;
 /*
  * Create a new macro structure and initialize its feilds.
  *
- * This function allocates memory for a new macro structure, sets its name, and initializes
- * the linked list to store lines of code associated with the macro.
+ * This function allocates memory for a new macro structure, sets its name, and starts
+ * it with an empty body.
  *
  * @param macro_name The name of the macro being created.
  * @return A pointer to the newly created macro structure, or NULL on memory allocation error.
  */
 struct macro *create_macro(const char *macro_name) {
-    struct macro *new_macro = (struct macro *)malloc(sizeof(struct macro));
+    struct macro *new_macro = (struct macro *)tracked_malloc(sizeof(struct macro), MEMORY_MACROS);
     if (!new_macro) {
         fprintf(stderr, "wasn't able to allocate memory for new macro\n");
         return NULL;
@@ -36,21 +49,24 @@ struct macro *create_macro(const char *macro_name) {
     strncpy(new_macro->name_of_macro, macro_name, MAX_LENGTH_OF_MACRO - 1);
     new_macro->name_of_macro[MAX_LENGTH_OF_MACRO - 1] = '\0';
 
-    /* Initialize the linked list to store lines of code */
-    new_macro->lines_of_code = new_linked_list_string(""); 
-    free(new_macro);
+    /* The macro has no lines yet */
+    new_macro->offset_of_body = 0;
+    new_macro->length_of_body = 0;
+    new_macro->lines_in_source = NULL;
+    new_macro->amount_of_lines = 0;
+    /* The template is compiled when the macro ends */
+    new_macro->pieces = NULL;
+    new_macro->amount_of_pieces = 0;
+    new_macro->template_lines = NULL;
+    new_macro->amount_of_template_lines = 0;
+    new_macro->amount_of_parameters = 0;
+    new_macro->amount_of_expansions = 0;
+    new_macro->source_text = NULL;
+    new_macro->is_included = 0;
 
     return new_macro;
 }
 
-char *my_implementation_for_strdup(const char *str) {
-    char *new_str = (char *)malloc(strlen(str) + 1);
-    if (new_str != NULL) {
-        strcpy(new_str, str);
-    }
-    return new_str;
-}
-
 enum preprocessor_line_recognition{
     empty_line,
     definition_of_a_macro,
@@ -97,7 +113,9 @@ enum preprocessor_line_recognition recegnize_a_line(char *line, int in_macro, Ma
     /* Remove comments from the line */
     semi_colon = strchr(line, ';');
     if (semi_colon) {
-        *semi_colon = '\0';
+        /* Keep the end of the line, so the next line is not appended to this one */
+        semi_colon[0] = '\n';
+        semi_colon[1] = '\0';
     }
     /* Skip spaces again */
     SKIP_SPACE(line);
@@ -106,25 +124,27 @@ enum preprocessor_line_recognition recegnize_a_line(char *line, int in_macro, Ma
         return empty_line;
     }
     
-    if (in_macro == 0 && table_with_names_of_macros != NULL) { 
-        /* Clean the line and remove newline character */
-        cleaned_line = my_implementation_for_strdup(line); 
+    if (in_macro == 0 && (table_with_names_of_macros != NULL || macro_libraries_are_loaded())) { 
+        /* Clean the line and keep its first word, the rest of the line are the arguments of a call */
+        cleaned_line = tracked_strdup(line, MEMORY_MACROS); 
         if (cleaned_line != NULL) {
-            size_t len = strlen(cleaned_line);
-            if (len > 0 && cleaned_line[len - 1] == '\n') {
-                cleaned_line[len - 1] = '\0'; 
-            }
+            cleaned_line[strcspn(cleaned_line, SPACE_CHARS)] = '\0';
             /* Check if cleaned line matches any defined macro names */
-            current_node = table_with_names_of_macros->head;
+            current_node = table_with_names_of_macros != NULL ? table_with_names_of_macros->head : NULL;
             while (current_node != NULL) {
                 if (*name_of_macro != NULL && strcmp(cleaned_line, current_node->data) == 0) {
-                    free(cleaned_line); 
+                    tracked_free(cleaned_line); 
                     return calling_a_macro;
                 }
                 current_node = (StringNode *)current_node->next;
             }
+            /* The macros of the loaded libraries can be called from every file */
+            if (find_library_macro(cleaned_line) != NULL) {
+                tracked_free(cleaned_line); 
+                return calling_a_macro;
+            }
             
-            free(cleaned_line); 
+            tracked_free(cleaned_line); 
         }
    }
 
@@ -184,7 +204,6 @@ enum preprocessor_line_recognition recegnize_a_line(char *line, int in_macro, Ma
             return incurrect_definition_of_a_macro;
         }
 
-        *name_of_macro = (char *)my_implementation_for_strdup(line);
         /* Check if macro name is alphanumeric */
         while (*tmp) {
             if (!isalnum(*tmp)) {
@@ -192,16 +211,10 @@ enum preprocessor_line_recognition recegnize_a_line(char *line, int in_macro, Ma
             }
             tmp++;
         }
-            /* Check if macro name already exists */
+            /* Check if macro name already exists, the caller inserts the new name in to the table */
             if (find_string_in_linked_list(table_with_names_of_macros, *name_of_macro)) {
              return macro_exists_already_its_redefinetion;
             }
-            /* Insert macro name in to the table */
-            insert_string_to_linked_list(&table_with_names_of_macros, *name_of_macro);
-            if (!table_with_names_of_macros) {
-                fprintf(stderr, "wasn't able to insert macro name into table_with_names_of_macros\n");
-                exit(1); 
-            }
 
         return definition_of_a_macro;
     }
@@ -231,28 +244,12 @@ enum preprocessor_line_recognition recegnize_a_line(char *line, int in_macro, Ma
  *         or NULL if there's a memory allocation error.
  */
 char* prepare_filename(char* name_of_file, const char* extension) {
-    char* file_name;
-    char* prepared_name;
-
-    file_name = malloc(strlen(name_of_file) + 1);
-    if (file_name == NULL) {
-        fprintf(stderr, "Memory allocation error.\n");
-        return NULL;
-    }
-    /* Copy the input filename to the allocated memory */
-    strcpy(file_name, name_of_file);
-    strcat(file_name, extension);
+    char* prepared_name = create_file_name(name_of_file, extension);
 
-    prepared_name = malloc(strlen(file_name) + strlen(extension) + 1);
     if (prepared_name == NULL) {
         fprintf(stderr, "Memory allocation error.\n");
-        free(file_name); 
         return NULL;
     }
-    /* Copy the filename and extension to the prepared name */
-    strcpy(prepared_name, file_name);
-
-    free(file_name); 
     return prepared_name;
 }
 
@@ -279,56 +276,851 @@ FILE* open_file(const char* filename, const char* mode) {
 }
 
 /*
- * This function reads the content of the source assembly file, processes each line
- * and writes the modified lines to an output am file.
- * The preprocessor recognizes macros, expands macros when called, and handles various
- * preprocessor line types.
+ * Reads the whole content of a file in to memory.
  *
- * @param name_of_file The name of the source assembly file to be preprocessed.
- * @return A pointer to the name of the generated modified assembly file, or NULL on error.
+ * @param file The file, opened for reading.
+ * @param size_of_text A pointer that receives the number of characters that were read.
+ * @return The content of the file, null-terminated, or NULL on memory allocation error.
+ */
+char *read_whole_file(FILE *file, size_t *size_of_text) {
+    char *text = NULL;
+    char *bigger_text;
+    size_t capacity = 0;
+    size_t amount_read;
+
+    *size_of_text = 0;
+    do {
+        if (*size_of_text + 1 >= capacity) {
+            capacity = capacity ? capacity * 2 : 4096;
+            bigger_text = (char *)tracked_realloc(text, capacity, MEMORY_SOURCES);
+            if (bigger_text == NULL) {
+                tracked_free(text);
+                return NULL;
+            }
+            text = bigger_text;
+        }
+        amount_read = fread(text + *size_of_text, 1, capacity - *size_of_text - 1, file);
+        *size_of_text += amount_read;
+    } while (amount_read > 0);
+    text[*size_of_text] = '\0';
+    return text;
+}
+
+/*
+ * Reads the next line of the text of a source file, the same way fgets reads it from the file.
+ *
+ * @param text The text of the source file.
+ * @param size_of_text The number of characters of the text.
+ * @param position A pointer to the position of the next line in the text, it is moved past the line.
+ * @param line_buffer The buffer that receives the line.
+ * @param size_of_buffer The size of the buffer, at most size_of_buffer - 1 characters are read.
+ * @return 1 if a line was read, 0 at the end of the text.
+ */
+static int read_line_of_text(const char *text, size_t size_of_text, size_t *position, char *line_buffer, size_t size_of_buffer) {
+    size_t length = 0;
+
+    if (*position >= size_of_text) {
+        return 0;
+    }
+    while (*position + length < size_of_text && length < size_of_buffer - 1) {
+        if (text[*position + length++] == '\n') {
+            break;
+        }
+    }
+    memcpy(line_buffer, text + *position, length);
+    line_buffer[length] = '\0';
+    *position += length;
+    return 1;
+}
+
+/*
+ * This function prints an error of the preprocessor with formatted output.
+ * It includes the file name, line number, and the provided formatted message.
+ *
+ * @param name_of_file The name of the file where the error occurred.
+ * @param number_of_line The line number in the file where the error occurred.
+ * @param fmt The format string for the error message.
+ * @param ... Additional arguments for formatting the error message.
+ */
+static void preprocessor_error_fmt(const char * name_of_file, unsigned int number_of_line, const char * fmt,...){
+    va_list vl;
+    va_start(vl,fmt);
+    printf("%s:%u: " ANSI_COLOR_RED "error: " ANSI_COLOR_RESET, name_of_file, number_of_line);
+    vprintf(fmt,vl);
+    printf("\n");
+    va_end(vl);
+}
+
+/*
+ * Adds a piece to the expansion template of a macro.
+ *
+ * @param macro A pointer to the macro.
+ * @param offset_in_source The offset of the text of the piece in the text of the source file.
+ * @param length The number of characters of the text of the piece, 0 for a parameter.
+ * @param index_of_parameter The parameter the piece is replaced with, or -1 for text.
+ */
+static void add_macro_piece(struct macro *macro, size_t offset_in_source, size_t length, int index_of_parameter) {
+    struct macro_piece *bigger_pieces;
+
+    if (length == 0 && index_of_parameter < 0) {
+        return;
+    }
+    bigger_pieces = (struct macro_piece *)tracked_realloc(macro->pieces, (macro->amount_of_pieces + 1) * sizeof(struct macro_piece), MEMORY_MACRO_LINES);
+    if (bigger_pieces == NULL) {
+        fprintf(stderr, "Memory allocation error.\n");
+        exit(1);
+    }
+    macro->pieces = bigger_pieces;
+    macro->pieces[macro->amount_of_pieces].offset_in_source = offset_in_source;
+    macro->pieces[macro->amount_of_pieces].length = length;
+    macro->pieces[macro->amount_of_pieces].index_of_parameter = index_of_parameter;
+    macro->amount_of_pieces++;
+    if (index_of_parameter >= macro->amount_of_parameters) {
+        macro->amount_of_parameters = index_of_parameter + 1;
+    }
+}
+
+/*
+ * Splits text of the body of a macro to text pieces and parameter pieces, and adds them to the template.
+ *
+ * @param macro A pointer to the macro.
+ * @param source_text The text of the source file.
+ * @param first The offset of the first character of the text.
+ * @param end The offset right after the last character of the text.
+ */
+static void add_macro_text(struct macro *macro, const char *source_text, size_t first, size_t end) {
+    size_t position;
+
+    for (position = first; position + 1 < end; position++) {
+        /* %1 to %9 are the parameters */
+        if (source_text[position] == '%' && source_text[position + 1] >= '1' && source_text[position + 1] <= '0' + MAX_MACRO_PARAMETERS) {
+            add_macro_piece(macro, first, position - first, -1);
+            add_macro_piece(macro, position, 0, source_text[position + 1] - '1');
+            first = position + 2;
+            position++;
+        }
+    }
+    add_macro_piece(macro, first, end - first, -1);
+}
+
+/*
+ * Finds a macro by its name, in the macros of the file and then in the loaded libraries.
+ *
+ * @param table_of_macros The macros of the file, or NULL.
+ * @param name_of_macro The name of the macro.
+ * @return A pointer to the macro, or NULL if there is no macro with that name.
+ */
+static struct macro *find_macro(MacroLinkedList *table_of_macros, const char *name_of_macro) {
+    struct macro *macro = find_macro_in_linked_list(table_of_macros, name_of_macro);
+
+    return macro != NULL ? macro : find_library_macro(name_of_macro);
+}
+
+/*
+ * Compiles the body of a macro in to its expansion template.
+ *
+ * Every line of the body becomes a line of the template, made of text pieces that point in to the
+ * text of the source file and of parameter pieces. A line that starts with the name of a macro becomes
+ * a call of that macro, with the rest of the line as its arguments.
+ *
+ * @param macro A pointer to the macro, its body is complete.
+ * @param source_text The text of the source file.
+ * @param table_of_macros The macros that were defined so far.
+ */
+static void compile_macro_template(struct macro *macro, const char *source_text, MacroLinkedList *table_of_macros) {
+    char name_of_called[MAX_LENGTH_OF_MACRO + 1];
+    struct macro_template_line *line;
+    struct macro_template_line *bigger_lines;
+    size_t position = macro->offset_of_body;
+    size_t end_of_body = macro->offset_of_body + macro->length_of_body;
+    size_t first_of_line;
+    size_t end_of_line;
+    size_t first_of_name;
+    size_t end_of_name;
+    size_t index_of_line = 0;
+
+    while (position < end_of_body) {
+        bigger_lines = (struct macro_template_line *)tracked_realloc(macro->template_lines, (macro->amount_of_template_lines + 1) * sizeof(struct macro_template_line), MEMORY_MACRO_LINES);
+        if (bigger_lines == NULL) {
+            fprintf(stderr, "Memory allocation error.\n");
+            exit(1);
+        }
+        macro->template_lines = bigger_lines;
+        line = &macro->template_lines[macro->amount_of_template_lines++];
+
+        /* Find the end of the line */
+        first_of_line = position;
+        while (position < end_of_body && source_text[position] != '\n') {
+            position++;
+        }
+        end_of_line = position;
+        line->ends_line = position < end_of_body;
+        if (line->ends_line) {
+            position++;
+        }
+        line->line_in_source = line->ends_line && index_of_line < macro->amount_of_lines ? macro->lines_in_source[index_of_line++] : 0;
+        line->first_piece = macro->amount_of_pieces;
+
+        /* Check if the first word of the line is the name of a macro */
+        first_of_name = first_of_line;
+        while (first_of_name < end_of_line && isspace((unsigned char)source_text[first_of_name])) {
+            first_of_name++;
+        }
+        end_of_name = first_of_name;
+        while (end_of_name < end_of_line && !isspace((unsigned char)source_text[end_of_name])) {
+            end_of_name++;
+        }
+        name_of_called[0] = '\0';
+        if (end_of_name - first_of_name <= MAX_LENGTH_OF_MACRO) {
+            memcpy(name_of_called, source_text + first_of_name, end_of_name - first_of_name);
+            name_of_called[end_of_name - first_of_name] = '\0';
+        }
+        line->called_macro = name_of_called[0] != '\0' ? find_macro(table_of_macros, name_of_called) : NULL;
+        if (line->called_macro) {
+            /* The rest of the line are the arguments of the call */
+            add_macro_text(macro, source_text, end_of_name, end_of_line);
+        } else {
+            /* The whole line is written, with its new line */
+            add_macro_text(macro, source_text, first_of_line, position);
+        }
+        line->amount_of_pieces = macro->amount_of_pieces - line->first_piece;
+    }
+}
+
+/* Represents the output of the preprocessor, the am file and the lines that are sent to the pipeline */
+struct am_output {
+    FILE *am_file; /* The am file, or NULL if the lines are kept in memory */
+    char *text_of_lines; /* The lines that are kept in memory, when there is no am file */
+    size_t length_of_text; /* The number of characters of the lines that are kept in memory */
+    size_t capacity_of_text; /* The number of characters there is room for */
+    struct line_ring *expanded_lines; /* The ring the lines are sent to, NULL if the file is not pipelined */
+    char *line; /* The text of the line of the am file that wasn't sent yet */
+    size_t length_of_line; /* The number of characters of the line */
+    size_t capacity_of_line; /* The number of characters the line has room for */
+};
+
+/*
+ * Sends the current line of the am file to the pipeline, in the pieces the compilation reads it in.
+ *
+ * @param output A pointer to the output of the preprocessor.
+ * @param origin A pointer to the origin of the line, or NULL if it has none.
+ */
+static void send_am_line(struct am_output *output, const struct line_origin *origin) {
+    struct expanded_line *expanded;
+    size_t position = 0;
+    size_t length;
+
+    while (position < output->length_of_line && output->expanded_lines != NULL) {
+        expanded = (struct expanded_line *)begin_push_to_ring(output->expanded_lines);
+        if (expanded == NULL) {
+            /* Nobody reads the lines anymore */
+            output->expanded_lines = NULL;
+            break;
+        }
+        /* The same pieces that fgets reads from the am file */
+        for (length = 0; position + length < output->length_of_line && length < MAX_LENGTH_OF_LINE; ) {
+            if (output->line[position + length++] == '\n') {
+                break;
+            }
+        }
+        memcpy(expanded->text, output->line + position, length);
+        expanded->text[length] = '\0';
+        /* The first piece brings the origin, so it is known before any piece of the line is compiled */
+        expanded->has_origin = position == 0 && origin != NULL;
+        if (expanded->has_origin) {
+            expanded->origin = *origin;
+        }
+        position += length;
+        end_push_to_ring(output->expanded_lines);
+    }
+    output->length_of_line = 0;
+}
+
+/*
+ * Writes text to the am file, and keeps it for the pipeline until its line ends.
+ *
+ * @param output A pointer to the output of the preprocessor.
+ * @param text The text, it doesn't have a new line before its end.
+ * @param length The number of characters of the text.
+ */
+static void write_am_text(struct am_output *output, const char *text, size_t length) {
+    char *bigger_line;
+
+    if (output->am_file != NULL) {
+        fwrite(text, 1, length, output->am_file);
+    } else {
+        if (output->length_of_text + length + 1 > output->capacity_of_text) {
+            output->capacity_of_text = (output->length_of_text + length + 1) * 2;
+            bigger_line = (char *)tracked_realloc(output->text_of_lines, output->capacity_of_text, MEMORY_SOURCES);
+            if (bigger_line == NULL) {
+                fprintf(stderr, "Memory allocation error.\n");
+                exit(1);
+            }
+            output->text_of_lines = bigger_line;
+        }
+        memcpy(output->text_of_lines + output->length_of_text, text, length);
+        output->length_of_text += length;
+        output->text_of_lines[output->length_of_text] = '\0';
+    }
+    if (output->expanded_lines == NULL) {
+        return;
+    }
+    /* A line that ended without an origin is sent before the next one starts */
+    if (output->length_of_line > 0 && output->line[output->length_of_line - 1] == '\n') {
+        send_am_line(output, NULL);
+    }
+    if (output->length_of_line + length > output->capacity_of_line) {
+        output->capacity_of_line = (output->length_of_line + length) * 2;
+        bigger_line = (char *)tracked_realloc(output->line, output->capacity_of_line, MEMORY_SOURCES);
+        if (bigger_line == NULL) {
+            fprintf(stderr, "Memory allocation error.\n");
+            exit(1);
+        }
+        output->line = bigger_line;
+    }
+    memcpy(output->line + output->length_of_line, text, length);
+    output->length_of_line += length;
+}
+
+/*
+ * Adds the origin of the line of the am file that was just written, if the source map is needed, and sends the line to the pipeline.
+ *
+ * @param output A pointer to the output of the preprocessor.
+ * @param origins_of_lines A pointer to the table of the origins of the lines.
+ * @param line_in_source The line of the source file the line was written from.
+ * @param name_of_macro The macro the line was expanded from, or NULL.
+ * @param line_of_calling The line of the macro call, 0 if the line is not from a macro.
+ */
+static void end_am_line(struct am_output *output, struct line_origin_table *origins_of_lines, unsigned int line_in_source, const char *name_of_macro, unsigned int line_of_calling) {
+    /* The origins are only kept for the source map */
+    if (!source_map_is_needed()) {
+        if (output->expanded_lines != NULL) {
+            send_am_line(output, NULL);
+        }
+        return;
+    }
+    add_line_origin(origins_of_lines, line_in_source, name_of_macro, line_of_calling);
+    if (output->expanded_lines != NULL && origins_of_lines->amount_of_lines > 0) {
+        send_am_line(output, &origins_of_lines->origins[origins_of_lines->amount_of_lines - 1]);
+    }
+}
+
+/* Represents a macro call that is expanded in to the am file */
+struct macro_expansion {
+    struct am_output *output; /* The output the lines are written to */
+    struct line_origin_table *origins_of_lines; /* The origins of the lines of the am file */
+    const char *name_of_file; /* The name of the source file, for errors */
+    unsigned int line_of_calling; /* The line of the source file the macro was called in */
+    size_t lines_written; /* The number of lines the call has written */
+    int error; /* Set if the expansion of the current call failed */
+};
+
+/*
+ * Splits the arguments of a macro call, which are separated by commas.
+ *
+ * A comma inside quotation marks belongs to a string argument, so it doesn't split it.
+ *
+ * @param text The arguments as they were written in the call.
+ * @param arguments The array that receives the arguments, without the spaces around them.
+ * @return The number of arguments, or -1 if there are more than MAX_MACRO_PARAMETERS.
+ */
+static int split_macro_arguments(const char *text, char arguments[][MAX_LENGTH_OF_LINE + 1]) {
+    int amount_of_arguments = 0;
+    const char *end;
+    size_t length;
+    int in_string;
+
+    SKIP_SPACE(text);
+    if (*text == '\0') {
+        return 0;
+    }
+    for (;;) {
+        if (amount_of_arguments == MAX_MACRO_PARAMETERS) {
+            return -1;
+        }
+        SKIP_SPACE(text);
+        for (end = text, in_string = 0; *end != '\0' && (in_string || *end != ','); end++) {
+            if (*end == '"') {
+                in_string = !in_string;
+            }
+        }
+        length = (size_t)(end - text);
+        /* Remove the spaces at the end of the argument */
+        while (length > 0 && isspace((unsigned char)text[length - 1])) {
+            length--;
+        }
+        if (length > MAX_LENGTH_OF_LINE) {
+            length = MAX_LENGTH_OF_LINE;
+        }
+        memcpy(arguments[amount_of_arguments], text, length);
+        arguments[amount_of_arguments++][length] = '\0';
+        if (*end != ',') {
+            return amount_of_arguments;
+        }
+        text = end + 1;
+    }
+}
+
+/*
+ * Expands a macro in to the am file, with its nested macro calls.
+ *
+ * @param expansion A pointer to the call that is expanded.
+ * @param macro A pointer to the macro.
+ * @param arguments The arguments of the macro.
+ * @param amount_of_arguments The number of arguments.
+ * @param depth The number of macros the macro is nested in, 0 for a macro that is called from the source file.
+ */
+static void expand_macro(struct macro_expansion *expansion, struct macro *macro, char arguments[][MAX_LENGTH_OF_LINE + 1], int amount_of_arguments, int depth) {
+    char arguments_of_call[MAX_MACRO_PARAMETERS][MAX_LENGTH_OF_LINE + 1];
+    char text_of_call[MAX_LENGTH_OF_LINE + 1];
+    const struct macro_template_line *line;
+    const struct macro_piece *piece;
+    size_t length_of_call;
+    size_t length;
+    size_t i;
+    size_t j;
+    int amount_of_call_arguments;
+
+    if (depth > MAX_DEPTH_OF_MACROS) {
+        preprocessor_error_fmt(expansion->name_of_file, expansion->line_of_calling, "the macro '%s' is nested in more than %d macros.", macro->name_of_macro, MAX_DEPTH_OF_MACROS);
+        expansion->error = 1;
+        return;
+    }
+    if (amount_of_arguments != macro->amount_of_parameters) {
+        preprocessor_error_fmt(expansion->name_of_file, expansion->line_of_calling, "the macro '%s' takes %d arguments but was called with %d.", macro->name_of_macro, macro->amount_of_parameters, amount_of_arguments);
+        expansion->error = 1;
+        return;
+    }
+    macro->amount_of_expansions++;
+
+    for (i = 0; i < macro->amount_of_template_lines && !expansion->error; i++) {
+        line = &macro->template_lines[i];
+        if (line->called_macro) {
+            /* Put the arguments of the nested call together and split them */
+            length_of_call = 0;
+            for (j = 0; j < line->amount_of_pieces; j++) {
+                piece = &macro->pieces[line->first_piece + j];
+                if (piece->index_of_parameter >= 0) {
+                    length = strlen(arguments[piece->index_of_parameter]);
+                    if (length > MAX_LENGTH_OF_LINE - length_of_call) {
+                        length = MAX_LENGTH_OF_LINE - length_of_call;
+                    }
+                    memcpy(text_of_call + length_of_call, arguments[piece->index_of_parameter], length);
+                } else {
+                    length = piece->length;
+                    if (length > MAX_LENGTH_OF_LINE - length_of_call) {
+                        length = MAX_LENGTH_OF_LINE - length_of_call;
+                    }
+                    memcpy(text_of_call + length_of_call, macro->source_text + piece->offset_in_source, length);
+                }
+                length_of_call += length;
+            }
+            text_of_call[length_of_call] = '\0';
+            amount_of_call_arguments = split_macro_arguments(text_of_call, arguments_of_call);
+            if (amount_of_call_arguments < 0) {
+                preprocessor_error_fmt(expansion->name_of_file, expansion->line_of_calling, "the macro '%s' is called with more than %d arguments.", line->called_macro->name_of_macro, MAX_MACRO_PARAMETERS);
+                expansion->error = 1;
+                return;
+            }
+            expand_macro(expansion, line->called_macro, arguments_of_call, amount_of_call_arguments, depth + 1);
+            continue;
+        }
+        if (line->ends_line && ++expansion->lines_written > MAX_LINES_OF_EXPANSION) {
+            preprocessor_error_fmt(expansion->name_of_file, expansion->line_of_calling, "the call of a macro is expanded to more than %d lines.", MAX_LINES_OF_EXPANSION);
+            expansion->error = 1;
+            return;
+        }
+        /* Splice the text and the arguments of the line */
+        for (j = 0; j < line->amount_of_pieces; j++) {
+            piece = &macro->pieces[line->first_piece + j];
+            if (piece->index_of_parameter >= 0) {
+                write_am_text(expansion->output, arguments[piece->index_of_parameter], strlen(arguments[piece->index_of_parameter]));
+            } else {
+                write_am_text(expansion->output, macro->source_text + piece->offset_in_source, piece->length);
+            }
+        }
+        /* A line of the am file has an origin once its end is written */
+        if (line->ends_line) {
+            end_am_line(expansion->output, expansion->origins_of_lines, line->line_in_source, macro->name_of_macro, expansion->line_of_calling);
+        }
+    }
+}
+
+/* Represents a source file while the preprocessor reads it */
+struct preprocessor_source {
+    const char *name_of_file; /* The name of the source file, for errors and for the directory of its includes */
+    char *source_text; /* The text of the source file, the bodies of its macros are kept in it */
+    size_t size_of_source; /* The number of characters of the text */
+    MacroLinkedList *table_of_macros; /* The macros that were defined or included so far */
+    StringLinkedList *table_with_names_of_macros; /* The names of the macros that were defined or included so far */
+    char *name_of_macro; /* The name of the last macro, calls are recognized once it is set */
+    int depth_of_include; /* The number of files that include the file, 0 for a file that was given to the assembler */
+    struct included_file **dependencies; /* The included files the file includes directly */
+    size_t amount_of_dependencies; /* The number of included files */
+};
+
+/* Represents an included file after it was preprocessed, it is kept for every file that includes it */
+struct included_file {
+    char *path; /* The path of the file */
+    time_t modification_time; /* The modification time of the file when it was preprocessed */
+    long modification_nanoseconds; /* The nanoseconds of the modification time, a file can change twice in a second in --watch */
+    off_t size_of_file; /* The size of the file when it was preprocessed */
+    char *source_text; /* The text of the file, the templates of its macros point in to it */
+    MacroLinkedList *table_of_macros; /* The macros of the file, with the macros it included */
+    char *expanded_text; /* The lines of the file after the macros were expanded */
+    size_t length_of_expanded_text; /* The number of characters of the lines */
+    struct included_file **dependencies; /* The included files the file includes directly */
+    size_t amount_of_dependencies; /* The number of included files */
+    int has_errors; /* Set if the file couldn't be preprocessed */
+    int is_being_preprocessed; /* Set while the file is preprocessed, to find files that include themselves */
+    int is_outdated; /* Set if the file changed after it was preprocessed, it is only kept for the files that point to it */
+    struct included_file *next; /* The next included file */
+};
+
+/* The files that were included, they are preprocessed once for all the files that include them */
+static struct included_file *included_files = NULL;
+
+static int preprocess_source(struct preprocessor_source *source, struct am_output *output, struct line_origin_table *origins_of_lines);
+
+/*
+ * Checks if a line is an .include directive and takes the path out of it.
+ *
+ * @param line The line, after the comment was removed.
+ * @param path The buffer that receives the path, it has room for MAX_LENGTH_OF_LINE characters.
+ * @return 1 if the line is an .include directive with a path, -1 if it is an .include directive without one, 0 otherwise.
+ */
+static int parse_include_line(const char *line, char *path) {
+    const char *end_of_path;
+
+    SKIP_SPACE(line);
+    if (strncmp(line, ".include", strlen(".include")) != 0 || !isspace((unsigned char)line[strlen(".include")])) {
+        return 0;
+    }
+    line += strlen(".include");
+    SKIP_SPACE(line);
+    if (*line != '"') {
+        return -1;
+    }
+    line++;
+    end_of_path = strchr(line, '"');
+    if (end_of_path == NULL || end_of_path == line) {
+        return -1;
+    }
+    memcpy(path, line, end_of_path - line);
+    path[end_of_path - line] = '\0';
+    /* Nothing but spaces can come after the path */
+    end_of_path++;
+    SKIP_SPACE(end_of_path);
+    return *end_of_path == '\0' ? 1 : -1;
+}
+
+/*
+ * Finds the file an .include directive names.
+ *
+ * A relative path is searched in the directory of the including file first, and then in the include directories in their order.
+ *
+ * @param path The path that was given in the directive.
+ * @param name_of_including_file The name of the file with the directive.
+ * @param status A pointer that receives the status of the file that was found.
+ * @return The path of the file that was found, dynamically allocated, or NULL if there is none.
+ */
+static char *find_included_file(const char *path, const char *name_of_including_file, struct stat *status) {
+    char *copy_of_name;
+    char *candidate;
+    const char *directory;
+    int i;
+
+    if (path[0] == '/') {
+        return stat(path, status) == 0 && S_ISREG(status->st_mode) ? tracked_strdup(path, MEMORY_FILE_NAMES) : NULL;
+    }
+    for (i = -1; i < options_of_assembler.amount_of_include_directories; i++) {
+        copy_of_name = tracked_strdup(name_of_including_file, MEMORY_FILE_NAMES);
+        if (copy_of_name == NULL) {
+            return NULL;
+        }
+        directory = i < 0 ? dirname(copy_of_name) : options_of_assembler.include_directories[i];
+        candidate = (char *)tracked_malloc(strlen(directory) + strlen(path) + 2, MEMORY_FILE_NAMES);
+        if (candidate == NULL) {
+            tracked_free(copy_of_name);
+            return NULL;
+        }
+        sprintf(candidate, "%s/%s", directory, path);
+        tracked_free(copy_of_name);
+        if (stat(candidate, status) == 0 && S_ISREG(status->st_mode)) {
+            return candidate;
+        }
+        tracked_free(candidate);
+    }
+    return NULL;
+}
+
+/*
+ * Checks if an included file and the files it includes didn't change since they were preprocessed.
+ *
+ * @param included A pointer to the included file.
+ * @return 1 if the preprocessed file can be used, 0 if it has to be preprocessed again.
+ */
+static int included_file_is_current(struct included_file *included) {
+    struct stat status;
+    size_t i;
+
+    if (included->is_outdated || stat(included->path, &status) != 0 ||
+        status.st_mtime != included->modification_time || status.st_mtim.tv_nsec != included->modification_nanoseconds ||
+        status.st_size != included->size_of_file) {
+        included->is_outdated = 1;
+        return 0;
+    }
+    for (i = 0; i < included->amount_of_dependencies; i++) {
+        if (!included_file_is_current(included->dependencies[i])) {
+            included->is_outdated = 1;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Preprocesses an included file in to memory and adds it to the included files.
+ *
+ * The file is preprocessed on its own, the macros of the including file are not known in it.
+ *
+ * @param path The path of the file.
+ * @param status A pointer to the status of the file.
+ * @param depth_of_include The number of files that include the file.
+ * @return A pointer to the included file, or NULL if it couldn't be read.
+ */
+static struct included_file *preprocess_included_file(const char *path, const struct stat *status, int depth_of_include) {
+    struct included_file *included;
+    struct preprocessor_source source = {0};
+    struct am_output output = {0};
+    struct line_origin_table origins_of_lines = {0};
+    FILE *file;
+
+    file = fopen(path, "r");
+    if (file == NULL) {
+        return NULL;
+    }
+    included = (struct included_file *)tracked_calloc(1, sizeof(struct included_file), MEMORY_SOURCES);
+    if (included == NULL || (included->path = tracked_strdup(path, MEMORY_FILE_NAMES)) == NULL ||
+        (included->source_text = read_whole_file(file, &source.size_of_source)) == NULL) {
+        fprintf(stderr, "Memory allocation error.\n");
+        exit(1);
+    }
+    fclose(file);
+    included->modification_time = status->st_mtime;
+    included->modification_nanoseconds = status->st_mtim.tv_nsec;
+    included->size_of_file = status->st_size;
+    included->is_being_preprocessed = 1;
+    included->next = included_files;
+    included_files = included;
+
+    source.name_of_file = included->path;
+    source.source_text = included->source_text;
+    source.depth_of_include = depth_of_include;
+    included->has_errors = !preprocess_source(&source, &output, &origins_of_lines);
+    included->is_being_preprocessed = 0;
+    included->table_of_macros = source.table_of_macros;
+    included->dependencies = source.dependencies;
+    included->amount_of_dependencies = source.amount_of_dependencies;
+    included->expanded_text = output.text_of_lines;
+    included->length_of_expanded_text = output.length_of_text;
+    free_string_linked_list(&source.table_with_names_of_macros);
+    free_line_origin_table(&origins_of_lines);
+    return included;
+}
+
+/*
+ * Includes a file in to the file that is preprocessed.
+ *
+ * The included file is preprocessed once, and every file that includes it after that gets its lines and
+ * its macros from memory, as long as it and the files it includes didn't change. The lines are written
+ * with the line of the .include directive as their origin.
+ *
+ * @param source A pointer to the file that is preprocessed.
+ * @param output A pointer to the output of the preprocessor.
+ * @param origins_of_lines A pointer to the table of the origins of the lines.
+ * @param path The path that was given in the directive.
+ * @param number_of_the_line The line of the directive.
+ * @return 1 if the file was included, 0 on error.
+ */
+static int include_file(struct preprocessor_source *source, struct am_output *output, struct line_origin_table *origins_of_lines,
+                        const char *path, unsigned int number_of_the_line) {
+    struct included_file *included;
+    struct included_file **bigger_dependencies;
+    struct macro_node *current_macro;
+    struct macro copy_of_macro;
+    NodeMacro *node_of_copy;
+    struct stat status;
+    char *path_of_file;
+    size_t position;
+    size_t length;
+
+    if (source->depth_of_include >= MAX_DEPTH_OF_INCLUDES) {
+        preprocessor_error_fmt(source->name_of_file, number_of_the_line, "the file '%s' is included in more than %d files.", path, MAX_DEPTH_OF_INCLUDES);
+        return 0;
+    }
+    path_of_file = find_included_file(path, source->name_of_file, &status);
+    if (path_of_file == NULL) {
+        preprocessor_error_fmt(source->name_of_file, number_of_the_line, "the included file '%s' was not found.", path);
+        return 0;
+    }
+    for (included = included_files; included != NULL; included = included->next) {
+        if (!included->is_outdated && strcmp(included->path, path_of_file) == 0) {
+            break;
+        }
+    }
+    if (included != NULL && included->is_being_preprocessed) {
+        preprocessor_error_fmt(source->name_of_file, number_of_the_line, "the file '%s' includes itself.", path);
+        tracked_free(path_of_file);
+        return 0;
+    }
+    if (included == NULL || !included_file_is_current(included)) {
+        included = preprocess_included_file(path_of_file, &status, source->depth_of_include + 1);
+    }
+    tracked_free(path_of_file);
+    if (included == NULL) {
+        preprocessor_error_fmt(source->name_of_file, number_of_the_line, "the included file '%s' couldn't be opened.", path);
+        return 0;
+    }
+    if (included->has_errors) {
+        preprocessor_error_fmt(source->name_of_file, number_of_the_line, "the included file '%s' has errors.", path);
+        return 0;
+    }
+    bigger_dependencies = (struct included_file **)tracked_realloc(source->dependencies, (source->amount_of_dependencies + 1) * sizeof(struct included_file *), MEMORY_SOURCES);
+    if (bigger_dependencies == NULL) {
+        fprintf(stderr, "Memory allocation error.\n");
+        exit(1);
+    }
+    source->dependencies = bigger_dependencies;
+    source->dependencies[source->amount_of_dependencies++] = included;
+
+    /* The macros of the included file can be called, a macro that is already known keeps its first definition */
+    for (current_macro = included->table_of_macros ? included->table_of_macros->head : NULL; current_macro; current_macro = current_macro->next) {
+        if (find_macro_in_linked_list(source->table_of_macros, current_macro->data->name_of_macro) != NULL) {
+            continue;
+        }
+        copy_of_macro = *current_macro->data;
+        copy_of_macro.is_included = 1;
+        copy_of_macro.amount_of_expansions = 0;
+        node_of_copy = insert_macro_to_linked_list(&source->table_of_macros, &copy_of_macro);
+        if (node_of_copy == NULL) {
+            fprintf(stderr, "Memory allocation error.\n");
+            exit(1);
+        }
+        insert_string_to_linked_list(&source->table_with_names_of_macros, node_of_copy->data->name_of_macro);
+        source->name_of_macro = node_of_copy->data->name_of_macro;
+    }
+
+    /* Write the lines of the included file, every one of them comes from the line of the directive */
+    for (position = 0; position < included->length_of_expanded_text; position += length) {
+        length = strcspn(included->expanded_text + position, "\n");
+        if (position + length < included->length_of_expanded_text) {
+            length++;
+        }
+        write_am_text(output, included->expanded_text + position, length);
+        /* The last line of the file ends before the next line of the including file */
+        if (included->expanded_text[position + length - 1] != '\n') {
+            write_am_text(output, "\n", 1);
+        }
+        end_am_line(output, origins_of_lines, number_of_the_line, NULL, 0);
+    }
+    return 1;
+}
+
+/*
+ * Adds the included files, and the files they include, to the dependencies of a module.
+ *
+ * @param dependencies A pointer to the dependencies of the module.
+ * @param included The included files.
+ * @param amount_of_included The number of included files.
+ */
+static void add_included_dependencies(struct source_dependencies *dependencies, struct included_file **included, size_t amount_of_included) {
+    size_t i;
+
+    for (i = 0; i < amount_of_included; i++) {
+        /* A file that is already a dependency already brought the files it includes */
+        if (add_source_dependency(dependencies, included[i]->path)) {
+            add_included_dependencies(dependencies, included[i]->dependencies, included[i]->amount_of_dependencies);
+        }
+    }
+}
+
+/*
+ * Frees the memory of the files that were included.
+ *
+ * Every included file is preprocessed once and kept in memory for all the files that include it.
+ */
+void free_included_files(void) {
+    struct included_file *included;
+
+    while (included_files != NULL) {
+        included = included_files;
+        included_files = included->next;
+        tracked_free(included->path);
+        tracked_free(included->source_text);
+        free_macro_linked_list(&included->table_of_macros);
+        tracked_free(included->expanded_text);
+        tracked_free(included->dependencies);
+        tracked_free(included);
+    }
+}
+
+/*
+ * Preprocesses the text of a source file in to the output of the preprocessor.
+ *
+ * The preprocessor recognizes macros, expands macros when called, includes the files of .include directives
+ * and handles various preprocessor line types. The lines of the body of every macro are moved back over
+ * the definition as they are cleaned, and the body is kept as a template of pieces, spans of that text and
+ * parameters. A call is expanded by writing each span of text and each argument in turn, and the calls
+ * in the body are expanded in their place.
+ * The origin of every line that is written is added to the table of line origins, if the source map is needed.
+ *
+ * @param source A pointer to the source file, its tables of macros receive the macros it defines and includes.
+ * @param output A pointer to the output of the preprocessor.
+ * @param origins_of_lines A pointer to the table that receives the origins of the lines.
+ * @return 1 if the file was preprocessed, 0 if a macro couldn't be expanded or a file couldn't be included.
  */
-const char * file_preprocessor(char * name_of_file) {
+static int preprocess_source(struct preprocessor_source *source, struct am_output *output, struct line_origin_table *origins_of_lines) {
     char line_buffer[MAX_LENGTH_OF_LINE + 1] = {0};
+    char path_of_include[MAX_LENGTH_OF_LINE + 1];
     enum preprocessor_line_recognition pre_line_rec;
-    char* as_name_of_file;
-    char* am_name_of_file;
-    FILE* as_file;
-    FILE* am_file;
     int i = 0;
+    /* The line of the source file that is processed */
+    unsigned int number_of_the_line = 1;
+    /* Set if the line that was read is the end of a line in the source file */
+    int end_of_line;
     
-    struct macro_node *current_macro;
+    struct macro *macro_to_expand;
+    struct macro *new_macro;
+    unsigned int *bigger_lines_in_source;
 
     int in_macro = 0;
 
-    struct macro *macro;
+    struct macro *macro = NULL;
 
-    StringLinkedList *table_with_names_of_macros = NULL;
-    MacroLinkedList *table_of_macros = NULL;
     char cleaned_macro_name[MAX_LENGTH_OF_MACRO] = {0}; 
 
     const char *ptr;
-    char * name_of_macro = NULL;
-    StringNode *line_node;
-    
-    /* Prepare the file names */
-    as_name_of_file = prepare_filename(name_of_file, file_extension_as);
-    am_name_of_file = prepare_filename(name_of_file, file_extension_am);
-    
-    /* Open input and output files */
-    as_file = open_file(as_name_of_file, "r");
-    am_file = open_file(am_name_of_file, "w");
+    size_t length_of_line;
+    /* The arguments of a macro call, and the expansion of the call */
+    char arguments[MAX_MACRO_PARAMETERS][MAX_LENGTH_OF_LINE + 1];
+    int amount_of_arguments;
+    struct macro_expansion expansion = {0};
+    /* The position of the next line in the text of the source file */
+    size_t position_in_source = 0;
+    /* Set if a file couldn't be included */
+    int include_failed = 0;
+    /* Set if a macro call couldn't be expanded, every call starts without the error of the calls before it */
+    int expansion_failed = 0;
 
-    if (as_file == NULL || am_file == NULL) {
-        if (as_file) fclose(as_file);
-        if (am_file) fclose(am_file);
-        free(as_name_of_file);
-        free(am_name_of_file);
-        return NULL;
-    }
+    expansion.output = output;
+    expansion.origins_of_lines = origins_of_lines;
+    expansion.name_of_file = source->name_of_file;
     
-    /* Process every line of the input .as file */
-    while (fgets(line_buffer, MAX_LENGTH_OF_LINE, as_file)) { 
-        pre_line_rec = recegnize_a_line(line_buffer, in_macro, table_of_macros, &name_of_macro, table_with_names_of_macros);
+    /* Process every line of the source file */
+    while (read_line_of_text(source->source_text, source->size_of_source, &position_in_source, line_buffer, MAX_LENGTH_OF_LINE)) { 
+        end_of_line = strchr(line_buffer, '\n') != NULL;
+        pre_line_rec = recegnize_a_line(line_buffer, in_macro, source->table_of_macros, &source->name_of_macro, source->table_with_names_of_macros);
 
         switch (pre_line_rec) {
             case empty_line:
@@ -337,27 +1129,48 @@ const char * file_preprocessor(char * name_of_file) {
 
             case definition_of_a_macro:
                 /* Create and manage macro definitions */
-                macro = create_macro(name_of_macro);
-                if (macro == NULL){
+                new_macro = create_macro(source->name_of_macro);
+                if (new_macro == NULL){
                     fprintf(stderr, "Memory allocation error.\n");
 
-                    return NULL;
+                    return 0;
                 }
+                new_macro->source_text = source->source_text;
 
-                insert_macro_to_linked_list(&table_of_macros, macro);
-                insert_string_to_linked_list(&table_with_names_of_macros, name_of_macro);
+                /* The list keeps a copy of the macro, the lines are added to that copy */
+                macro = insert_macro_to_linked_list(&source->table_of_macros, new_macro)->data;
+                tracked_free(new_macro);
+                /* The body starts right after the line of the definition */
+                macro->offset_of_body = position_in_source;
+                insert_string_to_linked_list(&source->table_with_names_of_macros, source->name_of_macro);
+                /* The name was found in the line buffer, the copy in the macro outlives it */
+                source->name_of_macro = macro->name_of_macro;
                 in_macro = 1;
 
                 break;
 
             case line_in_the_macro:
-                /* Collect lines that are in a macro */
-                insert_string_to_linked_list(&(macro->lines_of_code), my_implementation_for_strdup(line_buffer));
+                /* The cleaned line is never longer than the line that was read, so it is moved back to the end of the body */
+                length_of_line = strlen(line_buffer);
+                memmove(source->source_text + macro->offset_of_body + macro->length_of_body, line_buffer, length_of_line);
+                macro->length_of_body += length_of_line;
+                if (strchr(line_buffer, '\n') == NULL) {
+                    break;
+                }
+                /* Remember the line of the source file the line of code was defined in */
+                bigger_lines_in_source = (unsigned int *)tracked_realloc(macro->lines_in_source, (macro->amount_of_lines + 1) * sizeof(unsigned int), MEMORY_MACRO_LINES);
+                if (bigger_lines_in_source == NULL) {
+                    fprintf(stderr, "Memory allocation error.\n");
+                    exit(1);
+                }
+                macro->lines_in_source = bigger_lines_in_source;
+                macro->lines_in_source[macro->amount_of_lines++] = number_of_the_line;
                 
                 break;
 
             case end_of_macro:
-                /* End of a macro definition */
+                /* End of a macro definition, its body is compiled once */
+                compile_macro_template(macro, source->source_text, source->table_of_macros);
                 in_macro = 0;
                 
                 macro = NULL;
@@ -380,24 +1193,45 @@ const char * file_preprocessor(char * name_of_file) {
                 }
                 cleaned_macro_name[i] = '\0';  
 
+                /* The rest of the line are the arguments */
+                amount_of_arguments = split_macro_arguments(ptr, arguments);
+                if (amount_of_arguments < 0) {
+                    preprocessor_error_fmt(source->name_of_file, number_of_the_line, "the macro '%s' is called with more than %d arguments.", cleaned_macro_name, MAX_MACRO_PARAMETERS);
+                    expansion_failed = 1;
+                    break;
+                }
+
                 /* Find and expand the macro */
-                current_macro = table_of_macros->head;
-                while (current_macro) {
-                    if (strcmp(((struct macro *)(current_macro->data))->name_of_macro, cleaned_macro_name) == 0) {
-                        line_node = ((struct macro *)(current_macro->data))->lines_of_code->head;
-                        while (line_node) {
-                            fputs(line_node->data, am_file);
-                            line_node = (StringNode *)line_node->next;
-                        }
-                        break; 
-                    }
-                    current_macro = (struct macro_node *)current_macro->next;
+                macro_to_expand = find_macro(source->table_of_macros, cleaned_macro_name);
+                if (macro_to_expand != NULL) {
+                    expansion.line_of_calling = number_of_the_line;
+                    expansion.lines_written = 0;
+                    expansion.error = 0;
+                    expand_macro(&expansion, macro_to_expand, arguments, amount_of_arguments, 0);
+                    expansion_failed |= expansion.error;
                 }
             }
             break;
             case line_with_none_of_the_above:
-
-                    fputs(line_buffer, am_file);
+                    /* An .include directive is replaced by the lines of the file */
+                    switch (parse_include_line(line_buffer, path_of_include)) {
+                        case 1:
+                            if (!include_file(source, output, origins_of_lines, path_of_include, number_of_the_line)) {
+                                include_failed = 1;
+                            }
+                            break;
+                        case -1:
+                            preprocessor_error_fmt(source->name_of_file, number_of_the_line, "the .include directive needs a path in quotation marks.");
+                            include_failed = 1;
+                            break;
+                        default:
+                            write_am_text(output, line_buffer, strlen(line_buffer));
+                            /* A line of the am file has an origin once its end is written, or the file ends */
+                            if (strchr(line_buffer, '\n') != NULL || position_in_source >= source->size_of_source) {
+                                end_am_line(output, origins_of_lines, number_of_the_line, NULL, 0);
+                            }
+                            break;
+                    }
 
                 break;
 
@@ -405,18 +1239,183 @@ const char * file_preprocessor(char * name_of_file) {
     
                 break;
         }
+        if (end_of_line) {
+            number_of_the_line++;
+        }
     }
 
-    /* Close files and clean memory */
-    fclose(as_file);
-    fclose(am_file);
-    free(as_name_of_file);
-    free_macro_linked_list(&table_of_macros);
-    free_string_linked_list(&table_with_names_of_macros); 
-    free(macro);
+    /* A macro that is not ended takes the rest of the file */
+    if (in_macro) {
+        compile_macro_template(macro, source->source_text, source->table_of_macros);
+    }
+    return !expansion_failed && !include_failed;
+}
+
+/*
+ * This function reads the content of the source assembly file, processes each line
+ * and writes the modified lines to an output am file.
+ * The preprocessor recognizes macros, expands macros when called, includes the files of .include
+ * directives and handles various preprocessor line types.
+ *
+ * The source file is read in to memory once. The lines of the body of every macro are moved back over
+ * the definition as they are cleaned, and the body is kept as a template of spans of that text and
+ * parameters. A call is expanded by writing the spans with the arguments spliced in between them,
+ * and the calls in the body are expanded in their place.
+ * The origin of every line that is written to the am file is added to the table of line origins, if the source map is needed.
+ *
+ * @param name_of_file The name of the source assembly file to be preprocessed.
+ * @param origins_of_lines A pointer to the table that receives the origins of the lines of the am file.
+ * @param expanded_lines The ring the lines of the am file are also sent to, with their origins, or NULL.
+ * @param preloaded The source file that was read ahead of time and its am file, or NULL to open both here. The preprocessor owns them.
+ * @param dependencies A pointer that receives the source file and the files it included, or NULL.
+ * @return A pointer to the name of the generated modified assembly file, or NULL on error.
+ */
+const char * file_preprocessor(char * name_of_file, struct line_origin_table *origins_of_lines, struct line_ring *expanded_lines, struct preloaded_source *preloaded,
+                               struct source_dependencies *dependencies) {
+    char* as_name_of_file;
+    char* am_name_of_file;
+    FILE* as_file = NULL;
+    FILE* am_file = NULL;
+    struct macro_node *current_macro;
+    /* The am file and the lines that are sent to the pipeline */
+    struct am_output output = {0};
+    /* The text of the source file and its macros */
+    struct preprocessor_source source = {0};
+    int preprocessed;
     
+    /* Prepare the file names */
+    as_name_of_file = prepare_filename(name_of_file, file_extension_as);
+    am_name_of_file = create_output_file_name(name_of_file, file_extension_am);
     
+    /* Open input and output files, unless they were opened ahead of time */
+    if (preloaded != NULL) {
+        source.source_text = preloaded->source_text;
+        source.size_of_source = preloaded->size_of_source;
+        am_file = preloaded->am_file;
+        if (!preloaded->source_was_opened) {
+            fprintf(stderr, "Unable to open file: %s\n", as_name_of_file);
+        }
+        if (!preloaded->am_file_was_opened) {
+            am_file = open_file(am_name_of_file, "w");
+        } else if (am_file == NULL) {
+            fprintf(stderr, "Unable to open file: %s\n", am_name_of_file);
+        }
+        if (!preloaded->source_was_opened || am_file == NULL) {
+            tracked_free(source.source_text);
+            if (am_file) fclose(am_file);
+            tracked_free(as_name_of_file);
+            tracked_free(am_name_of_file);
+            memset(preloaded, 0, sizeof(struct preloaded_source));
+            return NULL;
+        }
+        /* The preprocessor owns the text and the am file now */
+        memset(preloaded, 0, sizeof(struct preloaded_source));
+    } else {
+        as_file = open_file(as_name_of_file, "r");
+        am_file = open_file(am_name_of_file, "w");
+
+        if (as_file == NULL || am_file == NULL) {
+            if (as_file) fclose(as_file);
+            if (am_file) fclose(am_file);
+            tracked_free(as_name_of_file);
+            tracked_free(am_name_of_file);
+            return NULL;
+        }
+        source.source_text = read_whole_file(as_file, &source.size_of_source);
+    }
+    if (source.source_text == NULL) {
+        fprintf(stderr, "Memory allocation error.\n");
+        exit(1);
+    }
+    output.am_file = am_file;
+    output.expanded_lines = expanded_lines;
+    source.name_of_file = as_name_of_file;
+
+    preprocessed = preprocess_source(&source, &output, origins_of_lines);
+    if (dependencies != NULL) {
+        add_source_dependency(dependencies, as_name_of_file);
+        add_included_dependencies(dependencies, source.dependencies, source.amount_of_dependencies);
+    }
+
+    /* Print how many times every macro was expanded */
+    if (options_of_assembler.print_statistics) {
+        for (current_macro = source.table_of_macros ? source.table_of_macros->head : NULL; current_macro; current_macro = current_macro->next) {
+            printf("%s: the macro '%s' was expanded %lu times\n", name_of_file, current_macro->data->name_of_macro, current_macro->data->amount_of_expansions);
+        }
+    }
+
+    /* Send the rest of the am file to the pipeline */
+    send_am_line(&output, NULL);
+    tracked_free(output.line);
 
+    /* Close files and clean memory */
+    if (as_file) fclose(as_file);
+    fclose(am_file);
+    tracked_free(as_name_of_file);
+    tracked_free(source.source_text);
+    tracked_free(source.dependencies);
+    free_macro_linked_list(&source.table_of_macros);
+    free_string_linked_list(&source.table_with_names_of_macros); 
+    
+    /* The am file is not assembled if a macro couldn't be expanded or a file couldn't be included */
+    if (!preprocessed) {
+        tracked_free(am_name_of_file);
+        return NULL;
+    }
 
     return am_name_of_file;
 }
+
+/*
+ * Compiles the macros of a source file in to a .mlib macro library.
+ *
+ * The file is preprocessed in to memory, its lines outside of the macros are not written anywhere.
+ * The macros it defines and the macros of the files it includes are written to the library.
+ *
+ * @param name_of_file The name of the source file, without its extension.
+ * @param dependencies A pointer that receives the source file and the files it included, or NULL.
+ * @return 1 if the library was written, 0 if the file couldn't be preprocessed or the library couldn't be written.
+ */
+int compile_macro_library(char *name_of_file, struct source_dependencies *dependencies) {
+    char *as_name_of_file;
+    char *mlib_name_of_file;
+    FILE *as_file;
+    struct preprocessor_source source = {0};
+    struct am_output output = {0};
+    struct line_origin_table origins_of_lines = {0};
+    int compiled = 0;
+
+    as_name_of_file = prepare_filename(name_of_file, file_extension_as);
+    as_file = open_file(as_name_of_file, "r");
+    if (as_file == NULL) {
+        tracked_free(as_name_of_file);
+        return 0;
+    }
+    source.source_text = read_whole_file(as_file, &source.size_of_source);
+    fclose(as_file);
+    if (source.source_text == NULL) {
+        fprintf(stderr, "Memory allocation error.\n");
+        exit(1);
+    }
+    source.name_of_file = as_name_of_file;
+
+    if (preprocess_source(&source, &output, &origins_of_lines)) {
+        if (dependencies != NULL) {
+            add_source_dependency(dependencies, as_name_of_file);
+            add_included_dependencies(dependencies, source.dependencies, source.amount_of_dependencies);
+        }
+        mlib_name_of_file = create_output_file_name(name_of_file, FILE_EXTENSION_MLIB);
+        compiled = write_macro_library(mlib_name_of_file, source.table_of_macros);
+        tracked_free(mlib_name_of_file);
+    }
+
+    tracked_free(output.text_of_lines);
+    tracked_free(output.line);
+    free_line_origin_table(&origins_of_lines);
+    tracked_free(as_name_of_file);
+    tracked_free(source.source_text);
+    tracked_free(source.dependencies);
+    free_macro_linked_list(&source.table_of_macros);
+    free_string_linked_list(&source.table_with_names_of_macros);
+    return compiled;
+}
@@ -3,12 +3,18 @@
 
 #include "common.h"
 #include "linked_list.h"
+#include "source_map.h"
+#include "pipeline.h"
+#include "read_ahead.h"
 
 
 #define file_extension_as ".as"
 #define file_extension_am ".am"
 #define MAX_LENGTH_OF_MACRO 31
 #define MAX_LENGTH_OF_LINE 81
+#define MAX_MACRO_PARAMETERS 9
+#define MAX_DEPTH_OF_MACROS 16
+#define MAX_LINES_OF_EXPANSION 1024
 
 
 
@@ -17,33 +23,59 @@
 /*
  * This function reads the content of the source assembly file, processes each line
  * and writes the modified lines to an output am file.
- * The preprocessor recognizes macros, expands macros when called, and handles various
- * preprocessor line types.
+ * The preprocessor recognizes macros, expands macros when called, includes the files of .include
+ * directives and handles various preprocessor line types.
+ *
+ * The origin of every line that is written to the am file is added to the table of line origins, if the source map is needed.
  *
  * @param name_of_file The name of the source assembly file to be preprocessed.
+ * @param origins_of_lines A pointer to the table that receives the origins of the lines of the am file.
+ * @param expanded_lines The ring the lines of the am file are also sent to, with their origins, or NULL.
+ * @param preloaded The source file that was read ahead of time and its am file, or NULL to open both here. The preprocessor owns them.
+ * @param dependencies A pointer that receives the source file and the files it included, or NULL.
  * @return A pointer to the name of the generated modified assembly file, or NULL on error.
  */
-const char* file_preprocessor(char* name_of_file);
+const char* file_preprocessor(char* name_of_file, struct line_origin_table *origins_of_lines, struct line_ring *expanded_lines, struct preloaded_source *preloaded,
+                              struct source_dependencies *dependencies);
 
 /*
- * Create a new macro structure and initialize its feilds.
+ * Frees the memory of the files that were included.
  *
- * This function allocates memory for a new macro structure, sets its name, and initializes
- * the linked list to store lines of code associated with the macro.
+ * Every included file is preprocessed once and kept in memory for all the files that include it.
+ */
+void free_included_files(void);
+
+/*
+ * Compiles the macros of a source file in to a .mlib macro library.
  *
- * @param macro_name The name of the macro being created.
- * @return A pointer to the newly created macro structure, or NULL on memory allocation error.
+ * The file is preprocessed in to memory, its lines outside of the macros are not written anywhere.
+ * The macros it defines and the macros of the files it includes are written to the library.
+ *
+ * @param name_of_file The name of the source file, without its extension.
+ * @param dependencies A pointer that receives the source file and the files it included, or NULL.
+ * @return 1 if the library was written, 0 if the file couldn't be preprocessed or the library couldn't be written.
  */
-struct macro *create_macro();
+int compile_macro_library(char *name_of_file, struct source_dependencies *dependencies);
 
 /*
- * This function creates a new copy of the input string and allocates memory for it.
+ * Reads the whole content of a file in to memory.
  *
- * @param str The input null-terminated string to be duplicated.
- * @return A pointer to the newly allocated string copy, or NULL if memory allocation fails.
- * @note The caller is responsible for freeing the allocated memory using `free()`.
+ * @param file The file, opened for reading.
+ * @param size_of_text A pointer that receives the number of characters that were read.
+ * @return The content of the file, null-terminated, or NULL on memory allocation error.
  */
-char *my_implementation_for_strdup(const char *str); 
+char *read_whole_file(FILE *file, size_t *size_of_text);
+
+/*
+ * Create a new macro structure and initialize its feilds.
+ *
+ * This function allocates memory for a new macro structure, sets its name, and starts
+ * it with an empty body.
+ *
+ * @param macro_name The name of the macro being created.
+ * @return A pointer to the newly created macro structure, or NULL on memory allocation error.
+ */
+struct macro *create_macro();
 
 
 #endif
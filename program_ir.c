@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "program_ir.h"
+
+#define INSTRUCTION_OF(ast) ((ast)->directive_or_instruction.mmn14_ast_instruction)
+
+/*
+ * Resizes an array of the instructions.
+ *
+ * @param array A pointer to the array, it is left as it was on memory allocation error.
+ * @param capacity The number of elements the array needs room for.
+ * @param size_of_element The size of every element.
+ * @return 1 if the array was resized, 0 on memory allocation error.
+ */
+static int resize_array(void **array, size_t capacity, size_t size_of_element) {
+    void *bigger_array = tracked_realloc(*array, capacity * size_of_element, MEMORY_CODE);
+
+    if (bigger_array == NULL) {
+        return 0;
+    }
+    *array = bigger_array;
+    return 1;
+}
+
+/*
+ * Makes room for one more instruction.
+ *
+ * @param ir A pointer to the instructions of the file.
+ * @return 1 if there is room, 0 on memory allocation error.
+ */
+static int grow_instruction_ir(struct instruction_ir *ir) {
+    size_t new_capacity;
+    int i;
+
+    if (ir->amount_of_instructions < ir->capacity_of_instructions) {
+        return 1;
+    }
+    new_capacity = ir->capacity_of_instructions ? ir->capacity_of_instructions * 2 : 64;
+    if (!resize_array((void **)&ir->opcodes, new_capacity, sizeof(unsigned char)) ||
+        !resize_array((void **)&ir->lines, new_capacity, sizeof(int)) ||
+        !resize_array((void **)&ir->addresses, new_capacity, sizeof(long))) {
+        return 0;
+    }
+    for (i = 0; i < 2; i++) {
+        if (!resize_array((void **)&ir->operand_modes[i], new_capacity, sizeof(unsigned char)) ||
+            !resize_array((void **)&ir->operand_values[i], new_capacity, sizeof(int)) ||
+            !resize_array((void **)&ir->operand_ids[i], new_capacity, sizeof(unsigned int))) {
+            return 0;
+        }
+    }
+    ir->capacity_of_instructions = new_capacity;
+    return 1;
+}
+
+/*
+ * Adds an instruction to the end of the instructions of a file.
+ *
+ * @param ir A pointer to the instructions of the file.
+ * @param ast A pointer to the AST of the instruction, the names of its labels are interned.
+ * @param number_of_line The number of the line of the am file the instruction is in.
+ * @param address The offset of the first word of the instruction in the code image.
+ * @return 1 if the instruction was added, 0 on memory allocation error.
+ */
+int add_instruction_to_ir(struct instruction_ir *ir, const mmn14_ast *ast, int number_of_line, long address) {
+    size_t index = ir->amount_of_instructions;
+    int i;
+
+    if (!grow_instruction_ir(ir)) {
+        fprintf(stderr, "wasn't able to allocate memory for the instructions\n");
+        return 0;
+    }
+    ir->opcodes[index] = (unsigned char)INSTRUCTION_OF(ast).mmn14_ast_instruction_opt;
+    for (i = 0; i < 2; i++) {
+        ir->operand_modes[i][index] = (unsigned char)INSTRUCTION_OF(ast).mmn14_ast_instruction_operand_opt[i];
+        ir->operand_ids[i][index] = INSTRUCTION_OF(ast).ids_of_operand_labels[i];
+        switch (INSTRUCTION_OF(ast).mmn14_ast_instruction_operand_opt[i]) {
+            case mmn14_ast_operand_opt_constant_number:
+                ir->operand_values[i][index] = INSTRUCTION_OF(ast).mmn14_ast_instruction_operands[i].constent_number;
+                break;
+            case mmn14_ast_operand_opt_operand_register:
+                ir->operand_values[i][index] = INSTRUCTION_OF(ast).mmn14_ast_instruction_operands[i].register_number;
+                break;
+            default:
+                /* Labels are kept by their ids */
+                ir->operand_values[i][index] = 0;
+                break;
+        }
+    }
+    ir->lines[index] = number_of_line;
+    ir->addresses[index] = address;
+    ir->amount_of_instructions++;
+    return 1;
+}
+
+/*
+ * Frees the memory of the instructions of a file and leaves them empty.
+ *
+ * @param ir A pointer to the instructions of the file.
+ */
+void free_instruction_ir(struct instruction_ir *ir) {
+    int i;
+
+    tracked_free(ir->opcodes);
+    tracked_free(ir->lines);
+    tracked_free(ir->addresses);
+    for (i = 0; i < 2; i++) {
+        tracked_free(ir->operand_modes[i]);
+        tracked_free(ir->operand_values[i]);
+        tracked_free(ir->operand_ids[i]);
+    }
+    memset(ir, 0, sizeof(struct instruction_ir));
+}
@@ -0,0 +1,25 @@
+#ifndef __PROGRAM_IR_H_
+#define __PROGRAM_IR_H_
+
+#include "common.h"
+#include "lexer.h"
+
+/*
+ * Adds an instruction to the end of the instructions of a file.
+ *
+ * @param ir A pointer to the instructions of the file.
+ * @param ast A pointer to the AST of the instruction, the names of its labels are interned.
+ * @param number_of_line The number of the line of the am file the instruction is in.
+ * @param address The offset of the first word of the instruction in the code image.
+ * @return 1 if the instruction was added, 0 on memory allocation error.
+ */
+int add_instruction_to_ir(struct instruction_ir *ir, const mmn14_ast *ast, int number_of_line, long address);
+
+/*
+ * Frees the memory of the instructions of a file and leaves them empty.
+ *
+ * @param ir A pointer to the instructions of the file.
+ */
+void free_instruction_ir(struct instruction_ir *ir);
+
+#endif
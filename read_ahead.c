@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "read_ahead.h"
+#include "preprocessor.h"
+#include "trace_events.h"
+#include "input_files.h"
+
+/*
+ * Checks if an input file has the same name as an input file before it.
+ *
+ * The am file of such a file is not opened ahead of time, since that would empty the am file of
+ * the earlier file while it may still be read.
+ *
+ * @param read_ahead A pointer to the read-ahead.
+ * @param index_of_file The index of the file.
+ * @return 1 if an earlier file has the same name, 0 otherwise.
+ */
+static int name_is_repeated(const struct read_ahead *read_ahead, int index_of_file) {
+    int i;
+
+    for (i = 0; i < index_of_file; i++) {
+        if (read_ahead->names_of_files[i] != NULL && strcmp(read_ahead->names_of_files[i], read_ahead->names_of_files[index_of_file]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Reads a source file in to memory and opens its am file.
+ *
+ * @param read_ahead A pointer to the read-ahead.
+ * @param index_of_file The index of the file.
+ * @param source A pointer to the structure that receives the source.
+ */
+static void load_source(const struct read_ahead *read_ahead, int index_of_file, struct preloaded_source *source) {
+    char *as_name_of_file = create_file_name(read_ahead->names_of_files[index_of_file], file_extension_as);
+    char *am_name_of_file = create_output_file_name(read_ahead->names_of_files[index_of_file], file_extension_am);
+    FILE *as_file;
+
+    if (as_name_of_file != NULL && (as_file = fopen(as_name_of_file, "r")) != NULL) {
+        source->source_was_opened = 1;
+        source->source_text = read_whole_file(as_file, &source->size_of_source);
+        fclose(as_file);
+    }
+    if (am_name_of_file != NULL && !name_is_repeated(read_ahead, index_of_file)) {
+        source->am_file_was_opened = 1;
+        source->am_file = fopen(am_name_of_file, "w");
+    }
+    tracked_free(as_name_of_file);
+    tracked_free(am_name_of_file);
+}
+
+/*
+ * The helper thread that reads the input files ahead of time.
+ *
+ * @param argument A pointer to the read-ahead.
+ * @return NULL.
+ */
+static void *read_ahead_thread(void *argument) {
+    struct read_ahead *read_ahead = (struct read_ahead *)argument;
+    struct preloaded_source source;
+    double start_of_read;
+    int i;
+
+    name_trace_thread("read ahead");
+    for (i = 0; i < read_ahead->amount_of_files; i++) {
+        if (read_ahead->names_of_files[i] == NULL) {
+            continue;
+        }
+        /* Wait until the file is close enough to the file the assembler takes next */
+        pthread_mutex_lock(&read_ahead->lock);
+        while (i >= read_ahead->next_to_take + read_ahead->files_ahead && !read_ahead->stopped) {
+            pthread_cond_wait(&read_ahead->changed, &read_ahead->lock);
+        }
+        if (read_ahead->stopped) {
+            pthread_mutex_unlock(&read_ahead->lock);
+            break;
+        }
+        pthread_mutex_unlock(&read_ahead->lock);
+
+        /* The file is read without the lock, so the assembler can go on */
+        memset(&source, 0, sizeof(source));
+        start_of_read = trace_clock();
+        load_source(read_ahead, i, &source);
+        add_trace_span("read source", read_ahead->names_of_files[i], start_of_read);
+
+        pthread_mutex_lock(&read_ahead->lock);
+        read_ahead->sources[i] = source;
+        read_ahead->sources[i].is_loaded = 1;
+        pthread_cond_broadcast(&read_ahead->changed);
+        pthread_mutex_unlock(&read_ahead->lock);
+    }
+    return NULL;
+}
+
+/*
+ * Starts the helper thread that reads the input files ahead of time.
+ *
+ * The thread reads every source file in to memory and opens its am file, at most files_ahead files
+ * before the file the assembler takes next. It doesn't print anything, the errors are printed
+ * by the preprocessor when it takes the file, in the same order as without the read-ahead.
+ *
+ * @param read_ahead A pointer to the read-ahead.
+ * @param names_of_files The base names of the input files, NULL for the arguments that are not files.
+ * @param amount_of_files The number of input files.
+ * @param files_ahead The number of files to read before they are needed, up to MAX_FILES_TO_READ_AHEAD.
+ * @return 1 if the thread was started, 0 otherwise.
+ */
+int start_read_ahead(struct read_ahead *read_ahead, char **names_of_files, int amount_of_files, int files_ahead) {
+    memset(read_ahead, 0, sizeof(struct read_ahead));
+    read_ahead->sources = (struct preloaded_source *)tracked_calloc(amount_of_files + 1, sizeof(struct preloaded_source), MEMORY_SOURCES);
+    if (read_ahead->sources == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the read-ahead\n");
+        return 0;
+    }
+    read_ahead->names_of_files = names_of_files;
+    read_ahead->amount_of_files = amount_of_files;
+    read_ahead->files_ahead = files_ahead > MAX_FILES_TO_READ_AHEAD ? MAX_FILES_TO_READ_AHEAD : files_ahead;
+    pthread_mutex_init(&read_ahead->lock, NULL);
+    pthread_cond_init(&read_ahead->changed, NULL);
+    if (pthread_create(&read_ahead->thread, NULL, read_ahead_thread, read_ahead) != 0) {
+        fprintf(stderr, "wasn't able to start the read-ahead thread\n");
+        pthread_mutex_destroy(&read_ahead->lock);
+        pthread_cond_destroy(&read_ahead->changed);
+        tracked_free(read_ahead->sources);
+        memset(read_ahead, 0, sizeof(struct read_ahead));
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Waits for an input file to be read and takes it from the read-ahead.
+ *
+ * @param read_ahead A pointer to the read-ahead.
+ * @param index_of_file The index of the file, the files are taken in order.
+ * @param source A pointer that receives the source, the caller owns its text and am file.
+ */
+void take_preloaded_source(struct read_ahead *read_ahead, int index_of_file, struct preloaded_source *source) {
+    pthread_mutex_lock(&read_ahead->lock);
+    /* Let the helper thread read the files after this one */
+    read_ahead->next_to_take = index_of_file + 1;
+    pthread_cond_broadcast(&read_ahead->changed);
+    while (!read_ahead->sources[index_of_file].is_loaded) {
+        pthread_cond_wait(&read_ahead->changed, &read_ahead->lock);
+    }
+    *source = read_ahead->sources[index_of_file];
+    memset(&read_ahead->sources[index_of_file], 0, sizeof(struct preloaded_source));
+    pthread_mutex_unlock(&read_ahead->lock);
+}
+
+/*
+ * Stops the helper thread and frees the files it read that were not taken.
+ *
+ * @param read_ahead A pointer to the read-ahead.
+ */
+void stop_read_ahead(struct read_ahead *read_ahead) {
+    int i;
+
+    pthread_mutex_lock(&read_ahead->lock);
+    read_ahead->stopped = 1;
+    pthread_cond_broadcast(&read_ahead->changed);
+    pthread_mutex_unlock(&read_ahead->lock);
+    pthread_join(read_ahead->thread, NULL);
+    for (i = 0; i < read_ahead->amount_of_files; i++) {
+        tracked_free(read_ahead->sources[i].source_text);
+        if (read_ahead->sources[i].am_file != NULL) {
+            fclose(read_ahead->sources[i].am_file);
+        }
+    }
+    pthread_mutex_destroy(&read_ahead->lock);
+    pthread_cond_destroy(&read_ahead->changed);
+    tracked_free(read_ahead->sources);
+    memset(read_ahead, 0, sizeof(struct read_ahead));
+}
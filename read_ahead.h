@@ -0,0 +1,64 @@
+#ifndef __READ_AHEAD_H_
+#define __READ_AHEAD_H_
+
+#include <stdio.h>
+#include <pthread.h>
+#include "common.h"
+
+#define MAX_FILES_TO_READ_AHEAD 16
+
+/* Represents a source file that was read in to memory ahead of time, and its am file that was opened ahead of time */
+struct preloaded_source {
+    int source_was_opened; /* 1 if the source file was opened */
+    char *source_text; /* The content of the source file, NULL if it wasn't opened or there was no memory for it */
+    size_t size_of_source; /* The number of characters of the source file */
+    int am_file_was_opened; /* 1 if the am file was opened, 0 if the preprocessor opens it itself */
+    FILE *am_file; /* The am file, opened for writing, NULL if it couldn't be opened */
+    int is_loaded; /* Set by the helper thread once the fields above are ready */
+};
+
+/* Represents the helper thread that reads the next input files while the current one is assembled */
+struct read_ahead {
+    char **names_of_files; /* The base names of the input files, NULL for the arguments that are not files */
+    int amount_of_files; /* The number of input files */
+    int files_ahead; /* The number of files the helper thread reads before they are needed */
+    struct preloaded_source *sources; /* The source of every input file */
+    int next_to_take; /* The index of the next file the assembler takes */
+    int stopped; /* Set when the assembler doesn't take any more files */
+    pthread_mutex_t lock; /* Protects the fields of the sources and of the read-ahead */
+    pthread_cond_t changed; /* Signaled when a file is loaded or taken */
+    pthread_t thread; /* The helper thread */
+};
+
+/*
+ * Starts the helper thread that reads the input files ahead of time.
+ *
+ * The thread reads every source file in to memory and opens its am file, at most files_ahead files
+ * before the file the assembler takes next. It doesn't print anything, the errors are printed
+ * by the preprocessor when it takes the file, in the same order as without the read-ahead.
+ *
+ * @param read_ahead A pointer to the read-ahead.
+ * @param names_of_files The base names of the input files, NULL for the arguments that are not files.
+ * @param amount_of_files The number of input files.
+ * @param files_ahead The number of files to read before they are needed, up to MAX_FILES_TO_READ_AHEAD.
+ * @return 1 if the thread was started, 0 otherwise.
+ */
+int start_read_ahead(struct read_ahead *read_ahead, char **names_of_files, int amount_of_files, int files_ahead);
+
+/*
+ * Waits for an input file to be read and takes it from the read-ahead.
+ *
+ * @param read_ahead A pointer to the read-ahead.
+ * @param index_of_file The index of the file, the files are taken in order.
+ * @param source A pointer that receives the source, the caller owns its text and am file.
+ */
+void take_preloaded_source(struct read_ahead *read_ahead, int index_of_file, struct preloaded_source *source);
+
+/*
+ * Stops the helper thread and frees the files it read that were not taken.
+ *
+ * @param read_ahead A pointer to the read-ahead.
+ */
+void stop_read_ahead(struct read_ahead *read_ahead);
+
+#endif
@@ -0,0 +1,399 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "report.h"
+#include "lexer.h"
+#include "source_map.h"
+#include "interner.h"
+#include "input_files.h"
+
+#define NO_LABEL_NAME "(none)"
+
+/* The names of the instructions by their opcode */
+static const char *names_of_instructions[16] = {
+    "mov", "cmp", "add", "sub", "not", "clr", "lea", "inc",
+    "dec", "jmp", "bne", "red", "prn", "jsr", "rts", "stop"
+};
+
+/* Represents the resources of the words that come after a label */
+struct label_resources {
+    char name_of_label[LABEL_MAX_LENGTH + 1]; /* The name of the label, empty for the words before the first label */
+    long code_words; /* The number of code words after the label */
+    long data_words; /* The number of data words after the label */
+    char (*externs)[LABEL_MAX_LENGTH + 1]; /* The externs that are referenced after the label, every one once */
+    size_t amount_of_externs; /* The number of externs */
+};
+
+/* Represents the words that one macro call was expanded to */
+struct macro_expansion {
+    char name_of_macro[MAX_LENGTH_OF_MACRO + 1]; /* The name of the macro */
+    unsigned int line_of_calling; /* The line of the macro call */
+    long words; /* The number of code and data words of the expansion */
+};
+
+/* Represents the instructions of one opcode */
+struct instruction_mix {
+    long count; /* The number of instructions */
+    long source_modes[8]; /* The number of source operands of every addressing mode */
+    long destination_modes[8]; /* The number of destination operands of every addressing mode */
+};
+
+/* Represents the resource report of a module */
+struct module_report {
+    struct label_resources *labels; /* The labels, in the order of their addresses */
+    size_t amount_of_labels; /* The number of labels */
+    struct macro_expansion *expansions; /* The macro calls, in the order of their first address */
+    size_t amount_of_expansions; /* The number of macro calls */
+    struct instruction_mix mix[16]; /* The instructions of every opcode */
+    long code_words; /* The number of words in the code image */
+    long data_words; /* The number of words in the data image */
+    long free_words; /* The number of words that are left in the memory */
+};
+
+/*
+ * Returns the resources of a label in the report, and adds the label if it is not there yet.
+ *
+ * @param report A pointer to the report, it has room for every label.
+ * @param name_of_label The name of the label.
+ * @return A pointer to the resources of the label.
+ */
+static struct label_resources *resources_of_label(struct module_report *report, const char *name_of_label) {
+    size_t i;
+
+    for (i = 0; i < report->amount_of_labels; i++) {
+        if (strcmp(report->labels[i].name_of_label, name_of_label) == 0) {
+            return &report->labels[i];
+        }
+    }
+    strcpy(report->labels[report->amount_of_labels].name_of_label, name_of_label);
+    return &report->labels[report->amount_of_labels++];
+}
+
+/*
+ * Adds an extern to the externs that are referenced after a label, unless it is there already.
+ *
+ * @param label A pointer to the resources of the label.
+ * @param name_of_extern The name of the extern.
+ * @return 1 if the extern is in the list of the label, 0 on memory allocation error.
+ */
+static int add_extern_of_label(struct label_resources *label, const char *name_of_extern) {
+    char (*bigger_externs)[LABEL_MAX_LENGTH + 1];
+    size_t i;
+
+    for (i = 0; i < label->amount_of_externs; i++) {
+        if (strcmp(label->externs[i], name_of_extern) == 0) {
+            return 1;
+        }
+    }
+    bigger_externs = tracked_realloc(label->externs, (label->amount_of_externs + 1) * sizeof(*label->externs), MEMORY_OUTPUTS);
+    if (bigger_externs == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the externs of a label\n");
+        return 0;
+    }
+    label->externs = bigger_externs;
+    strcpy(label->externs[label->amount_of_externs++], name_of_extern);
+    return 1;
+}
+
+/*
+ * Counts the instructions of the code image by their opcode and the addressing modes of their operands.
+ *
+ * @param report A pointer to the report.
+ * @param obj_file A pointer to the object file, its instructions are counted.
+ */
+static void count_instruction_mix(struct module_report *report, const struct object_file *obj_file) {
+    const struct instruction_ir *ir = &obj_file->instructions;
+    struct instruction_mix *mix;
+    size_t index;
+
+    for (index = 0; index < ir->amount_of_instructions; index++) {
+        mix = &report->mix[ir->opcodes[index]];
+        mix->count++;
+        if (ir->opcodes[index] <= mmn14_ast_instruction_sub || ir->opcodes[index] == mmn14_ast_instruction_lea) {
+            mix->source_modes[ir->operand_modes[0][index]]++;
+            mix->destination_modes[ir->operand_modes[1][index]]++;
+        } else if (ir->opcodes[index] <= mmn14_ast_instruction_jsr) {
+            /* The only operand is a destination, wherever it is encoded */
+            mix->destination_modes[ir->operand_modes[ir->operand_modes[1][index] != mmn14_ast_operand_opt_no_operand ? 1 : 0][index]]++;
+        }
+    }
+}
+
+/*
+ * Builds the resource report of a module from its object file and source map.
+ *
+ * @param report A pointer to the report to build.
+ * @param obj_file A pointer to the object file of the module.
+ * @return 1 if the report was built, 0 on memory allocation error.
+ */
+static int build_module_report(struct module_report *report, const struct object_file *obj_file) {
+    const struct source_map *map = &obj_file->map_of_sources;
+    const struct source_map_record *record;
+    struct label_resources *label;
+    const struct extern_use *current_use;
+    size_t i;
+    size_t j;
+    long words;
+
+    memset(report, 0, sizeof(struct module_report));
+    /* The words of the lines after the memory was full are counted as well, so the headroom can be negative */
+    report->code_words = obj_file->IC + obj_file->code_words_beyond_memory;
+    report->data_words = obj_file->DC + obj_file->data_words_beyond_memory;
+    report->free_words = MEMORY_SIZE - BEGINNING_ADDRESS - report->code_words - report->data_words;
+    /* Every record has at most one label and one macro call */
+    report->labels = (struct label_resources *)tracked_calloc(map->amount_of_records + 1, sizeof(struct label_resources), MEMORY_OUTPUTS);
+    report->expansions = (struct macro_expansion *)tracked_calloc(map->amount_of_records + 1, sizeof(struct macro_expansion), MEMORY_OUTPUTS);
+    if (report->labels == NULL || report->expansions == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the report\n");
+        return 0;
+    }
+
+    for (i = 0; i < map->amount_of_records; i++) {
+        record = &map->records[i];
+        words = (long)record->end_address - (long)record->first_address;
+        label = resources_of_label(report, record->name_of_label);
+        if (record->is_data) {
+            label->data_words += words;
+        } else {
+            label->code_words += words;
+        }
+        if (record->name_of_macro[0] != '\0') {
+            /* Find the macro call the record belongs to */
+            for (j = 0; j < report->amount_of_expansions; j++) {
+                if (report->expansions[j].line_of_calling == record->line_of_calling &&
+                    strcmp(report->expansions[j].name_of_macro, record->name_of_macro) == 0) {
+                    break;
+                }
+            }
+            if (j == report->amount_of_expansions) {
+                strcpy(report->expansions[j].name_of_macro, record->name_of_macro);
+                report->expansions[j].line_of_calling = record->line_of_calling;
+                report->amount_of_expansions++;
+            }
+            report->expansions[j].words += words;
+        }
+    }
+
+    /* Every use of an extern belongs to the label of its address */
+    for (i = 0; i < obj_file->extern_uses.amount_of_uses; i++) {
+        current_use = &obj_file->extern_uses.uses[i];
+        record = find_source_map_record(map, current_use->address);
+        if (record != NULL && !add_extern_of_label(resources_of_label(report, record->name_of_label), name_of_symbol_id(&obj_file->interned_symbols, current_use->id_of_symbol))) {
+            return 0;
+        }
+    }
+
+    count_instruction_mix(report, obj_file);
+    return 1;
+}
+
+/*
+ * Frees the memory of a resource report.
+ *
+ * @param report A pointer to the report.
+ */
+static void free_module_report(struct module_report *report) {
+    size_t i;
+
+    if (report->labels != NULL) {
+        for (i = 0; i < report->amount_of_labels; i++) {
+            tracked_free(report->labels[i].externs);
+        }
+    }
+    tracked_free(report->labels);
+    tracked_free(report->expansions);
+}
+
+/*
+ * Writes a resource report as text.
+ *
+ * @param report_file The file to write to.
+ * @param name_of_module The base name of the module.
+ * @param report A pointer to the report.
+ */
+static void print_text_report(FILE *report_file, const char *name_of_module, const struct module_report *report) {
+    size_t i;
+    size_t j;
+    int opcode;
+
+    fprintf(report_file, "Resource report of: %s\n\n", name_of_module);
+    fprintf(report_file, "Memory: %ld code words + %ld data words = %ld of %d words, %ld words left\n\n",
+            report->code_words, report->data_words, report->code_words + report->data_words,
+            MEMORY_SIZE - BEGINNING_ADDRESS, report->free_words);
+    if (report->free_words < 0) {
+        fprintf(report_file, "The program does not fit in the memory, it needs %ld more words. "
+                "The instructions after the memory was full are not in the table of instructions.\n\n", -report->free_words);
+    }
+
+    fprintf(report_file, "%-31s %6s %6s  %s\n", "Label", "Code", "Data", "Externs");
+    for (i = 0; i < report->amount_of_labels; i++) {
+        fprintf(report_file, "%-31s %6ld %6ld ", report->labels[i].name_of_label[0] ? report->labels[i].name_of_label : NO_LABEL_NAME,
+                report->labels[i].code_words, report->labels[i].data_words);
+        for (j = 0; j < report->labels[i].amount_of_externs; j++) {
+            fprintf(report_file, "%s%s", j ? ", " : " ", report->labels[i].externs[j]);
+        }
+        fprintf(report_file, "\n");
+    }
+
+    fprintf(report_file, "\n%-11s %6s  %-27s  %-27s\n", "Instruction", "Count", "Source (imm/dir/reg)", "Destination (imm/dir/reg)");
+    for (opcode = 0; opcode < 16; opcode++) {
+        if (report->mix[opcode].count == 0) {
+            continue;
+        }
+        fprintf(report_file, "%-11s %6ld  %8ld %8ld %8ld   %8ld %8ld %8ld\n", names_of_instructions[opcode], report->mix[opcode].count,
+                report->mix[opcode].source_modes[mmn14_ast_operand_opt_constant_number],
+                report->mix[opcode].source_modes[mmn14_ast_operand_opt_operand_label],
+                report->mix[opcode].source_modes[mmn14_ast_operand_opt_operand_register],
+                report->mix[opcode].destination_modes[mmn14_ast_operand_opt_constant_number],
+                report->mix[opcode].destination_modes[mmn14_ast_operand_opt_operand_label],
+                report->mix[opcode].destination_modes[mmn14_ast_operand_opt_operand_register]);
+    }
+
+    fprintf(report_file, "\n%-31s %6s %6s\n", "Macro call", "Line", "Words");
+    for (i = 0; i < report->amount_of_expansions; i++) {
+        fprintf(report_file, "%-31s %6u %6ld\n", report->expansions[i].name_of_macro, report->expansions[i].line_of_calling, report->expansions[i].words);
+    }
+}
+
+/*
+ * Writes a string as a JSON string, with quotes and escaped characters.
+ *
+ * @param report_file The file to write to.
+ * @param str The string to write.
+ */
+static void print_json_string(FILE *report_file, const char *str) {
+    fputc('"', report_file);
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\') {
+            fputc('\\', report_file);
+            fputc(*str, report_file);
+        } else if ((unsigned char)*str < 0x20) {
+            fprintf(report_file, "\\u%04x", (unsigned int)(unsigned char)*str);
+        } else {
+            fputc(*str, report_file);
+        }
+    }
+    fputc('"', report_file);
+}
+
+/*
+ * Writes the counts of the addressing modes of an operand as a JSON object.
+ *
+ * @param report_file The file to write to.
+ * @param modes The number of operands of every addressing mode.
+ */
+static void print_json_modes(FILE *report_file, const long *modes) {
+    fprintf(report_file, "{\"immediate\": %ld, \"direct\": %ld, \"register\": %ld}",
+            modes[mmn14_ast_operand_opt_constant_number], modes[mmn14_ast_operand_opt_operand_label], modes[mmn14_ast_operand_opt_operand_register]);
+}
+
+/*
+ * Writes a resource report as JSON.
+ *
+ * @param report_file The file to write to.
+ * @param name_of_module The base name of the module.
+ * @param report A pointer to the report.
+ */
+static void print_json_report(FILE *report_file, const char *name_of_module, const struct module_report *report) {
+    size_t i;
+    size_t j;
+    int opcode;
+    int first = 1;
+
+    fprintf(report_file, "{\n  \"module\": ");
+    print_json_string(report_file, name_of_module);
+    fprintf(report_file, ",\n  \"memory\": {\"size\": %d, \"beginning_address\": %d, \"code_words\": %ld, \"data_words\": %ld, \"free_words\": %ld},\n",
+            MEMORY_SIZE, BEGINNING_ADDRESS, report->code_words, report->data_words, report->free_words);
+
+    fprintf(report_file, "  \"labels\": [");
+    for (i = 0; i < report->amount_of_labels; i++) {
+        fprintf(report_file, "%s\n    {\"name\": ", i ? "," : "");
+        print_json_string(report_file, report->labels[i].name_of_label);
+        fprintf(report_file, ", \"code_words\": %ld, \"data_words\": %ld, \"externs\": [", report->labels[i].code_words, report->labels[i].data_words);
+        for (j = 0; j < report->labels[i].amount_of_externs; j++) {
+            fprintf(report_file, "%s", j ? ", " : "");
+            print_json_string(report_file, report->labels[i].externs[j]);
+        }
+        fprintf(report_file, "]}");
+    }
+    fprintf(report_file, "\n  ],\n");
+
+    fprintf(report_file, "  \"instructions\": [");
+    for (opcode = 0; opcode < 16; opcode++) {
+        if (report->mix[opcode].count == 0) {
+            continue;
+        }
+        fprintf(report_file, "%s\n    {\"opcode\": \"%s\", \"count\": %ld, \"source\": ", first ? "" : ",", names_of_instructions[opcode], report->mix[opcode].count);
+        print_json_modes(report_file, report->mix[opcode].source_modes);
+        fprintf(report_file, ", \"destination\": ");
+        print_json_modes(report_file, report->mix[opcode].destination_modes);
+        fprintf(report_file, "}");
+        first = 0;
+    }
+    fprintf(report_file, "\n  ],\n");
+
+    fprintf(report_file, "  \"macro_calls\": [");
+    for (i = 0; i < report->amount_of_expansions; i++) {
+        fprintf(report_file, "%s\n    {\"macro\": ", i ? "," : "");
+        print_json_string(report_file, report->expansions[i].name_of_macro);
+        fprintf(report_file, ", \"line\": %u, \"words\": %ld}", report->expansions[i].line_of_calling, report->expansions[i].words);
+    }
+    fprintf(report_file, "\n  ]\n}\n");
+}
+
+/*
+ * Opens a report file of a module, writes a report to it with the given printer and closes it.
+ *
+ * @param name_of_module The base name of the module.
+ * @param extension The extension of the report file.
+ * @param print_report The function that writes the report.
+ * @param report A pointer to the report.
+ * @return 1 if the file was written successfully, 0 otherwise.
+ */
+static int write_report_file(const char *name_of_module, const char *extension,
+                             void (*print_report)(FILE *, const char *, const struct module_report *), const struct module_report *report) {
+    char *report_name_of_file = create_output_file_name(name_of_module, extension);
+    FILE *report_file;
+    int success = 0;
+
+    if (report_name_of_file == NULL) {
+        return 0;
+    }
+    report_file = fopen(report_name_of_file, "w");
+    if (report_file != NULL) {
+        print_report(report_file, name_of_module, report);
+        success = !ferror(report_file);
+        if (fclose(report_file) != 0) {
+            success = 0;
+        }
+    }
+    if (!success) {
+        fprintf(stderr, "wasn't able to write the file: %s\n", report_name_of_file);
+    }
+    tracked_free(report_name_of_file);
+    return success;
+}
+
+/*
+ * Writes the resource report of a module, as text to the .report file and as JSON to the .report.json file.
+ *
+ * The report has the number of code words, data words and referenced externs of every label,
+ * the number of instructions of every opcode by the addressing modes of their operands,
+ * the number of words every macro call was expanded to, and the memory that is left.
+ * A module whose images didn't fit in the memory has a negative amount of memory left.
+ *
+ * @param name_of_module The base name of the module.
+ * @param obj_file A pointer to the object file of the module, its source map must be finished.
+ * @return 1 if both files were written successfully, 0 otherwise.
+ */
+int output_report_files(const char *name_of_module, const struct object_file *obj_file) {
+    struct module_report report;
+    int success = 0;
+
+    if (build_module_report(&report, obj_file)) {
+        success = write_report_file(name_of_module, FILE_EXTENSION_REPORT, print_text_report, &report);
+        success = write_report_file(name_of_module, FILE_EXTENSION_REPORT_JSON, print_json_report, &report) && success;
+    }
+    free_module_report(&report);
+    return success;
+}
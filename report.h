@@ -0,0 +1,25 @@
+#ifndef __REPORT_H_
+#define __REPORT_H_
+
+#include <stdio.h>
+#include "common.h"
+
+#define FILE_EXTENSION_REPORT ".report"
+#define FILE_EXTENSION_REPORT_JSON ".report.json"
+#define BEGINNING_ADDRESS 100
+
+/*
+ * Writes the resource report of a module, as text to the .report file and as JSON to the .report.json file.
+ *
+ * The report has the number of code words, data words and referenced externs of every label,
+ * the number of instructions of every opcode by the addressing modes of their operands,
+ * the number of words every macro call was expanded to, and the memory that is left.
+ * A module whose images didn't fit in the memory has a negative amount of memory left.
+ *
+ * @param name_of_module The base name of the module.
+ * @param obj_file A pointer to the object file of the module, its source map must be finished.
+ * @return 1 if both files were written successfully, 0 otherwise.
+ */
+int output_report_files(const char *name_of_module, const struct object_file *obj_file);
+
+#endif
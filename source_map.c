@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "source_map.h"
+#include "input_files.h"
+
+/* Represents the string table of a .map file while it is built */
+struct map_string_table {
+    char *strings; /* The null terminated strings, one after the other */
+    unsigned long size; /* The number of bytes that are used */
+    unsigned long capacity; /* The number of bytes there is room for */
+};
+
+/*
+ * Checks if the options of the assembler need the source map.
+ *
+ * The map is written with --map, the report counts the words of every label and macro call with it,
+ * and --run points at the source line of a fault with it. Otherwise the origins of the lines and
+ * the records are not kept at all.
+ *
+ * @return 1 if the source map has to be built, 0 otherwise.
+ */
+int source_map_is_needed(void) {
+    return options_of_assembler.output_map || options_of_assembler.output_report || options_of_assembler.run_program;
+}
+
+/*
+ * Adds the origin of the next line of an am file to a table of line origins.
+ *
+ * @param table A pointer to the table of line origins.
+ * @param line_in_source The line of the source file the line was written from.
+ * @param name_of_macro The macro the line was expanded from, or NULL if it is not from a macro.
+ * @param line_of_calling The line of the macro call, 0 if the line is not from a macro.
+ * @return 1 if the origin was added, 0 on memory allocation error.
+ */
+int add_line_origin(struct line_origin_table *table, unsigned int line_in_source, const char *name_of_macro, unsigned int line_of_calling) {
+    struct line_origin *origin;
+    struct line_origin *bigger_origins;
+    size_t new_capacity;
+
+    /* Make room for the line */
+    if (table->amount_of_lines == table->capacity) {
+        new_capacity = table->capacity ? table->capacity * 2 : 64;
+        bigger_origins = (struct line_origin *)tracked_realloc(table->origins, new_capacity * sizeof(struct line_origin), MEMORY_SOURCE_MAP);
+        if (bigger_origins == NULL) {
+            fprintf(stderr, "wasn't able to allocate memory for the origins of the lines\n");
+            return 0;
+        }
+        table->origins = bigger_origins;
+        table->capacity = new_capacity;
+    }
+    origin = &table->origins[table->amount_of_lines++];
+    origin->line_in_source = line_in_source;
+    origin->line_of_calling = line_of_calling;
+    origin->name_of_macro[0] = '\0';
+    if (name_of_macro != NULL) {
+        strncpy(origin->name_of_macro, name_of_macro, MAX_LENGTH_OF_MACRO);
+        origin->name_of_macro[MAX_LENGTH_OF_MACRO] = '\0';
+    }
+    return 1;
+}
+
+/*
+ * Frees the memory of a table of line origins and leaves it empty.
+ *
+ * @param table A pointer to the table of line origins.
+ */
+void free_line_origin_table(struct line_origin_table *table) {
+    tracked_free(table->origins);
+    table->origins = NULL;
+    table->amount_of_lines = 0;
+    table->capacity = 0;
+}
+
+/*
+ * Adds a record to a source map.
+ *
+ * The addresses of a record of the data image are relative to the data image
+ * until the map is finished.
+ *
+ * @param map A pointer to the source map.
+ * @param record A pointer to the record to add, it is copied in to the map.
+ * @return 1 if the record was added, 0 on memory allocation error.
+ */
+int add_source_map_record(struct source_map *map, const struct source_map_record *record) {
+    struct source_map_record *bigger_records;
+    size_t new_capacity;
+
+    /* Make room for the record */
+    if (map->amount_of_records == map->capacity) {
+        new_capacity = map->capacity ? map->capacity * 2 : 64;
+        bigger_records = (struct source_map_record *)tracked_realloc(map->records, new_capacity * sizeof(struct source_map_record), MEMORY_SOURCE_MAP);
+        if (bigger_records == NULL) {
+            fprintf(stderr, "wasn't able to allocate memory for the source map\n");
+            return 0;
+        }
+        map->records = bigger_records;
+        map->capacity = new_capacity;
+    }
+    map->records[map->amount_of_records++] = *record;
+    return 1;
+}
+
+/*
+ * Compares two records of a source map by their first address, for qsort.
+ *
+ * @param first A pointer to the first record.
+ * @param second A pointer to the second record.
+ * @return A negative number, zero or a positive number if the first record comes before, with or after the second.
+ */
+static int compare_source_map_records(const void *first, const void *second) {
+    unsigned int first_address = ((const struct source_map_record *)first)->first_address;
+    unsigned int second_address = ((const struct source_map_record *)second)->first_address;
+
+    return (first_address > second_address) - (first_address < second_address);
+}
+
+/*
+ * Finishes a source map once the size of the code image is known.
+ *
+ * The records of the data image are moved to their final addresses, right after the code image,
+ * and all the records are sorted by address.
+ *
+ * @param map A pointer to the source map.
+ * @param IC The number of words in the code image.
+ */
+void finish_source_map(struct source_map *map, long IC) {
+    size_t i;
+
+    for (i = 0; i < map->amount_of_records; i++) {
+        if (map->records[i].is_data) {
+            map->records[i].first_address += IC + BEGINNING_ADDRESS;
+            map->records[i].end_address += IC + BEGINNING_ADDRESS;
+        }
+    }
+    if (map->amount_of_records > 1) {
+        qsort(map->records, map->amount_of_records, sizeof(struct source_map_record), compare_source_map_records);
+    }
+}
+
+/*
+ * Finds the record of a finished source map that contains an address, using a binary search.
+ *
+ * @param map A pointer to the finished source map.
+ * @param address The address to look for.
+ * @return A pointer to the record that contains the address, or NULL if no record contains it.
+ */
+const struct source_map_record *find_source_map_record(const struct source_map *map, unsigned int address) {
+    size_t low = 0;
+    size_t high = map->amount_of_records;
+    size_t middle;
+
+    /* Find the first record that starts after the address */
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (map->records[middle].first_address <= address) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    /* The record before it is the only one that can contain the address */
+    if (low == 0 || address >= map->records[low - 1].end_address) {
+        return NULL;
+    }
+    return &map->records[low - 1];
+}
+
+/*
+ * Returns the offset of a string in the string table of a .map file, and adds it if it is not there yet.
+ *
+ * @param table A pointer to the string table.
+ * @param str The string, an empty string means there is no string.
+ * @return The offset of the string, SOURCE_MAP_NO_STRING for an empty string or on memory allocation error.
+ */
+static unsigned long offset_of_map_string(struct map_string_table *table, const char *str) {
+    unsigned long offset = 0;
+    unsigned long length = strlen(str);
+    unsigned long new_capacity;
+    char *bigger_strings;
+
+    if (length == 0) {
+        return SOURCE_MAP_NO_STRING;
+    }
+    /* Look for the string in the table */
+    while (offset < table->size) {
+        if (strcmp(table->strings + offset, str) == 0) {
+            return offset;
+        }
+        offset += strlen(table->strings + offset) + 1;
+    }
+    /* Make room for the string and add it */
+    if (table->size + length + 1 > table->capacity) {
+        new_capacity = (table->capacity + length + 1) * 2;
+        bigger_strings = (char *)tracked_realloc(table->strings, new_capacity, MEMORY_SOURCE_MAP);
+        if (bigger_strings == NULL) {
+            fprintf(stderr, "wasn't able to allocate memory for the strings of the source map\n");
+            return SOURCE_MAP_NO_STRING;
+        }
+        table->strings = bigger_strings;
+        table->capacity = new_capacity;
+    }
+    strcpy(table->strings + table->size, str);
+    table->size += length + 1;
+    return offset;
+}
+
+/*
+ * Writes a finished source map to the .map file of a module.
+ *
+ * @param name_of_module The base name of the module.
+ * @param name_of_source_file The name of the source file the records refer to.
+ * @param map A pointer to the finished source map.
+ * @return 1 if the .map file was written successfully, 0 otherwise.
+ */
+int output_map_file(const char *name_of_module, const char *name_of_source_file, const struct source_map *map) {
+    struct map_string_table table = {0};
+    unsigned char header[SOURCE_MAP_HEADER_SIZE];
+    unsigned char *records;
+    unsigned char *current;
+    unsigned long offset_of_source_file;
+    char *map_name_of_file;
+    FILE *map_file;
+    size_t i;
+    int success = 0;
+
+    records = (unsigned char *)tracked_malloc(map->amount_of_records * SOURCE_MAP_RECORD_SIZE + 1, MEMORY_SOURCE_MAP);
+    if (records == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the source map\n");
+        return 0;
+    }
+    /* Encode the records, the strings are added to the string table on the way */
+    offset_of_source_file = offset_of_map_string(&table, name_of_source_file);
+    for (i = 0, current = records; i < map->amount_of_records; i++, current += SOURCE_MAP_RECORD_SIZE) {
+        put_little_endian(current, map->records[i].first_address, 2);
+        put_little_endian(current + 2, map->records[i].end_address, 2);
+        put_little_endian(current + 4, map->records[i].line_in_source, 2);
+        put_little_endian(current + 6, map->records[i].line_of_calling, 2);
+        put_little_endian(current + 8, offset_of_source_file, 4);
+        put_little_endian(current + 12, offset_of_map_string(&table, map->records[i].name_of_label), 4);
+        put_little_endian(current + 16, offset_of_map_string(&table, map->records[i].name_of_macro), 4);
+    }
+    memcpy(header, SOURCE_MAP_MAGIC, 4);
+    put_little_endian(header + 4, SOURCE_MAP_VERSION, 2);
+    put_little_endian(header + 6, 0, 2);
+    put_little_endian(header + 8, map->amount_of_records, 4);
+    put_little_endian(header + 12, table.size, 4);
+
+    map_name_of_file = create_output_file_name(name_of_module, FILE_EXTENSION_MAP);
+    if (map_name_of_file != NULL) {
+        map_file = fopen(map_name_of_file, "wb");
+        if (map_file != NULL) {
+            success = fwrite(header, 1, SOURCE_MAP_HEADER_SIZE, map_file) == SOURCE_MAP_HEADER_SIZE &&
+                      fwrite(records, SOURCE_MAP_RECORD_SIZE, map->amount_of_records, map_file) == map->amount_of_records &&
+                      fwrite(table.strings, 1, table.size, map_file) == table.size;
+            if (fclose(map_file) != 0) {
+                success = 0;
+            }
+        }
+        if (!success) {
+            fprintf(stderr, "wasn't able to write the file: %s\n", map_name_of_file);
+        }
+        tracked_free(map_name_of_file);
+    }
+    tracked_free(records);
+    tracked_free(table.strings);
+    return success;
+}
+
+/*
+ * Frees the memory of a source map and leaves it empty.
+ *
+ * @param map A pointer to the source map.
+ */
+void free_source_map(struct source_map *map) {
+    tracked_free(map->records);
+    map->records = NULL;
+    map->amount_of_records = 0;
+    map->capacity = 0;
+}
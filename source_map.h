@@ -0,0 +1,104 @@
+#ifndef __SOURCE_MAP_H_
+#define __SOURCE_MAP_H_
+
+#include <stdio.h>
+#include "common.h"
+
+#define FILE_EXTENSION_MAP ".map"
+#define BEGINNING_ADDRESS 100
+
+/*
+ * The .map file is little endian and made of three parts:
+ * a header of SOURCE_MAP_HEADER_SIZE bytes - the magic "AMAP", the version (2 bytes), 2 reserved bytes,
+ *     the number of records (4 bytes) and the size of the string table (4 bytes),
+ * the records, sorted by address, SOURCE_MAP_RECORD_SIZE bytes each - the first address (2 bytes),
+ *     the end address (2 bytes), the line (2 bytes), the line of the macro call (2 bytes), and the offsets of
+ *     the source file name, the label and the macro name in the string table (4 bytes each),
+ * and the string table, null terminated strings where every string appears once.
+ * An offset of SOURCE_MAP_NO_STRING means there is no such string.
+ */
+#define SOURCE_MAP_MAGIC "AMAP"
+#define SOURCE_MAP_VERSION 1
+#define SOURCE_MAP_HEADER_SIZE 16
+#define SOURCE_MAP_RECORD_SIZE 20
+#define SOURCE_MAP_NO_STRING 0xFFFFFFFFUL
+
+/*
+ * Checks if the options of the assembler need the source map.
+ *
+ * The map is written with --map, the report counts the words of every label and macro call with it,
+ * and --run points at the source line of a fault with it. Otherwise the origins of the lines and
+ * the records are not kept at all.
+ *
+ * @return 1 if the source map has to be built, 0 otherwise.
+ */
+int source_map_is_needed(void);
+
+/*
+ * Adds the origin of the next line of an am file to a table of line origins.
+ *
+ * @param table A pointer to the table of line origins.
+ * @param line_in_source The line of the source file the line was written from.
+ * @param name_of_macro The macro the line was expanded from, or NULL if it is not from a macro.
+ * @param line_of_calling The line of the macro call, 0 if the line is not from a macro.
+ * @return 1 if the origin was added, 0 on memory allocation error.
+ */
+int add_line_origin(struct line_origin_table *table, unsigned int line_in_source, const char *name_of_macro, unsigned int line_of_calling);
+
+/*
+ * Frees the memory of a table of line origins and leaves it empty.
+ *
+ * @param table A pointer to the table of line origins.
+ */
+void free_line_origin_table(struct line_origin_table *table);
+
+/*
+ * Adds a record to a source map.
+ *
+ * The addresses of a record of the data image are relative to the data image
+ * until the map is finished.
+ *
+ * @param map A pointer to the source map.
+ * @param record A pointer to the record to add, it is copied in to the map.
+ * @return 1 if the record was added, 0 on memory allocation error.
+ */
+int add_source_map_record(struct source_map *map, const struct source_map_record *record);
+
+/*
+ * Finishes a source map once the size of the code image is known.
+ *
+ * The records of the data image are moved to their final addresses, right after the code image,
+ * and all the records are sorted by address.
+ *
+ * @param map A pointer to the source map.
+ * @param IC The number of words in the code image.
+ */
+void finish_source_map(struct source_map *map, long IC);
+
+/*
+ * Finds the record of a finished source map that contains an address, using a binary search.
+ *
+ * @param map A pointer to the finished source map.
+ * @param address The address to look for.
+ * @return A pointer to the record that contains the address, or NULL if no record contains it.
+ */
+const struct source_map_record *find_source_map_record(const struct source_map *map, unsigned int address);
+
+/*
+ * Writes a finished source map to the .map file of a module.
+ *
+ * @param name_of_module The base name of the module.
+ * @param name_of_source_file The name of the source file the records refer to.
+ * @param map A pointer to the finished source map.
+ * @return 1 if the .map file was written successfully, 0 otherwise.
+ */
+int output_map_file(const char *name_of_module, const char *name_of_source_file, const struct source_map *map);
+
+/*
+ * Frees the memory of a source map and leaves it empty.
+ *
+ * @param map A pointer to the source map.
+ */
+void free_source_map(struct source_map *map);
+
+#endif
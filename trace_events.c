@@ -0,0 +1,268 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "trace_events.h"
+#include "output_unit.h"
+#include "file_watcher.h"
+
+/* The events of the trace, every thread adds to them under the lock */
+static struct trace_event *events = NULL;
+static size_t amount_of_events = 0;
+static size_t capacity_of_events = 0;
+/* The names of the files of the events, every name null terminated, the first one is empty */
+static struct output_text names_of_files = {0};
+/* The offset of the name of the file of the last event, most events belong to the same file as the one before */
+static size_t offset_of_last_file = 0;
+static int tracing = 0;
+static double start_of_trace;
+static pthread_mutex_t lock_of_trace = PTHREAD_MUTEX_INITIALIZER;
+/* The names of the threads, a thread has the id of its name plus 2 */
+static const char *names_of_threads[MAX_TRACE_THREADS];
+static int amount_of_thread_names = 0;
+static pthread_key_t key_of_thread_id;
+
+/*
+ * Starts to record the trace events of the run.
+ *
+ * The events are kept in memory until write_trace, so recording one costs a lock and a copy.
+ * Until the trace is started, every function of the trace returns right away.
+ */
+void start_trace(void) {
+    if (tracing || pthread_key_create(&key_of_thread_id, NULL) != 0) {
+        return;
+    }
+    /* The empty name at offset 0 is the name of the events without a file */
+    if (!append_output_text(&names_of_files, "")) {
+        pthread_key_delete(key_of_thread_id);
+        return;
+    }
+    names_of_files.length = 1;
+    start_of_trace = milliseconds_of_clock();
+    tracing = 1;
+}
+
+/*
+ * Reads the clock of the trace.
+ *
+ * @return The time in microseconds from the start of the trace, 0 if the trace wasn't started.
+ */
+double trace_clock(void) {
+    return tracing ? (milliseconds_of_clock() - start_of_trace) * 1000.0 : 0;
+}
+
+/*
+ * Gives the calling thread a name in the trace.
+ *
+ * Threads with the same name share their row of the trace, so the threads that are started again for every
+ * file don't add rows. A thread without a name belongs to the main thread.
+ *
+ * @param name_of_thread The name of the thread, a string literal.
+ */
+void name_trace_thread(const char *name_of_thread) {
+    int i;
+
+    if (!tracing) {
+        return;
+    }
+    pthread_mutex_lock(&lock_of_trace);
+    for (i = 0; i < amount_of_thread_names && strcmp(names_of_threads[i], name_of_thread) != 0; i++) {
+    }
+    if (i == amount_of_thread_names && amount_of_thread_names < MAX_TRACE_THREADS) {
+        names_of_threads[amount_of_thread_names++] = name_of_thread;
+    }
+    /* The key holds the place of the name, its index is the id of the thread */
+    if (i < amount_of_thread_names) {
+        pthread_setspecific(key_of_thread_id, &names_of_threads[i]);
+    }
+    pthread_mutex_unlock(&lock_of_trace);
+}
+
+/*
+ * Finds the offset of the name of a file in the names of the trace, and adds it if it is not the name of the last event.
+ *
+ * The lock of the trace is held by the caller.
+ *
+ * @param name_of_file The name of the file, or NULL.
+ * @return The offset of the name, 0 if there is no name or on memory allocation error.
+ */
+static size_t offset_of_file_name(const char *name_of_file) {
+    size_t offset;
+
+    if (name_of_file == NULL) {
+        return 0;
+    }
+    if (strcmp(names_of_files.text + offset_of_last_file, name_of_file) == 0) {
+        return offset_of_last_file;
+    }
+    offset = names_of_files.length;
+    /* A longer name is cut, the trace only shows it */
+    if (!append_output_text(&names_of_files, "%.*s", MAX_LENGTH_OF_TRACE_NAME, name_of_file)) {
+        names_of_files.length = offset;
+        return 0;
+    }
+    names_of_files.length++;
+    offset_of_last_file = offset;
+    return offset;
+}
+
+/*
+ * Adds an event to the trace.
+ *
+ * @param phase 'X' for a span or 'C' for a counter.
+ * @param name The name of the event, a string literal.
+ * @param name_of_file The file the event belongs to, or NULL.
+ * @param start The time of the event.
+ * @param duration The length of a span.
+ * @param value The value of a counter.
+ */
+static void add_trace_event(char phase, const char *name, const char *name_of_file, double start, double duration, long value) {
+    struct trace_event *bigger_events;
+    struct trace_event *event;
+    const char **name_of_thread;
+    size_t new_capacity;
+
+    name_of_thread = (const char **)pthread_getspecific(key_of_thread_id);
+    pthread_mutex_lock(&lock_of_trace);
+    if (amount_of_events == capacity_of_events) {
+        new_capacity = capacity_of_events ? capacity_of_events * 2 : 1024;
+        bigger_events = (struct trace_event *)tracked_realloc(events, new_capacity * sizeof(struct trace_event), MEMORY_OUTPUTS);
+        if (bigger_events == NULL) {
+            /* The trace misses the event, the assembly goes on */
+            pthread_mutex_unlock(&lock_of_trace);
+            return;
+        }
+        events = bigger_events;
+        capacity_of_events = new_capacity;
+    }
+    event = &events[amount_of_events++];
+    event->phase = phase;
+    event->name = name;
+    event->offset_of_file = offset_of_file_name(name_of_file);
+    event->start = start;
+    event->duration = duration;
+    event->value = value;
+    event->id_of_thread = name_of_thread != NULL ? (int)(name_of_thread - names_of_threads) + 2 : 1;
+    pthread_mutex_unlock(&lock_of_trace);
+}
+
+/*
+ * Adds a span that ends now to the trace.
+ *
+ * @param name The name of the span, a string literal.
+ * @param name_of_file The file the span belongs to, or NULL. It is copied.
+ * @param start The time the span started, from trace_clock.
+ */
+void add_trace_span(const char *name, const char *name_of_file, double start) {
+    if (tracing) {
+        add_trace_event('X', name, name_of_file, start, trace_clock() - start, 0);
+    }
+}
+
+/*
+ * Adds the value of a counter to the trace.
+ *
+ * @param name The name of the counter, a string literal.
+ * @param value The value of the counter.
+ */
+void add_trace_counter(const char *name, long value) {
+    if (tracing) {
+        add_trace_event('C', name, NULL, trace_clock(), 0, value);
+    }
+}
+
+/*
+ * Appends a string to the text of the trace as a JSON string, with quotes and escaped characters.
+ *
+ * @param text A pointer to the text of the trace.
+ * @param str The string to append.
+ * @return 1 if the string was appended, 0 on memory allocation error.
+ */
+static int append_json_string(struct output_text *text, const char *str) {
+    char escaped[MAX_LENGTH_OF_TRACE_NAME * 6 + 3];
+    size_t length = 0;
+    size_t position;
+
+    escaped[length++] = '"';
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\') {
+            escaped[length++] = '\\';
+            escaped[length++] = *str;
+        } else if ((unsigned char)*str < 0x20) {
+            sprintf(escaped + length, "\\u%04x", (unsigned int)(unsigned char)*str);
+            length += 6;
+        } else {
+            escaped[length++] = *str;
+        }
+    }
+    escaped[length++] = '"';
+    escaped[length] = '\0';
+    /* The escaped name can be longer than a line of append_output_text */
+    for (position = 0; length - position > MAX_LENGTH_OF_OUTPUT_LINE; position += MAX_LENGTH_OF_OUTPUT_LINE) {
+        if (!append_output_text(text, "%.*s", MAX_LENGTH_OF_OUTPUT_LINE, escaped + position)) {
+            return 0;
+        }
+    }
+    return append_output_text(text, "%s", escaped + position);
+}
+
+/*
+ * Writes the events of the trace as a JSON trace file, in the trace event format that
+ * chrome://tracing and Perfetto read.
+ *
+ * @param name_of_file The name of the JSON file.
+ * @return 1 if the file was written, 0 otherwise.
+ */
+int write_trace(const char *name_of_file) {
+    struct output_text text = {0};
+    const struct trace_event *event;
+    int appended;
+    int written = 0;
+    size_t i;
+    int j;
+
+    if (!tracing) {
+        return 0;
+    }
+    pthread_mutex_lock(&lock_of_trace);
+    appended = append_output_text(&text, "{\"traceEvents\":[\n") &&
+               append_output_text(&text, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}}");
+    for (j = 0; appended && j < amount_of_thread_names; j++) {
+        appended = append_output_text(&text, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", j + 2, names_of_threads[j]);
+    }
+    for (i = 0; appended && i < amount_of_events; i++) {
+        event = &events[i];
+        appended = append_output_text(&text, ",\n{\"name\":\"%s\",\"cat\":\"assembler\",\"ph\":\"%c\",\"ts\":%.3f,", event->name, event->phase, event->start);
+        if (appended && event->phase == 'X') {
+            appended = append_output_text(&text, "\"dur\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"file\":", event->duration, event->id_of_thread) &&
+                       append_json_string(&text, names_of_files.text + event->offset_of_file) && append_output_text(&text, "}}");
+        } else if (appended) {
+            /* A counter has one series, its value */
+            appended = append_output_text(&text, "\"pid\":1,\"tid\":%d,\"args\":{\"%s\":%ld}}", event->id_of_thread, event->name, event->value);
+        }
+    }
+    pthread_mutex_unlock(&lock_of_trace);
+    if (appended && append_output_text(&text, "\n],\"displayTimeUnit\":\"ms\"}\n")) {
+        written = write_output_if_changed(name_of_file, &text);
+    }
+    free_output_text(&text);
+    return written;
+}
+
+/*
+ * Stops the trace and frees its events.
+ */
+void free_trace(void) {
+    if (!tracing) {
+        return;
+    }
+    tracing = 0;
+    tracked_free(events);
+    events = NULL;
+    amount_of_events = 0;
+    capacity_of_events = 0;
+    free_output_text(&names_of_files);
+    offset_of_last_file = 0;
+    amount_of_thread_names = 0;
+    pthread_key_delete(key_of_thread_id);
+}
@@ -0,0 +1,76 @@
+#ifndef __TRACE_EVENTS_H_
+#define __TRACE_EVENTS_H_
+
+#include "common.h"
+
+#define MAX_TRACE_THREADS 16
+#define MAX_LENGTH_OF_TRACE_NAME 200
+
+/* Represents a span or a counter of the trace, the names of the events are string literals */
+struct trace_event {
+    const char *name; /* The name of the span or the counter */
+    size_t offset_of_file; /* The offset of the name of the file the event belongs to in the names of the trace */
+    double start; /* The time the span started or the counter was taken, in microseconds from the start of the trace */
+    double duration; /* The length of the span in microseconds, 0 for a counter */
+    long value; /* The value of a counter */
+    int id_of_thread; /* The thread the event happened in, 1 for the main thread */
+    char phase; /* 'X' for a span and 'C' for a counter, as in the trace event format */
+};
+
+/*
+ * Starts to record the trace events of the run.
+ *
+ * The events are kept in memory until write_trace, so recording one costs a lock and a copy.
+ * Until the trace is started, every function of the trace returns right away.
+ */
+void start_trace(void);
+
+/*
+ * Reads the clock of the trace.
+ *
+ * @return The time in microseconds from the start of the trace, 0 if the trace wasn't started.
+ */
+double trace_clock(void);
+
+/*
+ * Gives the calling thread a name in the trace.
+ *
+ * Threads with the same name share their row of the trace, so the threads that are started again for every
+ * file don't add rows. A thread without a name belongs to the main thread.
+ *
+ * @param name_of_thread The name of the thread, a string literal.
+ */
+void name_trace_thread(const char *name_of_thread);
+
+/*
+ * Adds a span that ends now to the trace.
+ *
+ * @param name The name of the span, a string literal.
+ * @param name_of_file The file the span belongs to, or NULL. It is copied.
+ * @param start The time the span started, from trace_clock.
+ */
+void add_trace_span(const char *name, const char *name_of_file, double start);
+
+/*
+ * Adds the value of a counter to the trace.
+ *
+ * @param name The name of the counter, a string literal.
+ * @param value The value of the counter.
+ */
+void add_trace_counter(const char *name, long value);
+
+/*
+ * Writes the events of the trace as a JSON trace file, in the trace event format that
+ * chrome://tracing and Perfetto read.
+ *
+ * @param name_of_file The name of the JSON file.
+ * @return 1 if the file was written, 0 otherwise.
+ */
+int write_trace(const char *name_of_file);
+
+/*
+ * Stops the trace and frees its events.
+ */
+void free_trace(void);
+
+#endif
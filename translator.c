@@ -0,0 +1,616 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "translator.h"
+#include "linked_list.h"
+#include "interner.h"
+#include "input_files.h"
+
+/*
+ * Finds the fault that reading an operand always causes, regardless of the state of the machine.
+ *
+ * @param instruction A pointer to the decoded instruction.
+ * @param index The index of the operand (0 for source, 1 for destination).
+ * @return The message of the fault, or NULL if the operand can be read.
+ */
+static const char *static_read_fault(const struct decoded_instruction *instruction, int index) {
+    switch (instruction->operand_mode[index]) {
+        case mmn14_ast_operand_opt_constant_number: case mmn14_ast_operand_opt_operand_register:
+            return NULL;
+        case mmn14_ast_operand_opt_operand_label:
+            return (instruction->operand_word[index] & 3) == 1 ? FAULT_EXTERNAL_SYMBOL : NULL;
+        default:
+            return FAULT_INVALID_OPERAND;
+    }
+}
+
+/*
+ * Finds the fault that writing to an operand always causes, regardless of the state of the machine.
+ *
+ * @param instruction A pointer to the decoded instruction.
+ * @param index The index of the operand (0 for source, 1 for destination).
+ * @param code_end The address right after the last code word.
+ * @return The message of the fault, or NULL if the operand can be written.
+ */
+static const char *static_write_fault(const struct decoded_instruction *instruction, int index, unsigned int code_end) {
+    unsigned int address;
+
+    switch (instruction->operand_mode[index]) {
+        case mmn14_ast_operand_opt_operand_register:
+            return NULL;
+        case mmn14_ast_operand_opt_operand_label:
+            if ((instruction->operand_word[index] & 3) == 1) {
+                return FAULT_EXTERNAL_SYMBOL;
+            }
+            address = instruction->operand_word[index] >> 2;
+            return (address >= BEGINNING_ADDRESS && address < code_end) ? FAULT_WRITE_TO_CODE : NULL;
+        default:
+            return FAULT_INVALID_OPERAND;
+    }
+}
+
+/*
+ * Finds the fault that computing the target of a jump always causes.
+ *
+ * @param instruction A pointer to the decoded instruction.
+ * @param index The index of the operand that holds the target.
+ * @return The message of the fault, or NULL if the target can be computed.
+ */
+static const char *static_jump_fault(const struct decoded_instruction *instruction, int index) {
+    switch (instruction->operand_mode[index]) {
+        case mmn14_ast_operand_opt_operand_register:
+            return NULL;
+        case mmn14_ast_operand_opt_operand_label:
+            return (instruction->operand_word[index] & 3) == 1 ? FAULT_EXTERNAL_SYMBOL : NULL;
+        default:
+            return FAULT_INVALID_OPERAND;
+    }
+}
+
+/*
+ * Prints the C expression that holds the value of an operand.
+ *
+ * @param c_file The file the C program is written to.
+ * @param instruction A pointer to the decoded instruction.
+ * @param index The index of the operand (0 for source, 1 for destination).
+ */
+static void print_operand(FILE *c_file, const struct decoded_instruction *instruction, int index) {
+    unsigned int word = instruction->operand_word[index];
+    unsigned int value;
+
+    switch (instruction->operand_mode[index]) {
+        case mmn14_ast_operand_opt_constant_number:
+            /* The constant is stored as a signed 10 bit number */
+            value = (word >> 2) & 0x3FF;
+            if (value & 0x200) {
+                value |= 0xC00;
+            }
+            fprintf(c_file, "0x%03XU", value);
+            break;
+        case mmn14_ast_operand_opt_operand_label:
+            fprintf(c_file, "mem[%u]", word >> 2);
+            break;
+        default:
+            fprintf(c_file, "r[%u]", (word >> (index == 0 ? 7 : 2)) & 0x7);
+            break;
+    }
+}
+
+/*
+ * Prints a C statement that makes the program continue at a given address.
+ *
+ * @param c_file The file the C program is written to.
+ * @param target The address to continue at.
+ * @param leaders Marks the addresses that start a basic block.
+ */
+static void print_goto(FILE *c_file, unsigned int target, const unsigned char *leaders) {
+    if (target < MEMORY_SIZE && leaders[target]) {
+        fprintf(c_file, "goto a%u;", target);
+    } else {
+        fprintf(c_file, "fault(\"%s\", %uU);", FAULT_INVALID_PROGRAM_COUNTER, target);
+    }
+}
+
+/*
+ * Prints the C statements of one instruction.
+ *
+ * @param c_file The file the C program is written to.
+ * @param instruction A pointer to the decoded instruction.
+ * @param machine A pointer to the loaded machine, used for the layout of the memory.
+ * @param leaders Marks the addresses that start a basic block.
+ */
+static void print_instruction(FILE *c_file, const struct decoded_instruction *instruction, const struct machine_state *machine, const unsigned char *leaders) {
+    const char *fault = NULL;
+    int operand = single_operand_index(instruction);
+    unsigned int next = instruction->address + instruction->number_of_words;
+
+    fprintf(c_file, "    step(%uU);\n", instruction->address);
+
+    /* Find the faults that do not depend on the state of the machine, in the order the emulator meets them */
+    switch (instruction->opcode) {
+        case mmn14_ast_instruction_mov:
+            if (!(fault = static_read_fault(instruction, 0))) {
+                fault = static_write_fault(instruction, 1, machine->code_end);
+            }
+            break;
+        case mmn14_ast_instruction_cmp:
+            if (!(fault = static_read_fault(instruction, 0))) {
+                fault = static_read_fault(instruction, 1);
+            }
+            break;
+        case mmn14_ast_instruction_add: case mmn14_ast_instruction_sub:
+            if (!(fault = static_read_fault(instruction, 0)) && !(fault = static_read_fault(instruction, 1))) {
+                fault = static_write_fault(instruction, 1, machine->code_end);
+            }
+            break;
+        case mmn14_ast_instruction_lea:
+            if (instruction->operand_mode[0] != mmn14_ast_operand_opt_operand_label) {
+                fault = FAULT_INVALID_OPERAND;
+            } else if ((instruction->operand_word[0] & 3) == 1) {
+                fault = FAULT_EXTERNAL_SYMBOL;
+            } else {
+                fault = static_write_fault(instruction, 1, machine->code_end);
+            }
+            break;
+        case mmn14_ast_instruction_clr:
+            fault = static_write_fault(instruction, operand, machine->code_end);
+            break;
+        case mmn14_ast_instruction_not: case mmn14_ast_instruction_inc: case mmn14_ast_instruction_dec:
+            if (!(fault = static_read_fault(instruction, operand))) {
+                fault = static_write_fault(instruction, operand, machine->code_end);
+            }
+            break;
+        case mmn14_ast_instruction_jmp: case mmn14_ast_instruction_bne: case mmn14_ast_instruction_jsr:
+            fault = static_jump_fault(instruction, operand);
+            break;
+        case mmn14_ast_instruction_red:
+            /* The character is read before the write fails */
+            if ((fault = static_write_fault(instruction, operand, machine->code_end))) {
+                fprintf(c_file, "    (void)getchar();\n");
+            }
+            break;
+        case mmn14_ast_instruction_prn:
+            fault = static_read_fault(instruction, operand);
+            break;
+    }
+    if (fault) {
+        fprintf(c_file, "    fault(\"%s\", %uU);\n", fault, instruction->address);
+        return;
+    }
+
+    switch (instruction->opcode) {
+        case mmn14_ast_instruction_mov:
+            fprintf(c_file, "    ");
+            print_operand(c_file, instruction, 1);
+            fprintf(c_file, " = ");
+            print_operand(c_file, instruction, 0);
+            fprintf(c_file, ";\n");
+            break;
+        case mmn14_ast_instruction_cmp:
+            fprintf(c_file, "    z = ((");
+            print_operand(c_file, instruction, 0);
+            fprintf(c_file, " - ");
+            print_operand(c_file, instruction, 1);
+            fprintf(c_file, ") & WORD_MASK) == 0;\n");
+            break;
+        case mmn14_ast_instruction_add: case mmn14_ast_instruction_sub:
+            fprintf(c_file, "    ");
+            print_operand(c_file, instruction, 1);
+            fprintf(c_file, " = (");
+            print_operand(c_file, instruction, 1);
+            fprintf(c_file, instruction->opcode == mmn14_ast_instruction_add ? " + " : " - ");
+            print_operand(c_file, instruction, 0);
+            fprintf(c_file, ") & WORD_MASK;\n");
+            break;
+        case mmn14_ast_instruction_lea:
+            fprintf(c_file, "    ");
+            print_operand(c_file, instruction, 1);
+            fprintf(c_file, " = %uU;\n", instruction->operand_word[0] >> 2);
+            break;
+        case mmn14_ast_instruction_not: case mmn14_ast_instruction_clr:
+        case mmn14_ast_instruction_inc: case mmn14_ast_instruction_dec:
+            fprintf(c_file, "    ");
+            print_operand(c_file, instruction, operand);
+            if (instruction->opcode == mmn14_ast_instruction_clr) {
+                fprintf(c_file, " = 0;\n");
+            } else {
+                fprintf(c_file, " = (%s", instruction->opcode == mmn14_ast_instruction_not ? "~" : "");
+                print_operand(c_file, instruction, operand);
+                fprintf(c_file, "%s) & WORD_MASK;\n", instruction->opcode == mmn14_ast_instruction_inc ? " + 1" :
+                                                      instruction->opcode == mmn14_ast_instruction_dec ? " - 1" : "");
+            }
+            break;
+        case mmn14_ast_instruction_jmp: case mmn14_ast_instruction_bne: case mmn14_ast_instruction_jsr:
+            fprintf(c_file, "    ");
+            if (instruction->opcode == mmn14_ast_instruction_bne) {
+                fprintf(c_file, "if (!z) { ");
+            } else if (instruction->opcode == mmn14_ast_instruction_jsr) {
+                fprintf(c_file, "if (sp == EMULATOR_STACK_SIZE) fault(\"%s\", %uU); stk[sp++] = %uU; ", FAULT_STACK_OVERFLOW, instruction->address, next);
+            }
+            if (instruction->operand_mode[operand] == mmn14_ast_operand_opt_operand_label) {
+                print_goto(c_file, instruction->operand_word[operand] >> 2, leaders);
+            } else {
+                fprintf(c_file, "pc = ");
+                print_operand(c_file, instruction, operand);
+                fprintf(c_file, "; goto dispatch;");
+            }
+            fprintf(c_file, "%s\n", instruction->opcode == mmn14_ast_instruction_bne ? " }" : "");
+            break;
+        case mmn14_ast_instruction_red:
+            fprintf(c_file, "    c = getchar();\n    ");
+            print_operand(c_file, instruction, operand);
+            fprintf(c_file, " = c == EOF ? WORD_MASK : ((unsigned int)c & WORD_MASK);\n");
+            break;
+        case mmn14_ast_instruction_prn:
+            fprintf(c_file, "    printf(\"%%d\\n\", sx(");
+            print_operand(c_file, instruction, operand);
+            fprintf(c_file, "));\n");
+            break;
+        case mmn14_ast_instruction_rts:
+            fprintf(c_file, "    if (sp == 0) fault(\"%s\", %uU);\n", FAULT_STACK_UNDERFLOW, instruction->address);
+            fprintf(c_file, "    pc = stk[--sp];\n    goto dispatch;\n");
+            break;
+        case mmn14_ast_instruction_stop:
+            fprintf(c_file, "    fflush(stdout);\n    return 0;\n");
+            break;
+    }
+}
+
+/*
+ * Marks the addresses that start a basic block of the code image.
+ *
+ * A block starts at the beginning of the code, at every code label, at every target of a
+ * jump with a label operand and after every instruction that changes the flow of the program.
+ * When the program jumps through a register, every instruction starts a block.
+ *
+ * @param obj_file A pointer to the object file.
+ * @param machine A pointer to the loaded machine.
+ * @param leaders Marks the addresses that start a basic block.
+ * @return 1 if the program needs the dispatch switch, 0 otherwise.
+ */
+static int find_basic_blocks(const struct object_file *obj_file, const struct machine_state *machine, unsigned char *leaders) {
+    struct decoded_instruction instruction;
+    SymbolNode *current_node;
+    unsigned int address;
+    unsigned int target;
+    int operand;
+    int jumps_through_register = 0;
+    int uses_dispatch = 0;
+
+    memset(leaders, 0, MEMORY_SIZE);
+    leaders[BEGINNING_ADDRESS] = machine->instruction_start[BEGINNING_ADDRESS];
+
+    /* Every code label starts a block */
+    for (current_node = obj_file->table_of_symbols ? obj_file->table_of_symbols->head : NULL; current_node; current_node = current_node->next) {
+        address = current_node->symbol_data->address_of_symbol;
+        if ((current_node->symbol_data->type_of_symbol == symbol_code || current_node->symbol_data->type_of_symbol == symbol_entry_code) &&
+            address < MEMORY_SIZE && machine->instruction_start[address]) {
+            leaders[address] = 1;
+        }
+    }
+
+    for (address = BEGINNING_ADDRESS; address < machine->code_end && machine->instruction_start[address]; address += instruction.number_of_words) {
+        decode_instruction(machine->memory, address, machine->code_end, &instruction);
+        operand = single_operand_index(&instruction);
+        switch (instruction.opcode) {
+            case mmn14_ast_instruction_jmp: case mmn14_ast_instruction_bne: case mmn14_ast_instruction_jsr:
+                if (instruction.operand_mode[operand] == mmn14_ast_operand_opt_operand_label) {
+                    target = instruction.operand_word[operand] >> 2;
+                    if (target < MEMORY_SIZE && machine->instruction_start[target]) {
+                        leaders[target] = 1;
+                    }
+                } else if (instruction.operand_mode[operand] == mmn14_ast_operand_opt_operand_register) {
+                    jumps_through_register = 1;
+                }
+                /* Fall through, the next instruction starts a block */
+            case mmn14_ast_instruction_rts: case mmn14_ast_instruction_stop:
+                if (instruction.opcode == mmn14_ast_instruction_rts) {
+                    /* The return address is only known when the program runs */
+                    uses_dispatch = 1;
+                }
+                if (address + instruction.number_of_words < machine->code_end) {
+                    leaders[address + instruction.number_of_words] = 1;
+                }
+                break;
+        }
+    }
+
+    if (jumps_through_register) {
+        /* A register may hold the address of any instruction */
+        memcpy(leaders, machine->instruction_start, MEMORY_SIZE);
+        uses_dispatch = 1;
+    }
+    return uses_dispatch;
+}
+
+/*
+ * Translates the code image of an object file to a C program.
+ *
+ * Every label and every branch target of the code image starts a basic block with a C label,
+ * jmp, bne and jsr with a label operand become direct gotos, and rts and jumps through a register
+ * go through a switch over the block addresses. All arithmetic is done on 12 bit words, and
+ * faults are reported with the same messages the emulator uses, so the output of the compiled
+ * program matches the output of the emulator.
+ *
+ * @param c_file The file the C program is written to.
+ * @param obj_file A pointer to the object file to translate.
+ * @param name_of_module The name of the module, used in the comments of the C program.
+ * @return 1 if the translation was successful, 0 otherwise.
+ */
+int translate_object_file(FILE *c_file, const struct object_file *obj_file, const char *name_of_module) {
+    static struct machine_state machine;
+    static unsigned char leaders[MEMORY_SIZE];
+    struct decoded_instruction instruction;
+    SymbolNode *current_node;
+    unsigned int address;
+    unsigned int memory_end;
+    int uses_dispatch;
+
+    if (!emulator_load(&machine, obj_file)) {
+        fprintf(stderr, "%s: the program does not fit in the memory\n", name_of_module);
+        return 0;
+    }
+    uses_dispatch = find_basic_blocks(obj_file, &machine, leaders);
+    memory_end = machine.code_end + obj_file->DC;
+
+    /* The runtime of the translated program */
+    fprintf(c_file, "/* C translation of %s, generated by the assembler */\n", name_of_module);
+    fprintf(c_file, "#include <stdio.h>\n#include <stdlib.h>\n\n");
+    fprintf(c_file, "#define WORD_MASK 0x%XU\n#define EMULATOR_STACK_SIZE %d\n#define EMULATOR_MAX_STEPS %ldL\n\n", WORD_MASK, EMULATOR_STACK_SIZE, EMULATOR_MAX_STEPS);
+    fprintf(c_file, "static unsigned int mem[%d] = {", MEMORY_SIZE);
+    for (address = 0; address < memory_end; address++) {
+        fprintf(c_file, "%s0x%03XU", address % 12 == 0 ? "\n    " : " ", machine.memory[address]);
+        if (address + 1 < memory_end) {
+            fprintf(c_file, ",");
+        }
+    }
+    fprintf(c_file, "\n};\n");
+    fprintf(c_file, "static unsigned int r[8];\nstatic unsigned int stk[EMULATOR_STACK_SIZE];\nstatic int sp;\nstatic int z;\nstatic long steps;\n\n");
+    fprintf(c_file, "static void fault(const char *message, unsigned int address) {\n");
+    fprintf(c_file, "    printf(\"fault: %%s at address %%u\\n\", message, address);\n    exit(1);\n}\n\n");
+    fprintf(c_file, "static void step(unsigned int address) {\n");
+    fprintf(c_file, "    if (++steps > EMULATOR_MAX_STEPS) fault(\"%s\", address);\n}\n\n", FAULT_STEP_LIMIT);
+    fprintf(c_file, "static int sx(unsigned int word) {\n");
+    fprintf(c_file, "    return (word & 0x800U) ? (int)word - 0x1000 : (int)word;\n}\n\n");
+
+    fprintf(c_file, "int main(void) {\n    unsigned int pc = %uU;\n    int c = 0;\n    (void)pc; (void)c;\n", BEGINNING_ADDRESS);
+    if (!machine.instruction_start[BEGINNING_ADDRESS]) {
+        fprintf(c_file, "    fault(\"%s\", %uU);\n", FAULT_INVALID_PROGRAM_COUNTER, BEGINNING_ADDRESS);
+    }
+
+    /* One basic block per label, the instructions in between fall through */
+    for (address = BEGINNING_ADDRESS; address < machine.code_end && machine.instruction_start[address]; address += instruction.number_of_words) {
+        decode_instruction(machine.memory, address, machine.code_end, &instruction);
+        if (leaders[address]) {
+            fprintf(c_file, "a%u:", address);
+            for (current_node = obj_file->table_of_symbols ? obj_file->table_of_symbols->head : NULL; current_node; current_node = current_node->next) {
+                if (current_node->symbol_data->address_of_symbol == address &&
+                    (current_node->symbol_data->type_of_symbol == symbol_code || current_node->symbol_data->type_of_symbol == symbol_entry_code)) {
+                    fprintf(c_file, " /* %s */", name_of_symbol_id(&obj_file->interned_symbols, current_node->symbol_data->id_of_symbol));
+                }
+            }
+            fprintf(c_file, "\n");
+        }
+        print_instruction(c_file, &instruction, &machine, leaders);
+    }
+    /* Running past the last instruction */
+    fprintf(c_file, "    fault(\"%s\", %uU);\n", FAULT_INVALID_PROGRAM_COUNTER, address);
+
+    if (uses_dispatch) {
+        fprintf(c_file, "dispatch:\n    switch (pc) {\n");
+        for (address = BEGINNING_ADDRESS; address < machine.code_end; address++) {
+            if (leaders[address]) {
+                fprintf(c_file, "        case %uU: goto a%u;\n", address, address);
+            }
+        }
+        fprintf(c_file, "        default: fault(\"%s\", pc);\n    }\n", FAULT_INVALID_PROGRAM_COUNTER);
+    }
+    fprintf(c_file, "    return 1;\n}\n");
+    return 1;
+}
+
+/*
+ * Writes the C translation of an object file to the .c file of the module.
+ *
+ * @param name_of_module The base name of the module.
+ * @param obj_file A pointer to the object file to translate.
+ * @return 1 if the .c file was written successfully, 0 otherwise.
+ */
+int output_c_file(const char *name_of_module, const struct object_file *obj_file) {
+    char *c_name_of_file;
+    FILE *c_file;
+    int result;
+
+    c_name_of_file = create_output_file_name(name_of_module, FILE_EXTENSION_C);
+    if (c_name_of_file == NULL) {
+        return 0;
+    }
+    c_file = fopen(c_name_of_file, "w");
+    if (c_file == NULL) {
+        fprintf(stderr, "wasn't able to open file: %s\n", c_name_of_file);
+        tracked_free(c_name_of_file);
+        return 0;
+    }
+    result = translate_object_file(c_file, obj_file, name_of_module);
+    fclose(c_file);
+    tracked_free(c_name_of_file);
+    return result;
+}
+
+/*
+ * Compares the content of two files.
+ *
+ * @param first_name The name of the first file.
+ * @param second_name The name of the second file.
+ * @return 1 if both files exist and have the same content, 0 otherwise.
+ */
+static int files_are_identical(const char *first_name, const char *second_name) {
+    FILE *first = fopen(first_name, "r");
+    FILE *second = fopen(second_name, "r");
+    int first_char;
+    int second_char;
+    int identical = first != NULL && second != NULL;
+
+    while (identical) {
+        first_char = getc(first);
+        second_char = getc(second);
+        if (first_char != second_char) {
+            identical = 0;
+        } else if (first_char == EOF) {
+            break;
+        }
+    }
+    if (first) fclose(first);
+    if (second) fclose(second);
+    return identical;
+}
+
+/*
+ * Runs a program and waits for it, without a shell, so the names of the files are passed as they are.
+ *
+ * @param arguments The program and its arguments, ending with NULL. The program is searched in the PATH
+ *        if its name has no directory.
+ * @param name_of_input The file the standard input of the program is read from, or NULL to keep it.
+ * @param name_of_output The file the standard output of the program is written to, or NULL to keep it.
+ * @return The exit status of the program, or -1 if it couldn't be run or didn't exit.
+ */
+static int run_program(char *const arguments[], const char *name_of_input, const char *name_of_output) {
+    pid_t child;
+    int status;
+    int descriptor;
+
+    fflush(stdout);
+    child = fork();
+    if (child < 0) {
+        return -1;
+    }
+    if (child == 0) {
+        if (name_of_input != NULL) {
+            descriptor = open(name_of_input, O_RDONLY);
+            if (descriptor < 0 || dup2(descriptor, STDIN_FILENO) < 0) {
+                _exit(127);
+            }
+            close(descriptor);
+        }
+        if (name_of_output != NULL) {
+            descriptor = open(name_of_output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (descriptor < 0 || dup2(descriptor, STDOUT_FILENO) < 0) {
+                _exit(127);
+            }
+            close(descriptor);
+        }
+        execvp(arguments[0], arguments);
+        _exit(127);
+    }
+    while (waitpid(child, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+/*
+ * Runs the differential test of a module.
+ *
+ * The program is run in the emulator, and the .c translation of it is compiled with the host
+ * compiler (the CC environment variable, or cc) and run. Both runs read the .in file next to the
+ * source file if there is one, or an empty input. The outputs of both runs are compared and the result is printed.
+ *
+ * @param name_of_module The base name of the module, its .c file must already be written.
+ * @param obj_file A pointer to the object file of the module.
+ * @return 1 if both outputs are identical, 0 otherwise.
+ */
+int differential_test(const char *name_of_module, const struct object_file *obj_file) {
+    static struct machine_state machine;
+    char *c_name_of_file = create_output_file_name(name_of_module, FILE_EXTENSION_C);
+    char *emulator_output_name = create_output_file_name(name_of_module, FILE_EXTENSION_EMULATOR_OUTPUT);
+    char *native_name = create_output_file_name(name_of_module, FILE_EXTENSION_NATIVE);
+    char *native_output_name = create_output_file_name(name_of_module, FILE_EXTENSION_NATIVE_OUTPUT);
+    char *input_name = create_file_name(name_of_module, FILE_EXTENSION_INPUT);
+    const char *name_of_input = NULL;
+    const char *compiler = getenv("CC");
+    char *words_of_compiler = NULL;
+    char *command[MAX_WORDS_OF_COMPILER + 5];
+    char *native_path = NULL;
+    int amount_of_words = 0;
+    char *word;
+    FILE *input = NULL;
+    FILE *output = NULL;
+    int passed = 0;
+
+    if (!c_name_of_file || !emulator_output_name || !native_name || !native_output_name || !input_name) {
+        goto cleanup;
+    }
+    if (compiler == NULL || *compiler == '\0') {
+        compiler = DEFAULT_HOST_COMPILER;
+    }
+    words_of_compiler = tracked_strdup(compiler, MEMORY_OUTPUTS);
+    native_path = tracked_malloc(strlen(native_name) + 3, MEMORY_OUTPUTS);
+    if (words_of_compiler == NULL || native_path == NULL) {
+        fprintf(stderr, "wasn't able to allocate memory for the differential test\n");
+        goto cleanup;
+    }
+    /* Both runs read the same input, an empty one if the module has no .in file */
+    name_of_input = input_name;
+    input = fopen(name_of_input, "r");
+    if (input == NULL) {
+        name_of_input = "/dev/null";
+        input = fopen(name_of_input, "r");
+    }
+
+    /* Run the program in the emulator */
+    output = fopen(emulator_output_name, "w");
+    if (!input || !output || !emulator_load(&machine, obj_file)) {
+        fprintf(stderr, "%s: wasn't able to run the program in the emulator\n", name_of_module);
+        goto cleanup;
+    }
+    emulator_run(&machine, input, output, EMULATOR_MAX_STEPS);
+    fclose(output);
+    output = NULL;
+
+    /* Compile the translation, CC may hold flags after the compiler like in make, the names are passed as they are */
+    for (word = strtok(words_of_compiler, " \t"); word != NULL && amount_of_words < MAX_WORDS_OF_COMPILER; word = strtok(NULL, " \t")) {
+        command[amount_of_words++] = word;
+    }
+    command[amount_of_words++] = "-O2";
+    command[amount_of_words++] = "-o";
+    command[amount_of_words++] = native_name;
+    command[amount_of_words++] = c_name_of_file;
+    command[amount_of_words] = NULL;
+    if (run_program(command, NULL, NULL) != 0) {
+        fprintf(stderr, "%s: wasn't able to compile %s\n", name_of_module, c_name_of_file);
+        goto cleanup;
+    }
+    /* A name without a directory would be searched in the PATH */
+    sprintf(native_path, "%s%s", strchr(native_name, '/') != NULL ? "" : "./", native_name);
+    command[0] = native_path;
+    command[1] = NULL;
+    run_program(command, name_of_input, native_output_name);
+
+    passed = files_are_identical(emulator_output_name, native_output_name);
+    printf("%s: differential test %s\n", name_of_module, passed ? "passed" : "failed");
+    if (passed) {
+        remove(emulator_output_name);
+        remove(native_output_name);
+    }
+    remove(native_name);
+
+cleanup:
+    if (input) fclose(input);
+    if (output) fclose(output);
+    tracked_free(words_of_compiler);
+    tracked_free(native_path);
+    tracked_free(c_name_of_file);
+    tracked_free(emulator_output_name);
+    tracked_free(native_name);
+    tracked_free(native_output_name);
+    tracked_free(input_name);
+    return passed;
+}
@@ -0,0 +1,54 @@
+#ifndef __TRANSLATOR_H_
+#define __TRANSLATOR_H_
+
+#include <stdio.h>
+#include "common.h"
+#include "emulator.h"
+
+#define FILE_EXTENSION_C ".c"
+#define FILE_EXTENSION_EMULATOR_OUTPUT ".emu.out"
+#define FILE_EXTENSION_NATIVE ".native"
+#define FILE_EXTENSION_NATIVE_OUTPUT ".native.out"
+#define FILE_EXTENSION_INPUT ".in"
+#define DEFAULT_HOST_COMPILER "cc"
+#define MAX_WORDS_OF_COMPILER 32
+
+/*
+ * Translates the code image of an object file to a C program.
+ *
+ * Every label and every branch target of the code image starts a basic block with a C label,
+ * jmp, bne and jsr with a label operand become direct gotos, and rts and jumps through a register
+ * go through a switch over the block addresses. All arithmetic is done on 12 bit words, and
+ * faults are reported with the same messages the emulator uses, so the output of the compiled
+ * program matches the output of the emulator.
+ *
+ * @param c_file The file the C program is written to.
+ * @param obj_file A pointer to the object file to translate.
+ * @param name_of_module The name of the module, used in the comments of the C program.
+ * @return 1 if the translation was successful, 0 otherwise.
+ */
+int translate_object_file(FILE *c_file, const struct object_file *obj_file, const char *name_of_module);
+
+/*
+ * Writes the C translation of an object file to the .c file of the module.
+ *
+ * @param name_of_module The base name of the module.
+ * @param obj_file A pointer to the object file to translate.
+ * @return 1 if the .c file was written successfully, 0 otherwise.
+ */
+int output_c_file(const char *name_of_module, const struct object_file *obj_file);
+
+/*
+ * Runs the differential test of a module.
+ *
+ * The program is run in the emulator, and the .c translation of it is compiled with the host
+ * compiler (the CC environment variable, or cc) and run. Both runs read the .in file next to the
+ * source file if there is one, or an empty input. The outputs of both runs are compared and the result is printed.
+ *
+ * @param name_of_module The base name of the module, its .c file must already be written.
+ * @param obj_file A pointer to the object file of the module.
+ * @return 1 if both outputs are identical, 0 otherwise.
+ */
+int differential_test(const char *name_of_module, const struct object_file *obj_file);
+
+#endif